@@ -8,7 +8,8 @@
 
 #include "protocols/ethernet.hpp"
 #include "protocols/arp.hpp"
-#include "net_stack/network_stack.hpp"
+#include "hal/free_function_hal.hpp"
+#include "net_stack/network_stack_impl.hpp"
 #include <vector>
 #include <cstdint>
 #include <cstring>
@@ -47,7 +48,9 @@ int main()
     }
     hal_timer_init();
 
-    net::NetworkStack stack(&netconfig);
+    // Drive the stack through the free-function HAL initialised above.
+    FreeFunctionHal hal;
+    net::BasicNetworkStack<FreeFunctionHal> stack(hal, &netconfig);
 
     uint32_t last_arp_request_ms = 0;
     const uint32_t ARP_REQUEST_INTERVAL_MS = 5000; // 2 seconds
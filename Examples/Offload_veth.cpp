@@ -0,0 +1,175 @@
+// Offload_veth.cpp : PACKET_VNET_HDR (GSO/GRO) on the veth test pair.
+//
+// rx: counts frames for a few seconds and reports how many arrived as
+//     GRO/GSO super-frames (run a bulk TCP transfer to 10.23.42.10 meanwhile).
+// tx: sends one ~60 KB TCP segment to the gateway with GSO and checksum
+//     offload; the kernel splits it into MTU-sized frames.
+// Usage: NET_IFACE=veth-host ./Offload_veth rx|tx
+// See testing_procedure.md ("Offload test").
+
+#include "hal/hal_timer.hpp"
+#include "hal/hal_logging.hpp"
+#include "hal/linux_raw_socket_hal.hpp"
+#include "protocols/ethernet.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+    constexpr uint32_t RX_SECONDS = 5;
+    constexpr size_t SUPER_FRAME_BYTES = 65536 + 14;
+    constexpr uint16_t TCP_MSS = 1448;
+    constexpr size_t TX_PAYLOAD_BYTES = 60000;
+
+    constexpr std::array<uint8_t, 6> HOST_MAC = {0xF4, 0x7B, 0x09, 0x51, 0x91, 0x63};
+    constexpr std::array<uint8_t, 6> GATEWAY_MAC = {0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0x01};
+    constexpr std::array<uint8_t, 4> HOST_IP = {10, 23, 42, 10};
+    constexpr std::array<uint8_t, 4> GATEWAY_IP = {10, 23, 42, 1};
+
+    // Large enough for a 64 KB GRO super-frame; static, not on the stack.
+    std::array<uint8_t, SUPER_FRAME_BYTES> g_frame;
+
+    void put16(uint8_t *p, uint16_t v)
+    {
+        p[0] = static_cast<uint8_t>(v >> 8);
+        p[1] = static_cast<uint8_t>(v);
+    }
+
+    uint32_t sum16(const uint8_t *p, size_t length, uint32_t sum = 0)
+    {
+        for (size_t i = 0; i + 1 < length; i += 2)
+        {
+            sum += static_cast<uint32_t>((p[i] << 8) | p[i + 1]);
+        }
+        if (length & 1)
+        {
+            sum += static_cast<uint32_t>(p[length - 1] << 8);
+        }
+        return sum;
+    }
+
+    uint16_t fold(uint32_t sum)
+    {
+        while (sum >> 16)
+        {
+            sum = (sum & 0xFFFF) + (sum >> 16);
+        }
+        return static_cast<uint16_t>(sum);
+    }
+
+    int run_rx(LinuxRawSocketHal &hal)
+    {
+        uint32_t frames = 0;
+        uint32_t super_frames = 0;
+        size_t largest = 0;
+
+        const uint32_t end_ms = hal_timer_get_ms() + RX_SECONDS * 1000;
+        while (static_cast<int32_t>(end_ms - hal_timer_get_ms()) > 0)
+        {
+            size_t length = hal.receive(g_frame.data(), g_frame.size());
+            if (length == 0)
+            {
+                hal.wait(100);
+                continue;
+            }
+            ++frames;
+            largest = length > largest ? length : largest;
+            const net::PacketOffload &offload = hal.last_rx_offload();
+            if (offload.gso != net::PacketOffload::Gso::NONE)
+            {
+                ++super_frames;
+                NET_LOG_DEBUG(HAL, "super-frame %zu bytes, gso_size %u, header %u",
+                              length, offload.gso_size, offload.header_bytes);
+            }
+        }
+
+        NET_LOG_INFO(HAL, "rx: %u frames, %u super-frames, largest %zu bytes, %u dropped as too large",
+                     frames, super_frames, largest, hal.rx_truncated());
+        return 0;
+    }
+
+    int run_tx(LinuxRawSocketHal &hal)
+    {
+        constexpr size_t ip_offset = sizeof(EthernetHeader);
+        constexpr size_t tcp_offset = ip_offset + 20;
+        constexpr size_t payload_offset = tcp_offset + 20;
+        constexpr size_t frame_length = payload_offset + TX_PAYLOAD_BYTES;
+        constexpr uint16_t ip_length = static_cast<uint16_t>(frame_length - ip_offset);
+
+        uint8_t *frame = g_frame.data();
+        std::memset(frame, 0, frame_length);
+
+        // Ethernet
+        std::memcpy(frame, GATEWAY_MAC.data(), 6);
+        std::memcpy(frame + 6, HOST_MAC.data(), 6);
+        put16(frame + 12, 0x0800);
+
+        // IPv4 (the kernel rewrites length/id/checksum per segment)
+        uint8_t *ip = frame + ip_offset;
+        ip[0] = 0x45;
+        put16(ip + 2, ip_length);
+        put16(ip + 6, 0x4000); // DF
+        ip[8] = 64;
+        ip[9] = 6; // TCP
+        std::memcpy(ip + 12, HOST_IP.data(), 4);
+        std::memcpy(ip + 16, GATEWAY_IP.data(), 4);
+        put16(ip + 10, static_cast<uint16_t>(~fold(sum16(ip, 20))));
+
+        // TCP to the discard port; the peer answers with RSTs, which is fine.
+        uint8_t *tcp = frame + tcp_offset;
+        put16(tcp, 40000);
+        put16(tcp + 2, 9);
+        tcp[12] = 5 << 4;
+        tcp[13] = 0x18; // PSH|ACK
+        put16(tcp + 14, 65535);
+        for (size_t i = 0; i < TX_PAYLOAD_BYTES; ++i)
+        {
+            frame[payload_offset + i] = static_cast<uint8_t>(i);
+        }
+
+        // Checksum offload: the field holds the pseudo-header sum.
+        uint32_t pseudo = sum16(ip + 12, 8);
+        pseudo += 6;
+        pseudo += static_cast<uint32_t>(ip_length - 20);
+        put16(tcp + 16, fold(pseudo));
+
+        net::PacketOffload offload;
+        offload.gso = net::PacketOffload::Gso::TCPV4;
+        offload.gso_size = TCP_MSS;
+        offload.header_bytes = static_cast<uint16_t>(payload_offset);
+        offload.needs_checksum = true;
+        offload.csum_start = static_cast<uint16_t>(tcp_offset);
+        offload.csum_offset = 16;
+
+        if (hal.send(frame, frame_length, offload) != 0)
+        {
+            return 1;
+        }
+        NET_LOG_INFO(HAL, "tx: sent one %zu-byte GSO frame (%zu segments of MSS %u)", frame_length,
+                     (TX_PAYLOAD_BYTES + TCP_MSS - 1) / TCP_MSS, TCP_MSS);
+        return 0;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const bool transmit = argc > 1 && std::strcmp(argv[1], "tx") == 0;
+
+    net::NetworkConfig config = {
+        .mac_address = HOST_MAC,
+        .ipv4_address = HOST_IP,
+        .gateway_address = GATEWAY_IP};
+
+    LinuxRawSocketHal hal;
+    if (hal.init(&config, NetworkFiltering::NONE) != 0 || hal.enable_offloads(true) != 0)
+    {
+        return 1;
+    }
+    hal_timer_init();
+
+    int rc = transmit ? run_tx(hal) : run_rx(hal);
+    hal.shutdown();
+    return rc;
+}
@@ -0,0 +1,530 @@
+// LoadTest.cpp : End-to-end load test of BasicNetworkStack::poll().
+//
+// A generator stack sends requests to a responder stack and matches the
+// replies, on one thread: send a burst, poll the generator (flushes its sends,
+// collects replies), poll the responder. Reported: requests sent, replies,
+// loss, request -> reply latency percentiles, and the time spent inside the
+// responder's poll() per frame, i.e. the pps ceiling of poll() on that link.
+// The last line (RESULT ...) is meant for comparing versions.
+//
+// Link (the in-memory one by default):
+//   memory                          both stacks on MemoryLinkHal: no syscalls, the stacks' own cost
+//   NET_IFACE=vb0 NET_PEER_IFACE=vb1  raw sockets on a veth pair (no IP addresses on it); the
+//                                   responder on NET_IFACE, the generator on NET_PEER_IFACE
+//   NET_IO_URING=<n>                veth only: both HALs on io_uring with n RX buffers
+// Load:
+//   LOAD_PROTOCOL=arp               what to send (ARP requests; the only one so far)
+//   LOAD_RATE_PPS=<pps>             offered rate; 0 (default) = as fast as the window allows
+//   LOAD_WINDOW=<n>                 requests in flight at most (default 256, up to 32768)
+//   LOAD_BURST=<n>                  requests sent between polls (default 32)
+//   LOAD_SECONDS=<s>                sending time (default 5)
+//   LOAD_TIMEOUT_MS=<ms>            a request unanswered this long is lost (default 100)
+
+#include "hal/hal_timer.hpp"
+#include "hal/linux_raw_socket_hal.hpp"
+#include "hal/memory_link_hal.hpp"
+#include "protocols/arp.hpp"
+#include "protocols/ethernet.hpp"
+#include "net_stack/byte_order.hpp"
+#include "net_stack/network_stack_impl.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr std::array<uint8_t, 4> RESPONDER_IP = {10, 99, 0, 1};
+    constexpr std::array<uint8_t, 4> GENERATOR_IP = {10, 99, 0, 2};
+    constexpr std::array<uint8_t, 6> RESPONDER_MAC = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+    constexpr std::array<uint8_t, 6> GENERATOR_MAC = {0x02, 0x00, 0x00, 0x00, 0x00, 0x02};
+    constexpr uint32_t MAX_WINDOW = 32768;
+
+    using MemoryLink = MemoryLinkHal<1024, 256>;
+
+    uint64_t now_ns()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // Unsigned value of an environment variable, or 'fallback' if unset/invalid.
+    uint32_t env_u32(const char *name, uint32_t fallback)
+    {
+        const char *value = std::getenv(name);
+        if (value == nullptr || *value == '\0')
+        {
+            return fallback;
+        }
+        char *end = nullptr;
+        unsigned long parsed = std::strtoul(value, &end, 10);
+        return (*end == '\0' && parsed <= UINT32_MAX) ? static_cast<uint32_t>(parsed) : fallback;
+    }
+
+    struct LoadConfig
+    {
+        uint32_t rate_pps = 0;
+        uint32_t window = 256;
+        uint32_t burst = 32;
+        uint32_t seconds = 5;
+        uint32_t timeout_ms = 100;
+    };
+
+    // Log-linear histogram: 16 buckets per power of two (within ~6%), no
+    // allocation per sample.
+    class LatencyHistogram
+    {
+    public:
+        void add(uint64_t ns)
+        {
+            ++m_counts[index(ns)];
+            ++m_samples;
+            m_max_ns = std::max(m_max_ns, ns);
+        }
+
+        void clear() { *this = LatencyHistogram{}; }
+        uint64_t samples() const { return m_samples; }
+        uint64_t max_ns() const { return m_max_ns; }
+
+        // Upper bound of the bucket holding the p-th fraction of the samples.
+        uint64_t percentile_ns(double p) const
+        {
+            const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(p * static_cast<double>(m_samples) + 0.999999));
+            uint64_t seen = 0;
+            for (size_t i = 0; i < BUCKETS; ++i)
+            {
+                seen += m_counts[i];
+                if (seen >= rank)
+                {
+                    return std::min(upper_bound(i), m_max_ns);
+                }
+            }
+            return m_max_ns;
+        }
+
+    private:
+        static constexpr unsigned SUB_BITS = 4;
+        static constexpr size_t BUCKETS = 64 << SUB_BITS;
+
+        static size_t index(uint64_t ns)
+        {
+            if (ns < (1u << SUB_BITS))
+            {
+                return static_cast<size_t>(ns);
+            }
+            const unsigned shift = static_cast<unsigned>(std::bit_width(ns)) - 1 - SUB_BITS;
+            return ((shift + 1) << SUB_BITS) + static_cast<size_t>((ns >> shift) & ((1u << SUB_BITS) - 1));
+        }
+
+        static uint64_t upper_bound(size_t index)
+        {
+            const size_t group = index >> SUB_BITS;
+            const uint64_t sub = index & ((1u << SUB_BITS) - 1);
+            if (group == 0)
+            {
+                return sub;
+            }
+            const unsigned shift = static_cast<unsigned>(group - 1);
+            return (((1u << SUB_BITS) + sub) << shift) + ((uint64_t{1} << shift) - 1);
+        }
+
+        std::array<uint64_t, BUCKETS> m_counts{};
+        uint64_t m_samples = 0;
+        uint64_t m_max_ns = 0;
+    };
+
+    // ARP requests for the responder's address. Request slot n comes from
+    // 10.99.128.0 + n, and the reply goes back to that address, so every
+    // reply names the request it answers.
+    struct ArpTraffic
+    {
+        static constexpr const char *name = "arp";
+        static constexpr size_t frame_bytes = sizeof(EthernetHeader) + sizeof(ArpPacket);
+        static constexpr uint32_t SOURCE_BASE = (10u << 24) | (99u << 16) | (128u << 8);
+
+        std::array<uint8_t, 6> generator_mac;
+
+        void build(std::span<std::byte, frame_bytes> frame, uint32_t slot) const
+        {
+            const uint32_t source = SOURCE_BASE + slot;
+            const std::array<uint8_t, 4> source_ip = {static_cast<uint8_t>(source >> 24), static_cast<uint8_t>(source >> 16),
+                                                      static_cast<uint8_t>(source >> 8), static_cast<uint8_t>(source)};
+            auto *eth = reinterpret_cast<EthernetHeader *>(frame.data());
+            auto *arp = reinterpret_cast<ArpPacket *>(frame.data() + sizeof(EthernetHeader));
+            std::memset(eth->destination_mac, 0xFF, MAC_ADDRESS_LENGTH);
+            std::memcpy(eth->source_mac, generator_mac.data(), MAC_ADDRESS_LENGTH);
+            eth->ethertype = net::net_htons16(ETHERTYPE_ARP);
+            arp->hardware_type = net::net_htons16(ARP_HW_TYPE_ETHERNET);
+            arp->protocol_type = net::net_htons16(ETHERTYPE_IPV4);
+            arp->hardware_addr_len = MAC_ADDRESS_LENGTH;
+            arp->protocol_addr_len = IPV4_ADDRESS_LENGTH;
+            arp->opcode = net::net_htons16(ARP_OPCODE_REQUEST);
+            std::memcpy(arp->sender_mac, generator_mac.data(), MAC_ADDRESS_LENGTH);
+            std::memcpy(arp->sender_ip, source_ip.data(), IPV4_ADDRESS_LENGTH);
+            std::memset(arp->target_mac, 0, MAC_ADDRESS_LENGTH);
+            std::memcpy(arp->target_ip, RESPONDER_IP.data(), IPV4_ADDRESS_LENGTH);
+        }
+
+        // Slot of the request a received frame answers, if it is a reply.
+        std::optional<uint32_t> reply_slot(std::span<const std::byte> frame, uint32_t window) const
+        {
+            if (frame.size() < frame_bytes)
+            {
+                return std::nullopt;
+            }
+            const auto *eth = reinterpret_cast<const EthernetHeader *>(frame.data());
+            const auto *arp = reinterpret_cast<const ArpPacket *>(frame.data() + sizeof(EthernetHeader));
+            if (net::net_ntohs16(eth->ethertype) != ETHERTYPE_ARP || net::net_ntohs16(arp->opcode) != ARP_OPCODE_REPLY ||
+                std::memcmp(arp->sender_ip, RESPONDER_IP.data(), IPV4_ADDRESS_LENGTH) != 0)
+            {
+                return std::nullopt;
+            }
+            const uint32_t target = (uint32_t{arp->target_ip[0]} << 24) | (uint32_t{arp->target_ip[1]} << 16) |
+                                    (uint32_t{arp->target_ip[2]} << 8) | arp->target_ip[3];
+            const uint32_t slot = target - SOURCE_BASE;
+            return slot < window ? std::optional<uint32_t>(slot) : std::nullopt;
+        }
+    };
+
+    // Requests in flight, one per slot, and what became of them.
+    class LoadState
+    {
+    public:
+        explicit LoadState(uint32_t window) : m_sent_ns(window, 0) {}
+
+        uint32_t window() const { return static_cast<uint32_t>(m_sent_ns.size()); }
+        bool in_flight(uint32_t slot) const { return m_sent_ns[slot] != 0; }
+        uint64_t sent_at(uint32_t slot) const { return m_sent_ns[slot]; }
+
+        void on_sent(uint32_t slot, uint64_t at_ns)
+        {
+            m_sent_ns[slot] = at_ns;
+            ++sent;
+            ++outstanding;
+        }
+
+        void on_lost(uint32_t slot)
+        {
+            m_sent_ns[slot] = 0;
+            ++lost;
+            --outstanding;
+        }
+
+        void on_reply(uint32_t slot, uint64_t at_ns)
+        {
+            if (m_sent_ns[slot] == 0)
+            {
+                ++late; // its request had already timed out (or a duplicate)
+                return;
+            }
+            const uint64_t latency_ns = at_ns - m_sent_ns[slot];
+            m_sent_ns[slot] = 0;
+            ++replies;
+            --outstanding;
+            total.add(latency_ns);
+            interval.add(latency_ns);
+        }
+
+        // Whatever is still in flight at the end never got its reply.
+        void expire_all()
+        {
+            for (uint32_t slot = 0; slot < window(); ++slot)
+            {
+                if (in_flight(slot))
+                {
+                    on_lost(slot);
+                }
+            }
+        }
+
+        uint64_t sent = 0;
+        uint64_t replies = 0;
+        uint64_t lost = 0;
+        uint64_t late = 0;
+        uint64_t stalled = 0;       // paced sends skipped: the window was full
+        uint64_t send_errors = 0;
+        uint64_t outstanding = 0;
+        LatencyHistogram total;
+        LatencyHistogram interval;  // since the last progress line
+
+    private:
+        std::vector<uint64_t> m_sent_ns;  // 0 = slot free
+    };
+
+    // Hands every frame the generator receives to the matcher; resumed from
+    // generator.poll().
+    template <typename Stack, typename Traffic>
+    net::Task collect_replies(Stack &stack, const Traffic &traffic, LoadState &state)
+    {
+        while (true)
+        {
+            const std::span<const std::byte> frame = co_await stack.next_frame();
+            if (const std::optional<uint32_t> slot = traffic.reply_slot(frame, state.window()))
+            {
+                state.on_reply(*slot, now_ns());
+            }
+        }
+    }
+
+    template <typename Hal>
+    uint64_t link_drops(const Hal &hal)
+    {
+        if constexpr (requires { hal.rx_drops(); })
+        {
+            return hal.rx_drops();
+        }
+        else
+        {
+            return 0;
+        }
+    }
+
+    template <typename Hal, typename Traffic>
+    int run(Hal &generator_hal, Hal &responder_hal, net::NetworkConfig &generator_config,
+            net::NetworkConfig &responder_config, const Traffic &traffic, const LoadConfig &load, const char *link)
+    {
+        using Stack = net::BasicNetworkStack<Hal>;
+        auto generator = std::make_unique<Stack>(generator_hal, &generator_config);
+        auto responder = std::make_unique<Stack>(responder_hal, &responder_config);
+
+        // The responder answers everything: we are measuring it, not its flood limits.
+        net::ArpPolicy answer_everything;
+        answer_everything.reply_rate_per_sec = 0;
+        answer_everything.per_source_rate_per_sec = 0;
+        responder->get_arp_cache().set_policy(answer_everything);
+
+        std::vector<std::array<std::byte, Traffic::frame_bytes>> frames(load.window);
+        for (uint32_t slot = 0; slot < load.window; ++slot)
+        {
+            traffic.build(frames[slot], slot);
+        }
+
+        LoadState state(load.window);
+        net::Task collector = collect_replies(*generator, traffic, state);
+        if (!collector.valid())
+        {
+            std::printf("no coroutine frame for the reply collector\n");
+            return 1;
+        }
+
+        std::printf("Load test: %s over %s, rate %s, window %u, burst %u, %u s\n", Traffic::name, link,
+                    load.rate_pps == 0 ? "max" : std::to_string(load.rate_pps).c_str(), load.window, load.burst,
+                    load.seconds);
+
+        const uint64_t timeout_ns = uint64_t{load.timeout_ms} * 1'000'000;
+        const uint64_t start_ns = now_ns();
+        const uint64_t stop_ns = start_ns + uint64_t{load.seconds} * 1'000'000'000;
+        uint64_t next_report_ns = start_ns + 1'000'000'000;
+        uint64_t last_report_sent = 0;
+        uint64_t last_report_replies = 0;
+        uint64_t offered = 0;
+        uint32_t next_slot = 0;
+        // Responder poll() time, split by whether the call found frames: the
+        // busy ones give the per-frame cost, the empty ones the idle overhead.
+        uint64_t busy_poll_ns = 0;
+        uint64_t polled_frames = 0;
+        uint64_t empty_poll_ns = 0;
+        uint64_t empty_polls = 0;
+
+        while (true)
+        {
+            const uint64_t now = now_ns();
+            if (now >= stop_ns && (state.outstanding == 0 || now >= stop_ns + timeout_ns))
+            {
+                break;
+            }
+
+            if (now < stop_ns)
+            {
+                uint64_t budget = load.burst;
+                if (load.rate_pps != 0)
+                {
+                    const uint64_t due = (now - start_ns) * load.rate_pps / 1'000'000'000;
+                    budget = std::min(budget, due - offered);
+                }
+                for (uint64_t i = 0; i < budget; ++i)
+                {
+                    const uint32_t slot = next_slot;
+                    if (state.in_flight(slot))
+                    {
+                        // A fresh clock read: 'now' predates sends made
+                        // earlier in this burst, whose stamps are later.
+                        if (now_ns() - state.sent_at(slot) < timeout_ns)
+                        {
+                            // Window full. Paced: this send is skipped, as
+                            // an open-loop source would; flat out: wait.
+                            if (load.rate_pps == 0)
+                            {
+                                break;
+                            }
+                            ++state.stalled;
+                            ++offered;
+                            continue;
+                        }
+                        state.on_lost(slot);
+                    }
+                    ++offered;
+                    if (generator->send_frame(frames[slot]) != 0)
+                    {
+                        ++state.send_errors;
+                        continue;
+                    }
+                    state.on_sent(slot, now_ns());
+                    next_slot = slot + 1 == load.window ? 0 : slot + 1;
+                }
+            }
+
+            (void)generator->poll();
+            const uint64_t poll_start = now_ns();
+            const size_t frames_polled = responder->poll();
+            const uint64_t poll_elapsed = now_ns() - poll_start;
+            if (frames_polled != 0)
+            {
+                busy_poll_ns += poll_elapsed;
+                polled_frames += frames_polled;
+            }
+            else
+            {
+                empty_poll_ns += poll_elapsed;
+                ++empty_polls;
+            }
+
+            if (now >= next_report_ns)
+            {
+                const uint64_t second = (now - start_ns) / 1'000'000'000;
+                std::printf("%4llu s: sent %llu/s, replies %llu/s, lost %llu, p50 %llu ns, p99 %llu ns\n",
+                            static_cast<unsigned long long>(second),
+                            static_cast<unsigned long long>(state.sent - last_report_sent),
+                            static_cast<unsigned long long>(state.replies - last_report_replies),
+                            static_cast<unsigned long long>(state.lost),
+                            static_cast<unsigned long long>(state.interval.percentile_ns(0.50)),
+                            static_cast<unsigned long long>(state.interval.percentile_ns(0.99)));
+                state.interval.clear();
+                last_report_sent = state.sent;
+                last_report_replies = state.replies;
+                next_report_ns += 1'000'000'000;
+            }
+        }
+        state.expire_all();
+
+        // Replies keep arriving after stop_ns until the window drains, so the
+        // rate is over the whole run, not just the sending period.
+        const double seconds = static_cast<double>(now_ns() - start_ns) / 1e9;
+        const double reply_pps = static_cast<double>(state.replies) / seconds;
+        const double poll_ns_per_frame =
+            polled_frames == 0 ? 0.0 : static_cast<double>(busy_poll_ns) / static_cast<double>(polled_frames);
+        const LatencyHistogram &latency = state.total;
+        const net::ArpStats &arp = responder->get_arp_cache().get_stats();
+
+        std::printf("sent %llu, replies %llu, lost %llu (%.3f%%), late %llu, window-full skips %llu, send errors %llu\n",
+                    static_cast<unsigned long long>(state.sent), static_cast<unsigned long long>(state.replies),
+                    static_cast<unsigned long long>(state.lost),
+                    state.sent == 0 ? 0.0 : 100.0 * static_cast<double>(state.lost) / static_cast<double>(state.sent),
+                    static_cast<unsigned long long>(state.late), static_cast<unsigned long long>(state.stalled),
+                    static_cast<unsigned long long>(state.send_errors));
+        std::printf("link drops %llu, responder rate-limited %u\n",
+                    static_cast<unsigned long long>(link_drops(generator_hal) + link_drops(responder_hal)),
+                    arp.replies_rate_limited + arp.source_rate_limited);
+        std::printf("latency ns: p50 %llu, p90 %llu, p99 %llu, p99.9 %llu, max %llu\n",
+                    static_cast<unsigned long long>(latency.percentile_ns(0.50)),
+                    static_cast<unsigned long long>(latency.percentile_ns(0.90)),
+                    static_cast<unsigned long long>(latency.percentile_ns(0.99)),
+                    static_cast<unsigned long long>(latency.percentile_ns(0.999)),
+                    static_cast<unsigned long long>(latency.max_ns()));
+        std::printf("responder poll(): %llu frames in %.1f ms, %.1f ns/frame -> ceiling %.0f pps; achieved %.0f replies/s\n",
+                    static_cast<unsigned long long>(polled_frames), static_cast<double>(busy_poll_ns) / 1e6,
+                    poll_ns_per_frame, poll_ns_per_frame > 0.0 ? 1e9 / poll_ns_per_frame : 0.0, reply_pps);
+        std::printf("responder poll() with nothing to receive: %llu calls, %.1f ns each\n",
+                    static_cast<unsigned long long>(empty_polls),
+                    empty_polls == 0 ? 0.0 : static_cast<double>(empty_poll_ns) / static_cast<double>(empty_polls));
+        std::printf("RESULT protocol=%s link=%s rate=%u window=%u burst=%u sent=%llu replies=%llu lost=%llu "
+                    "reply_pps=%.0f poll_ns_per_frame=%.1f p50_ns=%llu p99_ns=%llu p999_ns=%llu max_ns=%llu\n",
+                    Traffic::name, link, load.rate_pps, load.window, load.burst,
+                    static_cast<unsigned long long>(state.sent), static_cast<unsigned long long>(state.replies),
+                    static_cast<unsigned long long>(state.lost), reply_pps, poll_ns_per_frame,
+                    static_cast<unsigned long long>(latency.percentile_ns(0.50)),
+                    static_cast<unsigned long long>(latency.percentile_ns(0.99)),
+                    static_cast<unsigned long long>(latency.percentile_ns(0.999)),
+                    static_cast<unsigned long long>(latency.max_ns()));
+        return 0;
+    }
+}
+
+int main()
+{
+    const char *protocol = std::getenv("LOAD_PROTOCOL");
+    if (protocol != nullptr && std::strcmp(protocol, ArpTraffic::name) != 0)
+    {
+        std::printf("LOAD_PROTOCOL=%s is not supported (supported: arp)\n", protocol);
+        return 1;
+    }
+
+    LoadConfig load;
+    load.rate_pps = env_u32("LOAD_RATE_PPS", load.rate_pps);
+    load.window = std::clamp<uint32_t>(env_u32("LOAD_WINDOW", load.window), 1, MAX_WINDOW);
+    load.burst = std::clamp<uint32_t>(env_u32("LOAD_BURST", load.burst), 1, load.window);
+    load.seconds = std::max<uint32_t>(env_u32("LOAD_SECONDS", load.seconds), 1);
+    load.timeout_ms = std::max<uint32_t>(env_u32("LOAD_TIMEOUT_MS", load.timeout_ms), 1);
+
+    hal_timer_init();
+
+    net::NetworkConfig responder_config = {
+        .mac_address = RESPONDER_MAC,
+        .ipv4_address = RESPONDER_IP,
+        .gateway_address = {},
+        .subnet_mask = {255, 255, 0, 0},
+        .interface_name = std::getenv("NET_IFACE")};
+    net::NetworkConfig generator_config = responder_config;
+    generator_config.mac_address = GENERATOR_MAC;
+    generator_config.ipv4_address = GENERATOR_IP;
+    generator_config.interface_name = std::getenv("NET_PEER_IFACE");
+
+    if (responder_config.interface_name == nullptr || generator_config.interface_name == nullptr)
+    {
+        auto generator_hal = std::make_unique<MemoryLink>();
+        auto responder_hal = std::make_unique<MemoryLink>();
+        MemoryLink::connect(*generator_hal, *responder_hal);
+        return run(*generator_hal, *responder_hal, generator_config, responder_config,
+                   ArpTraffic{GENERATOR_MAC}, load, "memory");
+    }
+
+    LinuxRawSocketHal generator_hal;
+    LinuxRawSocketHal responder_hal;
+    if (responder_hal.init(&responder_config, NetworkFiltering::ARP) != 0 ||
+        generator_hal.init(&generator_config, NetworkFiltering::ARP) != 0)
+    {
+        std::printf("raw sockets unavailable on %s/%s\n", responder_config.interface_name,
+                    generator_config.interface_name);
+        return 1;
+    }
+    std::memcpy(responder_config.mac_address.data(), responder_hal.mac(), MAC_ADDRESS_LENGTH);
+    std::memcpy(generator_config.mac_address.data(), generator_hal.mac(), MAC_ADDRESS_LENGTH);
+
+    const char *link = "veth";
+    const uint32_t io_uring_buffers = env_u32("NET_IO_URING", 0);
+    if (io_uring_buffers != 0)
+    {
+        const uint32_t tx_slots = std::max<uint32_t>(io_uring_buffers / 2, 1);
+        if (responder_hal.enable_io_uring(io_uring_buffers, tx_slots) != 0 ||
+            generator_hal.enable_io_uring(io_uring_buffers, tx_slots) != 0)
+        {
+            std::printf("io_uring unavailable\n");
+            return 1;
+        }
+        link = "veth+io_uring";
+    }
+
+    ArpTraffic traffic;
+    traffic.generator_mac = generator_config.mac_address;
+    return run(generator_hal, responder_hal, generator_config, responder_config, traffic, load, link);
+}
@@ -3,19 +3,25 @@
 
 #include "NetworkingStack.h"
 #include "hal/hal_network.hpp"
+#include "hal/hal_persist.hpp"
 #include "hal/hal_timer.hpp"
+#include "hal/hal_thread.hpp"
 #include "hal/hal_logging.hpp"
+#include "hal/hal_dump.hpp"
 
 #include "protocols/ethernet.hpp"
 #include "protocols/arp.hpp"
 #include "net_stack/network_stack.hpp"
+#include "net_stack/memory_footprint.hpp"
+#include <algorithm>
 #include <vector>
 #include <cstdint>
 #include <cstring>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
 #include <array>
-#include <thread>
-#include <chrono>
+#include <optional>
 
 using namespace std;
 
@@ -34,6 +40,137 @@ uint16_t htons(uint16_t hostshort)
     }
 }
 
+namespace
+{
+    constexpr uint32_t ARP_RESOLVE_TIMEOUT_MS = 5000;
+
+    // Resolves the gateway without a hand-written polling loop: the coroutine
+    // is suspended inside resolve() and resumed from stack.poll() when the
+    // reply arrives (or the timeout expires).
+    net::Task discover_gateway(net::NetworkStack &stack, const net::NetworkConfig &config)
+    {
+        NET_LOG_INFO(HAL, "Starting ARP discovery for gateway...");
+
+        std::optional<std::array<uint8_t, MAC_ADDRESS_LENGTH>> gateway_mac;
+        while (!(gateway_mac = co_await stack.resolve(config.gateway_address, ARP_RESOLVE_TIMEOUT_MS)))
+        {
+            NET_LOG_WARN(HAL, "Gateway did not answer within %u ms, retrying...", ARP_RESOLVE_TIMEOUT_MS);
+        }
+
+        NET_LOG_INFO(HAL, "SUCCESS: Gateway MAC address has been resolved!");
+        const std::array<uint8_t, MAC_ADDRESS_LENGTH> &mac = gateway_mac.value();
+        NET_LOG_INFO(HAL, "MAC Address: %x:%x:%x:%x:%x:%x",
+                     mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    }
+
+    // True while the cache holds 'address' as a restored entry not yet
+    // confirmed by its probe.
+    bool arp_tentative(const net::ArpCache &cache, const std::array<uint8_t, IPV4_ADDRESS_LENGTH> &address)
+    {
+        for (const net::ArpEntry &entry : cache.entries())
+        {
+            if (entry.state == net::ArpEntryState::TENTATIVE && entry.ipv4_address == address)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // NET_TIMESTAMPING=sw|hw turns on kernel (or NIC) frame timestamps.
+    TimestampMode timestamp_mode_from_env()
+    {
+        const char *mode = std::getenv("NET_TIMESTAMPING");
+        if (mode == nullptr)
+        {
+            return TimestampMode::NONE;
+        }
+        if (std::strcmp(mode, "hw") == 0)
+        {
+            return TimestampMode::HARDWARE;
+        }
+        return std::strcmp(mode, "sw") == 0 ? TimestampMode::SOFTWARE : TimestampMode::NONE;
+    }
+
+    // Unsigned value of an environment variable, or 'fallback' if unset/invalid.
+    uint32_t env_u32(const char *name, uint32_t fallback)
+    {
+        const char *value = std::getenv(name);
+        if (value == nullptr || *value == '\0')
+        {
+            return fallback;
+        }
+        char *end = nullptr;
+        unsigned long parsed = std::strtoul(value, &end, 10);
+        return (*end == '\0' && parsed <= UINT32_MAX) ? static_cast<uint32_t>(parsed) : fallback;
+    }
+
+    void log_datagram(void *, const net::Ipv4Datagram &datagram)
+    {
+        NET_LOG_INFO(HAL, "IPv4 datagram from %u.%u.%u.%u: protocol %u, %zu bytes%s",
+                     datagram.source[0], datagram.source[1], datagram.source[2], datagram.source[3],
+                     datagram.protocol, datagram.payload.size(), datagram.reassembled ? " (reassembled)" : "");
+    }
+
+    // NET_ARP_SWEEP=a.b.c.d/len: after the gateway, find every host on that
+    // subnet (NET_ARP_SWEEP_RATE requests per second, default 1000).
+    struct SweepSummary
+    {
+        uint32_t found = 0;
+        uint32_t silent = 0;
+    };
+
+    void log_sweep_result(void *context, const net::ArpSweepResult &result)
+    {
+        SweepSummary &summary = *static_cast<SweepSummary *>(context);
+        if (!result.mac.has_value())
+        {
+            ++summary.silent;
+            return;
+        }
+        ++summary.found;
+        const std::array<uint8_t, MAC_ADDRESS_LENGTH> &mac = *result.mac;
+        NET_LOG_INFO(HAL, "Host %u.%u.%u.%u is at %x:%x:%x:%x:%x:%x (%u ms)",
+                     result.ip[0], result.ip[1], result.ip[2], result.ip[3],
+                     mac[0], mac[1], mac[2], mac[3], mac[4], mac[5], result.rtt_ms);
+    }
+
+    bool parse_subnet(const char *text, std::array<uint8_t, IPV4_ADDRESS_LENGTH> &first, uint32_t &count)
+    {
+        unsigned a, b, c, d, length;
+        if (std::sscanf(text, "%u.%u.%u.%u/%u", &a, &b, &c, &d, &length) != 5 || a > 255 || b > 255 || c > 255 ||
+            d > 255 || length < 8 || length > 32)
+        {
+            return false;
+        }
+        const uint32_t mask = length == 32 ? UINT32_MAX : ~(UINT32_MAX >> length);
+        const uint32_t network = ((a << 24) | (b << 16) | (c << 8) | d) & mask;
+        first = {static_cast<uint8_t>(network >> 24), static_cast<uint8_t>(network >> 16),
+                 static_cast<uint8_t>(network >> 8), static_cast<uint8_t>(network)};
+        count = ~mask + 1;
+        // Skip the network address (and broadcast) on real subnets.
+        if (length <= 30)
+        {
+            first[3] = static_cast<uint8_t>(first[3] + 1);
+            count -= 2;
+        }
+        return true;
+    }
+
+    void log_latency(const char *what, const net::LatencyStats &stats)
+    {
+        if (stats.samples == 0)
+        {
+            return;
+        }
+        NET_LOG_INFO(HAL, "%s latency: %llu samples, min %llu ns, avg %llu ns, max %llu ns", what,
+                     static_cast<unsigned long long>(stats.samples),
+                     static_cast<unsigned long long>(stats.min_ns),
+                     static_cast<unsigned long long>(stats.average_ns()),
+                     static_cast<unsigned long long>(stats.max_ns));
+    }
+}
+
 int main()
 {
     net::NetworkConfig netconfig = {
@@ -41,50 +178,171 @@ int main()
         .ipv4_address = {10, 23, 42, 10},
         .gateway_address = {10, 23, 42, 1}};
 
-    if (hal_net_init(&netconfig, NetworkFiltering::ARP) != 0)
+    DefaultNetworkHal hal;
+    if (hal.init(&netconfig, NetworkFiltering::ARP_IPV4) != 0)
     {
         return 1;
     }
     hal_timer_init();
 
-    net::NetworkStack stack(&netconfig);
+    TimestampMode timestamps = timestamp_mode_from_env();
+    if (timestamps != TimestampMode::NONE && hal.enable_timestamping(timestamps) != 0)
+    {
+        NET_LOG_WARN(HAL, "Timestamping unavailable, continuing without it");
+    }
 
-    uint32_t last_arp_request_ms = 0;
-    const uint32_t ARP_REQUEST_INTERVAL_MS = 5000; // 2 seconds
+    // NET_IO_URING=<n>: receive through n io_uring buffers and batch sends
+    // (n/2 TX slots) instead of one recv()/send() syscall per frame.
+    const uint32_t io_uring_buffers = env_u32("NET_IO_URING", 0);
+    if (io_uring_buffers != 0 && hal.enable_io_uring(io_uring_buffers, std::max<uint32_t>(io_uring_buffers / 2, 1)) != 0)
+    {
+        NET_LOG_WARN(HAL, "io_uring unavailable, continuing with recv/send");
+    }
 
-    NET_LOG_INFO(HAL, "Starting ARP discovery for gateway...");
+    // Dedicated-core mode (all optional):
+    //   NET_CPU=<n>            pin the poll thread to CPU n
+    //   NET_SCHED_FIFO=<prio>  run it SCHED_FIFO at 'prio'
+    //   NET_BUSY_POLL_US=<us>  spin this long after the last frame before parking,
+    //                          and let the socket busy-poll the driver as long
+    constexpr uint32_t UNSET = UINT32_MAX;
+    const uint32_t cpu = env_u32("NET_CPU", UNSET);
+    const uint32_t fifo_priority = env_u32("NET_SCHED_FIFO", 0);
+    const uint32_t busy_poll_us = env_u32("NET_BUSY_POLL_US", 0);
 
-    // This loop will run until we get a reply.
-    while (!stack.is_gateway_mac_known())
+    if (cpu != UNSET)
+    {
+        (void)hal_thread_pin_to_cpu(cpu);
+    }
+    if (fifo_priority != 0)
     {
-        // Always poll for incoming packets and to run housekeeping.
-        stack.poll();
+        (void)hal_thread_set_realtime(static_cast<int>(fifo_priority));
+    }
+    if (busy_poll_us != 0)
+    {
+        (void)hal.enable_busy_poll(busy_poll_us, true);
+    }
 
-        // Check if it's time to send our next ARP request.
-        uint32_t current_time_ms = hal_timer_get_ms();
-        if (current_time_ms - last_arp_request_ms > ARP_REQUEST_INTERVAL_MS)
+    constexpr net::MemoryFootprint footprint = net::memory_footprint<DefaultNetworkHal>();
+    NET_LOG_INFO(HAL, "Static RAM: %zu of %zu bytes (stack %zu incl. ARP cache %zu, routing %zu, reassembly %zu, flight recorder %zu, flows %zu, owned addresses %zu, ARP sweep %zu, HAL %zu, task pool %zu, log line %zu)",
+                 footprint.total(), net::k_memory_config.ram_budget_bytes, footprint.stack_bytes,
+                 footprint.arp_cache_bytes, footprint.routing_bytes, footprint.reassembly_bytes,
+                 footprint.flight_recorder_bytes, footprint.flow_table_bytes, footprint.owned_addresses_bytes, footprint.arp_sweep_bytes,
+                 footprint.hal_bytes,
+                 footprint.coroutine_pool_bytes, footprint.log_line_bytes);
+
+    net::NetworkStack stack(hal, &netconfig);
+    stack.set_busy_poll_policy({.idle_spin_us = busy_poll_us});
+    stack.set_datagram_receiver(log_datagram, nullptr);
+
+    // NET_PCAP_DUMP=file.pcapng: the last frames are written there on a crash or SIGUSR1.
+    if (const char *dump_path = std::getenv("NET_PCAP_DUMP"))
+    {
+        (void)hal_dump_install(dump_path, [](void *context, const HalDumpSink &sink) {
+            static_cast<const net::NetworkStack *>(context)->get_flight_recorder().write_pcapng(sink, sink.epoch_offset_us);
+        }, &stack);
+    }
+
+    // NET_ARP_SNAPSHOT=<file>: warm start. The ARP cache is restored from the
+    // file (tentative, probed before it is trusted), kept there while running
+    // and saved on exit, so the next run skips resolving the gateway.
+    HalPersistentRegion snapshot{};
+    const char *snapshot_path = std::getenv("NET_ARP_SNAPSHOT");
+    if (snapshot_path != nullptr &&
+        hal_persist_map(snapshot_path, net::arp_snapshot_bytes(net::k_memory_config.arp_cache_entries), snapshot) == 0)
+    {
+        const net::ArpSnapshotLoad load = stack.attach_arp_snapshot({static_cast<std::byte *>(snapshot.data), snapshot.size});
+        if (load.status != net::ArpSnapshotLoad::Status::LOADED)
         {
-            stack.send_arp_request_for_gateway();
-            last_arp_request_ms = current_time_ms;
+            NET_LOG_INFO(HAL, "No usable ARP snapshot in %s, cold start", snapshot_path);
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(100)); // slow down the loop
     }
 
-    NET_LOG_INFO(HAL, "SUCCESS: Gateway MAC address has been resolved!");
+    const uint64_t discovery_start_us = hal_timer_get_us();
+    net::Task discovery = discover_gateway(stack, netconfig);
 
-    // We can now lookup the MAC and print it (optional)
-    std::optional<std::array<uint8_t, MAC_ADDRESS_LENGTH>> gateway_mac =
-        stack.get_arp_cache().lookup(netconfig.gateway_address);
-    if (gateway_mac.has_value())
+    // Spin while traffic flows, then sleep in the HAL until a frame arrives
+    // or the stack's next timer is due.
+    while (!discovery.done())
     {
-        // You would need to add a small function to print the MAC address here
-        const std::array<uint8_t, MAC_ADDRESS_LENGTH> &mac = gateway_mac.value();
-        NET_LOG_INFO(HAL, "MAC Address: %x:%x:%x:%x:%x:%x",
-                     mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+        stack.run_once();
+    }
+    NET_LOG_INFO(HAL, "Gateway usable %llu us after start",
+                 static_cast<unsigned long long>(hal_timer_get_us() - discovery_start_us));
+
+    // Give the probe of a restored gateway entry time to be answered. Other
+    // restored entries are only probed when first used, so they are not
+    // waited for.
+    const net::ArpStats &arp = stack.get_arp_cache().get_stats();
+    const uint32_t probe_wait_start_ms = hal_timer_get_ms();
+    while (arp_tentative(stack.get_arp_cache(), netconfig.gateway_address) &&
+           hal_timer_get_ms() - probe_wait_start_ms < ARP_RESOLVE_TIMEOUT_MS)
+    {
+        stack.run_once();
+    }
+    if (arp.tentative_loaded != 0)
+    {
+        NET_LOG_INFO(HAL, "Restored ARP entries: %u confirmed, %u expired, %u probes sent", arp.tentative_confirmed,
+                     arp.tentative_expired, arp.probes_sent);
+    }
+
+    std::array<uint8_t, IPV4_ADDRESS_LENGTH> sweep_first{};
+    uint32_t sweep_count = 0;
+    const char *sweep = std::getenv("NET_ARP_SWEEP");
+    if (sweep != nullptr && parse_subnet(sweep, sweep_first, sweep_count))
+    {
+        SweepSummary summary;
+        net::ArpSweepOptions options;
+        options.rate_per_sec = env_u32("NET_ARP_SWEEP_RATE", options.rate_per_sec);
+        const uint32_t start_ms = hal_timer_get_ms();
+        if (stack.start_arp_sweep(sweep_first, sweep_count, options, log_sweep_result, &summary))
+        {
+            while (stack.arp_sweep_active())
+            {
+                stack.run_once();
+            }
+            const net::ArpSweepStats &stats = stack.get_arp_sweep_stats();
+            NET_LOG_INFO(HAL, "ARP sweep of %s: %u hosts found, %u silent, in %u ms (%u requests, %u retries)", sweep,
+                         summary.found, summary.silent, hal_timer_get_ms() - start_ms, stats.requests, stats.retries);
+        }
+    }
+
+    const net::RunLoopStats &run = stack.get_run_stats();
+    NET_LOG_INFO(HAL, "Run loop: %llu polls (%llu busy, %llu idle spins), %llu parks (%llu woken by frames), "
+                      "%llu us polling, %llu us parked",
+                 static_cast<unsigned long long>(run.polls),
+                 static_cast<unsigned long long>(run.busy_polls),
+                 static_cast<unsigned long long>(run.idle_spins),
+                 static_cast<unsigned long long>(run.parks),
+                 static_cast<unsigned long long>(run.park_wakeups),
+                 static_cast<unsigned long long>(run.spin_us),
+                 static_cast<unsigned long long>(run.parked_us));
+
+    const net::FlowTableStats &flows = stack.get_flow_stats();
+    if (flows.hits + flows.misses != 0)
+    {
+        NET_LOG_INFO(HAL, "Flow cache: %.1f%% hits (%llu hits, %llu misses, %llu evictions)", flows.hit_rate() * 100.0,
+                     static_cast<unsigned long long>(flows.hits), static_cast<unsigned long long>(flows.misses),
+                     static_cast<unsigned long long>(flows.evictions));
+    }
+
+    log_latency("RX", stack.get_rx_latency());
+    log_latency("TX", stack.get_tx_latency());
+
+    if (std::getenv("NET_PCAP_DUMP") != nullptr && hal_dump_now() == 0)
+    {
+        NET_LOG_INFO(HAL, "Flight recorder: %u frames recorded, last %zu written to %s",
+                     stack.get_flight_recorder().recorded(), net::NetworkStack::Recorder::capacity(),
+                     std::getenv("NET_PCAP_DUMP"));
+    }
+
+    if (snapshot.data != nullptr)
+    {
+        stack.save_arp_snapshot();
+        hal_persist_unmap(snapshot);
     }
 
     NET_LOG_INFO(HAL, "Test complete. Shutting down.");
-    hal_net_shutdown();
+    hal.shutdown();
 
     return 0;
 }
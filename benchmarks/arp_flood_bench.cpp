@@ -0,0 +1,160 @@
+// ARP storm: how much CPU and how many legitimate resolutions survive.
+//
+// A freshly booted stack is hit by a storm of spoofed ARP traffic: broadcasts
+// for other hosts plus a scanner sweeping requests at our IP. Interleaved
+// sparsely with the storm are legitimate neighbours: half answer requests we
+// sent (solicited), half ask for us first (unsolicited) and must be learned. Compared: the unprotected original behaviour (learn from
+// everything, answer everything) and the default ArpPolicy.
+
+#include "bench_common.hpp"
+#include "arp_frames.hpp"
+
+#include "hal/hal_timer.hpp"
+#include "net_stack/network_stack_impl.hpp"
+
+#include <array>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+    const net::NetworkConfig k_config = {
+        .mac_address = {0xF4, 0x7B, 0x09, 0x51, 0x91, 0x63},
+        .ipv4_address = {10, 23, 42, 10},
+        .gateway_address = {10, 23, 42, 1}};
+
+    constexpr size_t LEGIT_NEIGHBORS = 8;
+    constexpr size_t SOLICITED = LEGIT_NEIGHBORS / 2;
+    constexpr uint64_t STORM_FRAMES = 2'000'000;
+    constexpr uint64_t LEGIT_EVERY = 50'000;   // one real reply per this many storm frames
+    constexpr uint32_t SCANNER_PERCENT = 20;   // share of the storm aimed at our IP
+
+    std::array<uint8_t, 4> legit_ip(size_t i)
+    {
+        return {10, 23, 42, static_cast<uint8_t>(100 + i)};
+    }
+
+    // Generates the storm on the fly instead of replaying one frame.
+    class StormHal {
+    public:
+        uint64_t remaining = 0;
+        uint64_t generated = 0;
+        uint64_t tx_frames = 0;
+        size_t next_legit = 0;
+        bool single_source_scanner = false; // scanner uses one real IP instead of spoofing
+        bench::XorShift32 rng;
+
+        int send(const void* data, size_t)
+        {
+            bench::do_not_optimize(data);
+            ++tx_frames;
+            return 0;
+        }
+
+        size_t receive(void* buffer, size_t max_length)
+        {
+            constexpr size_t frame_size = bench::ARP_FRAME_BYTES;
+            if (remaining == 0 || max_length < frame_size) return 0;
+            --remaining;
+            ++generated;
+            std::byte* frame = static_cast<std::byte*>(buffer);
+
+            if (generated % LEGIT_EVERY == 0 && next_legit < LEGIT_NEIGHBORS) {
+                const uint8_t mac[6] = {0xAA, 0xBB, 0xCC, 0xDD, 0xEE, static_cast<uint8_t>(next_legit)};
+                const uint16_t opcode = next_legit < SOLICITED ? ARP_OPCODE_REPLY : ARP_OPCODE_REQUEST;
+                bench::write_arp(frame, opcode, mac, legit_ip(next_legit), k_config.ipv4_address);
+                ++next_legit;
+                return frame_size;
+            }
+
+            const uint32_t r = rng.next();
+            const uint8_t mac[6] = {0x02, 0x00, static_cast<uint8_t>(r), static_cast<uint8_t>(r >> 8),
+                                    static_cast<uint8_t>(r >> 16), static_cast<uint8_t>(r >> 24)};
+            const std::array<uint8_t, 4> sender = {10, static_cast<uint8_t>(r >> 24),
+                                                   static_cast<uint8_t>(r >> 16), static_cast<uint8_t>(r >> 8)};
+            if (r % 100 < SCANNER_PERCENT) {
+                const std::array<uint8_t, 4> scanner = {10, 23, 42, 66};
+                bench::write_arp(frame, ARP_OPCODE_REQUEST, mac, single_source_scanner ? scanner : sender,
+                          k_config.ipv4_address);
+            } else {
+                // Any host on the segment except us.
+                uint8_t host = static_cast<uint8_t>(r);
+                if (host == k_config.ipv4_address[3]) ++host;
+                const std::array<uint8_t, 4> other = {10, 23, 42, host};
+                bench::write_arp(frame, ARP_OPCODE_REQUEST, mac, sender, other);
+            }
+            return frame_size;
+        }
+
+        bool wait(uint32_t) { return remaining != 0; }
+    };
+
+    void run_case(const char* label, const net::ArpPolicy& policy, bool single_source_scanner = false)
+    {
+        StormHal hal;
+        hal.single_source_scanner = single_source_scanner;
+        net::BasicNetworkStack<StormHal> stack(hal, &k_config);
+        stack.get_arp_cache().set_policy(policy);
+
+        // Boot: ask for the solicited neighbours (they answer during the storm).
+        for (size_t i = 0; i < SOLICITED; ++i) {
+            stack.send_arp_request(legit_ip(i));
+        }
+        const uint64_t tx_before_storm = hal.tx_frames;
+
+        hal.remaining = STORM_FRAMES;
+        const uint64_t start = bench::now_ns();
+        while (hal.remaining != 0) {
+            stack.poll();
+        }
+        const double ns_per_frame = static_cast<double>(bench::now_ns() - start) / static_cast<double>(STORM_FRAMES);
+
+        size_t solicited = 0;
+        size_t unsolicited = 0;
+        for (size_t i = 0; i < LEGIT_NEIGHBORS; ++i) {
+            const bool known = stack.get_arp_cache().lookup(legit_ip(i)).has_value();
+            (i < SOLICITED ? solicited : unsolicited) += known ? 1 : 0;
+        }
+
+        // Lookup cost for the neighbours after the storm (cache full of junk or not).
+        const double lookup_ns = bench::time_per_op_ns(1'000'000, [&](uint64_t i) {
+            bench::do_not_optimize(stack.get_arp_cache().lookup(legit_ip(i % LEGIT_NEIGHBORS)));
+        });
+
+        const net::ArpStats& stats = stack.get_arp_cache().get_stats();
+        std::printf("%-24s %7.1f ns/frame  replies sent %8llu  learned %4u  legit solicited %zu/%zu unsolicited %zu/%zu  lookup %.1f ns\n",
+                    label, ns_per_frame,
+                    static_cast<unsigned long long>(hal.tx_frames - tx_before_storm),
+                    stats.entries_learned, solicited, SOLICITED,
+                    unsolicited, LEGIT_NEIGHBORS - SOLICITED, lookup_ns);
+        std::printf("%-24s   rate-limited: learn %u  reply %u  per-source %u  policy-rejected %u\n",
+                    "", stats.learn_rate_limited, stats.replies_rate_limited,
+                    stats.source_rate_limited, stats.not_learned_policy);
+    }
+
+}
+
+int main()
+{
+    hal_timer_init();
+    std::printf("ARP storm: %llu spoofed frames (%u%% aimed at us), %zu legitimate replies\n",
+                static_cast<unsigned long long>(STORM_FRAMES), SCANNER_PERCENT, LEGIT_NEIGHBORS);
+
+    net::ArpPolicy unprotected;
+    unprotected.learning = net::ArpLearningPolicy::LEARN_ALL;
+    unprotected.learn_rate_per_sec = 0;
+    unprotected.reply_rate_per_sec = 0;
+    unprotected.per_source_rate_per_sec = 0;
+    run_case("unprotected", unprotected);
+
+    run_case("default", net::ArpPolicy{});
+
+    net::ArpPolicy strict;
+    strict.learning = net::ArpLearningPolicy::UPDATE_ONLY;
+    run_case("update-only", strict);
+
+    // Per-source budgets only bite when the scanner does not spoof its address.
+    run_case("unprotected, one scanner", unprotected, true);
+    run_case("default, one scanner", net::ArpPolicy{}, true);
+    return 0;
+}
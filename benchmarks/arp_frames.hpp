@@ -0,0 +1,42 @@
+#ifndef BENCHMARKS_ARP_FRAMES_H
+#define BENCHMARKS_ARP_FRAMES_H
+
+// Builds Ethernet+ARP frames for the benchmarks' simulated traffic.
+
+#include "net_stack/byte_order.hpp"
+#include "protocols/arp.hpp"
+#include "protocols/ethernet.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace bench {
+
+    constexpr size_t ARP_FRAME_BYTES = sizeof(EthernetHeader) + sizeof(ArpPacket);
+
+    // Broadcast ARP frame; 'frame' must hold ARP_FRAME_BYTES.
+    inline void write_arp(std::byte* frame, uint16_t opcode,
+                          const uint8_t sender_mac[6], const std::array<uint8_t, 4>& sender_ip,
+                          const std::array<uint8_t, 4>& target_ip)
+    {
+        auto* eth = reinterpret_cast<EthernetHeader*>(frame);
+        auto* arp = reinterpret_cast<ArpPacket*>(frame + sizeof(EthernetHeader));
+        std::memset(eth->destination_mac, 0xFF, 6);
+        std::memcpy(eth->source_mac, sender_mac, 6);
+        eth->ethertype = net::net_htons16(ETHERTYPE_ARP);
+        arp->hardware_type = net::net_htons16(ARP_HW_TYPE_ETHERNET);
+        arp->protocol_type = net::net_htons16(ETHERTYPE_IPV4);
+        arp->hardware_addr_len = 6;
+        arp->protocol_addr_len = 4;
+        arp->opcode = net::net_htons16(opcode);
+        std::memcpy(arp->sender_mac, sender_mac, 6);
+        std::memcpy(arp->sender_ip, sender_ip.data(), 4);
+        std::memset(arp->target_mac, 0, 6);
+        std::memcpy(arp->target_ip, target_ip.data(), 4);
+    }
+
+}
+
+#endif
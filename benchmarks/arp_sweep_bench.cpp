@@ -0,0 +1,200 @@
+// ARP sweep: how long finding every live host on a /24 or /16 takes.
+//
+// A generator stack sweeps 10.200.0.0/16 (or a /24 of it) through
+// start_arp_sweep(); a responder stack on an in-memory link answers for
+// 10.200.0.0-10.200.63.255 (one owned range) and 8192 scattered addresses
+// above it (single owned addresses): 24576 live hosts, the rest silent, so
+// most of the time goes to timeouts. Both stacks are polled in turn on one
+// thread. Every address must be reported exactly once, live ones with the
+// responder's MAC. Before the sweep API, finding them meant one resolve()
+// per address, waiting out the timeout of every silent one in turn.
+// Also: step() + complete() per address with 4096 requests outstanding.
+// Built against a copy of the core with a larger MemoryConfig
+// (large_memory.hpp).
+
+#include "bench_common.hpp"
+
+#include "hal/hal_timer.hpp"
+#include "hal/memory_link_hal.hpp"
+#include "net_stack/network_stack_impl.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+namespace {
+
+    constexpr uint32_t SWEPT_BASE = (10u << 24) | (200u << 16);   // 10.200.0.0
+    constexpr uint32_t RANGE_ALIVE = 16384;                        // 10.200.0.0 - 10.200.63.255
+    constexpr uint32_t SCATTERED_ALIVE = 8192;
+
+    const net::NetworkConfig k_generator_config = {
+        .mac_address = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01},
+        .ipv4_address = {10, 201, 0, 1},
+        .gateway_address = {0, 0, 0, 0},
+        .subnet_mask = {255, 0, 0, 0}};
+
+    const net::NetworkConfig k_responder_config = {
+        .mac_address = {0x02, 0x00, 0x00, 0x00, 0x00, 0x02},
+        .ipv4_address = {10, 202, 0, 1},
+        .gateway_address = {0, 0, 0, 0},
+        .subnet_mask = {255, 0, 0, 0}};
+
+    // Large enough for a whole window of requests and its replies.
+    using Link = MemoryLinkHal<8192, 64>;
+    using Stack = net::BasicNetworkStack<Link>;
+
+    std::array<uint8_t, 4> to_bytes(uint32_t address)
+    {
+        return {static_cast<uint8_t>(address >> 24), static_cast<uint8_t>(address >> 16),
+                static_cast<uint8_t>(address >> 8), static_cast<uint8_t>(address)};
+    }
+
+    struct Sweep {
+        std::vector<uint8_t> alive;      // per offset in the /16
+        std::vector<uint8_t> reports;    // per offset in the /16
+        uint32_t found = 0;
+        uint32_t wrong = 0;              // wrong MAC, live host missed or silent one found
+    };
+
+    void on_result(void* context, const net::ArpSweepResult& result)
+    {
+        Sweep& sweep = *static_cast<Sweep*>(context);
+        const uint32_t offset = net::BasicOwnedAddressTable<{}>::to_u32(result.ip) - SWEPT_BASE;
+        ++sweep.reports[offset];
+        if (result.mac.has_value()) {
+            ++sweep.found;
+            sweep.wrong += *result.mac != k_responder_config.mac_address || !sweep.alive[offset];
+        }
+        else {
+            sweep.wrong += sweep.alive[offset];
+        }
+    }
+
+    struct Case {
+        const char* name;
+        uint32_t first_offset;
+        uint32_t count;
+        net::ArpSweepOptions options;
+    };
+
+    void run(const Case& test, Stack& generator, Stack& responder, Link& generator_link, Sweep& sweep)
+    {
+        std::fill(sweep.reports.begin(), sweep.reports.end(), 0);
+        sweep.found = 0;
+        sweep.wrong = 0;
+        const uint64_t drops_before = generator_link.rx_drops();
+
+        const uint64_t start = bench::now_ns();
+        if (!generator.start_arp_sweep(to_bytes(SWEPT_BASE + test.first_offset), test.count, test.options, on_result,
+                                       &sweep)) {
+            std::printf("%-36s could not start\n", test.name);
+            return;
+        }
+        while (generator.arp_sweep_active()) {
+            (void)generator.poll();
+            (void)responder.poll();
+        }
+        const double seconds = static_cast<double>(bench::now_ns() - start) / 1e9;
+
+        uint32_t expected = 0;
+        for (uint32_t offset = test.first_offset; offset < test.first_offset + test.count; ++offset) {
+            expected += sweep.alive[offset];
+            sweep.wrong += sweep.reports[offset] != 1;
+        }
+        const net::ArpSweepStats& stats = generator.get_arp_sweep_stats();
+        std::printf("%-36s %6.2f s %7u req %7u retry %6u/%-6u found %6u wrong %6llu dropped\n", test.name, seconds,
+                    stats.requests, stats.retries, sweep.found, expected, sweep.wrong,
+                    static_cast<unsigned long long>(generator_link.rx_drops() - drops_before));
+    }
+
+    // The window bookkeeping alone: fill it, answer it in random order.
+    void matching_benchmark()
+    {
+        constexpr size_t WINDOW = Stack::ArpSweep::capacity();
+        constexpr uint32_t ROUNDS = 256;
+        auto sweep = std::make_unique<Stack::ArpSweep>();
+        net::ArpSweepOptions options;
+        options.rate_per_sec = 0;
+        options.timeout_ms = UINT32_MAX / 2;
+        if (!sweep->start(SWEPT_BASE, WINDOW * ROUNDS, options)) {
+            return;
+        }
+        bench::XorShift32 rng;
+        std::vector<uint32_t> order(WINDOW);
+        uint64_t answered = 0;
+        const uint64_t start = bench::now_ns();
+        for (uint32_t round = 0; round < ROUNDS; ++round) {
+            const uint32_t base = SWEPT_BASE + round * static_cast<uint32_t>(WINDOW);
+            for (size_t i = 0; i < WINDOW; ++i) {
+                (void)sweep->step(0);
+                order[i] = base + static_cast<uint32_t>(i);
+            }
+            for (size_t i = WINDOW - 1; i > 0; --i) {
+                std::swap(order[i], order[rng.next() % (i + 1)]);
+            }
+            for (uint32_t address : order) {
+                answered += sweep->complete(address, 0).has_value();
+            }
+        }
+        const double ns = static_cast<double>(bench::now_ns() - start) / static_cast<double>(WINDOW * ROUNDS);
+        std::printf("step() + complete(), %zu outstanding, random reply order: %.1f ns per address (%llu matched)\n\n",
+                    WINDOW, ns, static_cast<unsigned long long>(answered));
+    }
+
+}
+
+int main()
+{
+    hal_timer_init();
+    matching_benchmark();
+
+    auto generator_link = std::make_unique<Link>();
+    auto responder_link = std::make_unique<Link>();
+    Link::connect(*generator_link, *responder_link);
+    auto generator = std::make_unique<Stack>(*generator_link, &k_generator_config);
+    auto responder = std::make_unique<Stack>(*responder_link, &k_responder_config);
+
+    net::ArpPolicy answer_everything;
+    answer_everything.reply_rate_per_sec = 0;
+    answer_everything.per_source_rate_per_sec = 0;
+    responder->get_arp_cache().set_policy(answer_everything);
+
+    Sweep sweep;
+    sweep.alive.assign(65536, 0);
+    sweep.reports.assign(65536, 0);
+    (void)responder->get_owned_addresses().add_range(to_bytes(SWEPT_BASE), RANGE_ALIVE);
+    std::fill(sweep.alive.begin(), sweep.alive.begin() + RANGE_ALIVE, 1);
+    bench::XorShift32 rng;
+    for (uint32_t added = 0; added < SCATTERED_ALIVE;) {
+        const uint32_t offset = RANGE_ALIVE + rng.next() % (65536 - RANGE_ALIVE);
+        if (!sweep.alive[offset] && responder->get_owned_addresses().add(to_bytes(SWEPT_BASE + offset))) {
+            sweep.alive[offset] = 1;
+            ++added;
+        }
+    }
+
+    auto options = [](uint32_t rate, uint32_t window, uint32_t timeout_ms) {
+        net::ArpSweepOptions result;
+        result.rate_per_sec = rate;
+        result.burst = 256;
+        result.max_in_flight = window;
+        result.timeout_ms = timeout_ms;
+        result.retries = 1;
+        return result;
+    };
+
+    std::printf("Sweeps of 10.200.0.0/16 (%u live hosts), timeout then 1 retry\n", RANGE_ALIVE + SCATTERED_ALIVE);
+    const Case cases[] = {
+        { "/24, 1k req/s, window 32, 200 ms", 128 * 256, 256, options(1'000, 32, 200) },
+        { "/16, unpaced, window 1024, 100 ms", 0, 65536, options(0, 1024, 100) },
+        { "/16, unpaced, window 4096, 100 ms", 0, 65536, options(0, 4096, 100) },
+        { "/16, 50k req/s, window 4096, 100 ms", 0, 65536, options(50'000, 4096, 100) },
+    };
+    for (const Case& test : cases) {
+        run(test, *generator, *responder, *generator_link, sweep);
+    }
+    return 0;
+}
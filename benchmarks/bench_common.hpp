@@ -0,0 +1,58 @@
+#ifndef BENCHMARKS_BENCH_COMMON_H
+#define BENCHMARKS_BENCH_COMMON_H
+
+// Minimal helpers shared by the micro-benchmarks. No external benchmark
+// framework: each benchmark is a plain executable that prints one line per case.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+namespace bench {
+
+    // Keeps the optimizer from discarding a value we computed only for timing.
+    template <typename T>
+    inline void do_not_optimize(const T& value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    inline uint64_t now_ns()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // Runs 'body' 'iterations' times and returns the average cost in nanoseconds.
+    template <typename Body>
+    inline double time_per_op_ns(uint64_t iterations, Body&& body)
+    {
+        const uint64_t start = now_ns();
+        for (uint64_t i = 0; i < iterations; ++i) {
+            body(i);
+        }
+        const uint64_t elapsed = now_ns() - start;
+        return static_cast<double>(elapsed) / static_cast<double>(iterations);
+    }
+
+    inline void report(const char* name, double ns_per_op)
+    {
+        std::printf("%-48s %10.2f ns/op %14.0f ops/s\n", name, ns_per_op,
+                    ns_per_op > 0.0 ? 1e9 / ns_per_op : 0.0);
+    }
+
+    // Small deterministic PRNG so runs are comparable between versions.
+    struct XorShift32 {
+        uint32_t state = 0x12345678u;
+        uint32_t next()
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return state;
+        }
+    };
+
+}
+
+#endif
@@ -0,0 +1,156 @@
+// Flight recorder overhead: what record() adds to every frame received or
+// sent, what a dump costs, and whether a dump racing the writer ever sees
+// a torn record.
+//
+// The stack case is an ARP request for us through an in-memory HAL: one RX
+// and one TX record per frame, with the stack's configured recorder. The
+// stack reads the clock once per poll() batch, so compare it with the
+// record() cases without the clock.
+
+#include "bench_common.hpp"
+#include "memory_hal.hpp"
+#include "arp_frames.hpp"
+
+#include "hal/hal_timer.hpp"
+#include "net_stack/flight_recorder.hpp"
+#include "net_stack/network_stack_impl.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <span>
+#include <thread>
+
+namespace {
+
+    constexpr uint64_t ITERATIONS = 20'000'000;
+
+    const net::NetworkConfig k_config = {
+        .mac_address = {0xF4, 0x7B, 0x09, 0x51, 0x91, 0x63},
+        .ipv4_address = {10, 23, 42, 10},
+        .gateway_address = {10, 23, 42, 1}};
+
+    template <size_t Frames, size_t SnapBytes>
+    double record_ns(size_t frame_bytes)
+    {
+        auto recorder = std::make_unique<net::FlightRecorder<Frames, SnapBytes>>();
+        std::array<std::byte, 1514> frame{};
+        const double ns = bench::time_per_op_ns(ITERATIONS, [&](uint64_t i) {
+            frame[0] = static_cast<std::byte>(i);
+            recorder->record(net::FrameDirection::RX, std::span<const std::byte>(frame.data(), frame_bytes),
+                             hal_timer_get_us());
+        });
+        bench::do_not_optimize(recorder->recorded());
+        return ns;
+    }
+
+    void record_cases()
+    {
+        auto small = std::make_unique<net::FlightRecorder<32, 128>>();
+        std::array<std::byte, 60> frame{};
+        bench::report("hal_timer_get_us() alone", bench::time_per_op_ns(ITERATIONS, [](uint64_t) {
+            bench::do_not_optimize(hal_timer_get_us());
+        }));
+        bench::report("record() 60 B frame, snap 128, no clock", bench::time_per_op_ns(ITERATIONS, [&](uint64_t i) {
+            small->record(net::FrameDirection::RX, std::span<const std::byte>(frame.data(), 60), i);
+        }));
+        bench::report("record() 60 B frame, snap 128", record_ns<1024, 128>(60));
+        bench::report("record() 1514 B frame, snap 128", record_ns<1024, 128>(1514));
+        bench::report("record() 1514 B frame, snap 1514", record_ns<1024, 1514>(1514));
+    }
+
+    void stack_case()
+    {
+        bench::InlineMemoryHal hal;
+        auto stack = std::make_unique<net::BasicNetworkStack<bench::InlineMemoryHal>>(hal, &k_config);
+        std::array<std::byte, bench::ARP_FRAME_BYTES> frame{};
+        const uint8_t peer_mac[6] = {0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0x01};
+        bench::write_arp(frame.data(), ARP_OPCODE_REQUEST, peer_mac, k_config.gateway_address, k_config.ipv4_address);
+        hal.state.load_rx_frame(frame);
+
+        constexpr uint64_t BATCH = 64;
+        const double ns = bench::time_per_op_ns(50'000, [&](uint64_t) {
+            hal.state.rx_pending = BATCH;
+            stack->poll();
+        }) / static_cast<double>(BATCH);
+
+        using Recorder = net::BasicNetworkStack<bench::InlineMemoryHal>::Recorder;
+        char name[96];
+        std::snprintf(name, sizeof(name), "stack rx request + tx reply (recorder %zu x %zu B)",
+                      Recorder::capacity(), Recorder::snapshot_bytes());
+        bench::report(name, ns);
+        std::printf("  %u frames recorded\n", stack->get_flight_recorder().recorded());
+    }
+
+    void dump_case()
+    {
+        auto recorder = std::make_unique<net::FlightRecorder<1024, 128>>();
+        std::array<std::byte, 1514> frame{};
+        for (size_t i = 0; i < 4096; ++i) {
+            recorder->record(i % 2 ? net::FrameDirection::TX : net::FrameDirection::RX, frame, hal_timer_get_us());
+        }
+        size_t bytes = 0;
+        const double ns = bench::time_per_op_ns(2'000, [&](uint64_t) {
+            recorder->write_pcapng([&](const void* data, size_t size) {
+                bench::do_not_optimize(data);
+                bytes += size;
+            }, 0);
+        });
+        std::printf("%-48s %10.2f us/dump  (%zu bytes of pcapng)\n", "write_pcapng(), 1024 x 128 B", ns / 1e3,
+                    bytes / 2'000);
+    }
+
+    // Each frame is filled with its first byte; a dumped record whose bytes
+    // disagree was torn by a concurrent writer and must never be emitted.
+    void race_case()
+    {
+        constexpr size_t SNAP = 64;
+        auto recorder = std::make_unique<net::FlightRecorder<16, SNAP>>();
+        std::atomic<bool> stop{ false };
+        std::thread writer([&] {
+            std::array<std::byte, SNAP> frame;
+            for (uint32_t i = 0; !stop.load(std::memory_order_relaxed); ++i) {
+                frame.fill(static_cast<std::byte>(i));
+                recorder->record(net::FrameDirection::TX, frame, i);
+            }
+        });
+
+        uint64_t dumps = 0;
+        uint64_t packets = 0;
+        uint64_t torn = 0;
+        const uint64_t end = bench::now_ns() + 500'000'000;
+        while (bench::now_ns() < end) {
+            size_t fill = 0;
+            recorder->write_pcapng([&](const void* data, size_t size) {
+                // Packet data is the only write of exactly SNAP bytes.
+                if (size == SNAP) {
+                    const auto* bytes = static_cast<const volatile std::byte*>(data);
+                    ++packets;
+                    for (size_t i = 1; i < SNAP; ++i) {
+                        torn += bytes[i] != bytes[0] ? 1 : 0;
+                    }
+                }
+                fill += size;
+            }, 0);
+            ++dumps;
+            bench::do_not_optimize(fill);
+        }
+        stop.store(true);
+        writer.join();
+        std::printf("dumps racing the writer: %llu dumps, %llu packets, %llu torn bytes, %u frames recorded\n",
+                    static_cast<unsigned long long>(dumps), static_cast<unsigned long long>(packets),
+                    static_cast<unsigned long long>(torn), recorder->recorded());
+    }
+
+}
+
+int main()
+{
+    hal_timer_init();
+    record_cases();
+    stack_case();
+    dump_case();
+    race_case();
+    return 0;
+}
@@ -0,0 +1,171 @@
+// Flow classification: binding search vs. the flow cache in front of it.
+//
+// 16 bindings a small device might have (DNS, DHCP, NTP, SNMP, syslog,
+// mDNS, SSH, HTTP(S), ICMP, one per-peer DNS binding). Traffic comes from
+// 10 to 100k flows (random sources and ephemeral ports, 90% to bound ports)
+// picked uniformly or Zipf-distributed (s = 1, a few heavy flows: closer to
+// real traffic). Each packet builds its key from the datagram
+// (make_flow_key) and is classified; every cached answer is checked
+// against the full search.
+
+#include "bench_common.hpp"
+
+#include "net_stack/flow_table.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+namespace {
+
+    constexpr size_t PACKETS = 4'000'000;
+    constexpr size_t BINDINGS = 16;
+
+    struct Target {
+        uint32_t id = 0;
+    };
+
+    struct Flow {
+        net::Ipv4Datagram datagram;
+        std::array<std::byte, 8> udp_header{};
+    };
+
+    template <size_t CacheEntries>
+    using Table = net::FlowTable<Target, BINDINGS, CacheEntries>;
+
+    template <size_t CacheEntries>
+    void add_bindings(Table<CacheEntries>& table)
+    {
+        constexpr uint16_t UDP_PORTS[] = { 53, 67, 68, 123, 161, 162, 514, 1900, 5353, 4789 };
+        constexpr uint16_t TCP_PORTS[] = { 22, 80, 443, 8080 };
+        uint32_t id = 1;
+        for (uint16_t port : UDP_PORTS) {
+            (void)table.bind({ .protocol = IPV4_PROTOCOL_UDP, .local_port = port }, Target{ id++ });
+        }
+        for (uint16_t port : TCP_PORTS) {
+            (void)table.bind({ .protocol = IPV4_PROTOCOL_TCP, .local_port = port }, Target{ id++ });
+        }
+        (void)table.bind({ .protocol = IPV4_PROTOCOL_ICMP }, Target{ id++ });
+        (void)table.bind({ .protocol = IPV4_PROTOCOL_UDP, .local_port = 53, .remote_ip = {10, 0, 0, 53} }, Target{ id++ });
+    }
+
+    std::vector<Flow> make_flows(size_t count)
+    {
+        constexpr uint16_t PORTS[] = { 53, 67, 123, 161, 514, 5353, 4789, 22, 80, 443, 8080 };
+        bench::XorShift32 rng;
+        std::vector<Flow> flows(count);
+        for (Flow& flow : flows) {
+            const uint32_t r = rng.next();
+            flow.datagram.source = { 10, static_cast<uint8_t>(r >> 16), static_cast<uint8_t>(r >> 8), static_cast<uint8_t>(r) };
+            flow.datagram.destination = { 10, 23, 42, 10 };
+            const uint32_t pick = rng.next() % 100;
+            const uint16_t port = pick < 90 ? PORTS[pick % std::size(PORTS)] : static_cast<uint16_t>(20000 + pick);
+            flow.datagram.protocol = port == 22 || port == 80 || port == 443 || port == 8080 ? IPV4_PROTOCOL_TCP
+                                                                                            : IPV4_PROTOCOL_UDP;
+            const uint16_t source_port = static_cast<uint16_t>(32768 + (rng.next() & 0x7FFF));
+            flow.udp_header[0] = static_cast<std::byte>(source_port >> 8);
+            flow.udp_header[1] = static_cast<std::byte>(source_port & 0xFF);
+            flow.udp_header[2] = static_cast<std::byte>(port >> 8);
+            flow.udp_header[3] = static_cast<std::byte>(port & 0xFF);
+        }
+        for (Flow& flow : flows) {
+            flow.datagram.payload = flow.udp_header;
+        }
+        return flows;
+    }
+
+    // Packet i belongs to flow order[i].
+    std::vector<uint32_t> make_order(size_t flows, bool zipf)
+    {
+        bench::XorShift32 rng;
+        std::vector<uint32_t> order(PACKETS);
+        if (!zipf) {
+            for (uint32_t& index : order) {
+                index = rng.next() % static_cast<uint32_t>(flows);
+            }
+            return order;
+        }
+        std::vector<double> cumulative(flows);
+        double sum = 0;
+        for (size_t i = 0; i < flows; ++i) {
+            sum += 1.0 / static_cast<double>(i + 1);
+            cumulative[i] = sum;
+        }
+        for (uint32_t& index : order) {
+            const double u = static_cast<double>(rng.next()) / 4294967296.0 * sum;
+            index = static_cast<uint32_t>(std::lower_bound(cumulative.begin(), cumulative.end(), u) - cumulative.begin());
+            index = std::min(index, static_cast<uint32_t>(flows - 1));
+        }
+        return order;
+    }
+
+    struct Result {
+        double ns = 0;
+        double hit_rate = 0;
+        uint64_t wrong = 0;
+    };
+
+    template <size_t CacheEntries>
+    Result run(const std::vector<Flow>& flows, const std::vector<uint32_t>& order)
+    {
+        auto table = std::make_unique<Table<CacheEntries>>();
+        add_bindings(*table);
+
+        uint64_t checksum = 0;
+        const uint64_t start = bench::now_ns();
+        for (uint32_t index : order) {
+            const Target* target = table->classify(net::make_flow_key(flows[index].datagram));
+            checksum += target != nullptr ? target->id : 0;
+        }
+        const uint64_t elapsed = bench::now_ns() - start;
+        bench::do_not_optimize(checksum);
+
+        Result result{ static_cast<double>(elapsed) / static_cast<double>(order.size()), table->get_stats().hit_rate(), 0 };
+        for (size_t i = 0; i < std::min<size_t>(order.size(), 200'000); ++i) {
+            const net::FlowKey key = net::make_flow_key(flows[order[i]].datagram);
+            const Target* cached = table->classify(key);
+            const Target* searched = table->classify_uncached(key);
+            result.wrong += cached != searched ? 1 : 0;
+        }
+        return result;
+    }
+
+    Result run_uncached(const std::vector<Flow>& flows, const std::vector<uint32_t>& order)
+    {
+        auto table = std::make_unique<Table<0>>();
+        add_bindings(*table);
+        uint64_t checksum = 0;
+        const uint64_t start = bench::now_ns();
+        for (uint32_t index : order) {
+            const Target* target = table->classify_uncached(net::make_flow_key(flows[index].datagram));
+            checksum += target != nullptr ? target->id : 0;
+        }
+        bench::do_not_optimize(checksum);
+        return { static_cast<double>(bench::now_ns() - start) / static_cast<double>(order.size()), 0, 0 };
+    }
+
+}
+
+int main()
+{
+    std::printf("Flow classification, %zu bindings, %zu packets per case (key build + classify, ns/packet)\n",
+                BINDINGS, PACKETS);
+    std::printf("%-8s %7s %10s %20s %20s %8s\n", "traffic", "flows", "search", "cache 64 (hit %)", "cache 4096 (hit %)",
+                "wrong");
+    for (bool zipf : { false, true }) {
+        for (size_t flow_count : { 10, 100, 1'000, 10'000, 100'000 }) {
+            const std::vector<Flow> flows = make_flows(flow_count);
+            const std::vector<uint32_t> order = make_order(flow_count, zipf);
+            const Result search = run_uncached(flows, order);
+            const Result small = run<64>(flows, order);
+            const Result large = run<4096>(flows, order);
+            std::printf("%-8s %7zu %10.1f %11.1f (%5.1f%%) %11.1f (%5.1f%%) %8llu\n", zipf ? "zipf" : "uniform",
+                        flow_count, search.ns, small.ns, small.hit_rate * 100.0, large.ns, large.hit_rate * 100.0,
+                        static_cast<unsigned long long>(small.wrong + large.wrong));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,121 @@
+// Static-dispatch HAL policy vs. the out-of-line call path.
+//
+// Memory HALs isolate the call overhead. If NET_IFACE is set (and we may open
+// raw sockets), the real LinuxRawSocketHal is also compared against the
+// free-function hal_net_send path on that interface.
+
+#include "bench_common.hpp"
+#include "memory_hal.hpp"
+
+#include "hal/free_function_hal.hpp"
+#include "hal/linux_raw_socket_hal.hpp"
+#include "hal/hal_timer.hpp"
+#include "net_stack/byte_order.hpp"
+#include "net_stack/network_stack_impl.hpp"
+#include "protocols/arp.hpp"
+#include "protocols/ethernet.hpp"
+
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+    const net::NetworkConfig k_config = {
+        .mac_address = {0xF4, 0x7B, 0x09, 0x51, 0x91, 0x63},
+        .ipv4_address = {10, 23, 42, 10},
+        .gateway_address = {10, 23, 42, 1}};
+
+    // An ARP request for our address: each one costs a parse, a cache update and a reply.
+    std::array<std::byte, sizeof(EthernetHeader) + sizeof(ArpPacket)> make_arp_request_for_us()
+    {
+        std::array<std::byte, sizeof(EthernetHeader) + sizeof(ArpPacket)> frame{};
+        auto* eth = reinterpret_cast<EthernetHeader*>(frame.data());
+        auto* arp = reinterpret_cast<ArpPacket*>(frame.data() + sizeof(EthernetHeader));
+        const uint8_t peer_mac[6] = {0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0x01};
+        std::memset(eth->destination_mac, 0xFF, 6);
+        std::memcpy(eth->source_mac, peer_mac, 6);
+        eth->ethertype = net::net_htons16(ETHERTYPE_ARP);
+        arp->hardware_type = net::net_htons16(ARP_HW_TYPE_ETHERNET);
+        arp->protocol_type = net::net_htons16(ETHERTYPE_IPV4);
+        arp->hardware_addr_len = 6;
+        arp->protocol_addr_len = 4;
+        arp->opcode = net::net_htons16(ARP_OPCODE_REQUEST);
+        std::memcpy(arp->sender_mac, peer_mac, 6);
+        std::memcpy(arp->sender_ip, k_config.gateway_address.data(), 4);
+        std::memcpy(arp->target_ip, k_config.ipv4_address.data(), 4);
+        return frame;
+    }
+
+    template <typename Hal>
+    void run_memory_case(const char* label)
+    {
+        Hal hal;
+        net::BasicNetworkStack<Hal> stack(hal, &k_config);
+        const auto frame = make_arp_request_for_us();
+        hal.state.load_rx_frame(frame);
+
+        constexpr uint64_t send_iterations = 5'000'000;
+        double send_ns = bench::time_per_op_ns(send_iterations, [&](uint64_t) {
+            stack.send_arp_request_for_gateway();
+        });
+
+        // poll() drains BATCH frames per call: RX, dispatch, cache update, TX reply.
+        constexpr uint64_t BATCH = 64;
+        constexpr uint64_t polls = 50'000;
+        double poll_ns = bench::time_per_op_ns(polls, [&](uint64_t) {
+            hal.state.rx_pending = BATCH;
+            stack.poll();
+        }) / static_cast<double>(BATCH);
+        bench::do_not_optimize(hal.state.tx_frames);
+
+        char name[96];
+        std::snprintf(name, sizeof(name), "%s send_arp_request", label);
+        bench::report(name, send_ns);
+        std::snprintf(name, sizeof(name), "%s rx request + tx reply", label);
+        bench::report(name, poll_ns);
+    }
+
+    template <typename Hal>
+    double raw_socket_send_ns(Hal& hal)
+    {
+        net::BasicNetworkStack<Hal> stack(hal, &k_config);
+        constexpr uint64_t iterations = 200'000;
+        return bench::time_per_op_ns(iterations, [&](uint64_t) {
+            stack.send_arp_request_for_gateway();
+        });
+    }
+
+}
+
+int main()
+{
+    hal_timer_init();
+
+    std::printf("HAL call path: static policy vs. out-of-line\n");
+    run_memory_case<bench::InlineMemoryHal>("inline memory HAL     ");
+    run_memory_case<bench::OutOfLineMemoryHal>("out-of-line memory HAL");
+
+    const char* iface = std::getenv("NET_IFACE");
+    if (iface == nullptr || *iface == '\0') {
+        std::printf("(set NET_IFACE=<veth> to also compare the raw-socket send path)\n");
+        return 0;
+    }
+
+    LinuxRawSocketHal raw_hal;
+    if (raw_hal.init(&k_config, NetworkFiltering::ARP) != 0) {
+        std::printf("raw socket unavailable on %s; skipping\n", iface);
+        return 0;
+    }
+    bench::report("LinuxRawSocketHal send_arp_request", raw_socket_send_ns(raw_hal));
+    raw_hal.shutdown();
+
+    if (hal_net_init(&k_config, NetworkFiltering::ARP) != 0) {
+        return 0;
+    }
+    FreeFunctionHal free_hal;
+    bench::report("hal_net_send (free function) send_arp_request", raw_socket_send_ns(free_hal));
+    hal_net_shutdown();
+    return 0;
+}
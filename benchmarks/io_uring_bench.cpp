@@ -0,0 +1,166 @@
+// recv()/send() vs. io_uring on a real link.
+//
+// Needs a veth pair (or two cabled NICs) and raw-socket rights:
+//   ip link add vb0 type veth peer name vb1
+//   ip link set vb0 up && ip link set vb1 up
+//   NET_IFACE=vb0 NET_PEER_IFACE=vb1 ./io_uring_bench
+// A peer socket on NET_PEER_IFACE sends bursts of ARP requests for the
+// stack's address on NET_IFACE and collects the replies. The same
+// LinuxRawSocketHal serves both runs: first on recv()/send(), then after
+// enable_io_uring(). Reported per request: time in the stack's poll()
+// (receive, answer, and for io_uring the batched submit) and the whole
+// round trip including the peer's own syscalls, which are the same in both.
+// Leave the interfaces without IP addresses so the kernel stays quiet.
+
+#include "bench_common.hpp"
+#include "arp_frames.hpp"
+
+#include "hal/hal_timer.hpp"
+#include "hal/linux_raw_socket_hal.hpp"
+#include "net_stack/network_stack_impl.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+namespace {
+
+    constexpr std::array<uint8_t, 4> STACK_IP = {10, 99, 0, 1};
+    constexpr std::array<uint8_t, 4> PEER_IP = {10, 99, 0, 2};
+    constexpr uint64_t REQUESTS = 200'000;
+
+    struct Result {
+        double poll_ns = 0;
+        double round_trip_ns = 0;
+        uint64_t lost = 0;
+    };
+
+    // Replies for us; the peer socket also sees its own requests go out.
+    size_t drain_replies(LinuxRawSocketHal& peer)
+    {
+        std::array<std::byte, 1514> frame;
+        size_t replies = 0;
+        while (size_t n = peer.receive(frame.data(), frame.size())) {
+            const auto* arp = reinterpret_cast<const ArpPacket*>(frame.data() + sizeof(EthernetHeader));
+            if (n >= bench::ARP_FRAME_BYTES && net::net_ntohs16(arp->opcode) == ARP_OPCODE_REPLY &&
+                std::memcmp(arp->sender_ip, STACK_IP.data(), 4) == 0) {
+                ++replies;
+            }
+        }
+        return replies;
+    }
+
+    Result run(net::BasicNetworkStack<LinuxRawSocketHal>& stack, LinuxRawSocketHal& peer, size_t burst)
+    {
+        std::array<std::byte, bench::ARP_FRAME_BYTES> request{};
+        bench::write_arp(request.data(), ARP_OPCODE_REQUEST, peer.mac(), PEER_IP, STACK_IP);
+
+        const uint64_t rounds = REQUESTS / burst;
+        uint64_t poll_ns = 0;
+        uint64_t lost = 0;
+        const uint64_t start = bench::now_ns();
+        for (uint64_t round = 0; round < rounds; ++round) {
+            for (size_t i = 0; i < burst; ++i) {
+                (void)peer.send(request.data(), request.size());
+            }
+            size_t replies = 0;
+            for (int attempt = 0; replies < burst && attempt < 1000; ++attempt) {
+                const uint64_t poll_start = bench::now_ns();
+                (void)stack.poll();
+                poll_ns += bench::now_ns() - poll_start;
+                replies += drain_replies(peer);
+            }
+            lost += burst - replies;
+        }
+        const double requests = static_cast<double>(rounds * burst);
+        return { static_cast<double>(poll_ns) / requests,
+                 static_cast<double>(bench::now_ns() - start) / requests, lost };
+    }
+
+    // How long a wait() parked on the poll thread takes to notice wake().
+    double wake_us(LinuxRawSocketHal& hal)
+    {
+        constexpr int WAKES = 2'000;
+        std::atomic<uint64_t> woken_at{ 0 };
+        uint64_t total_ns = 0;
+        for (int i = 0; i < WAKES; ++i) {
+            std::thread waker([&] {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+                woken_at.store(bench::now_ns());
+                hal.wake();
+            });
+            while (woken_at.load() == 0) {
+                (void)hal.wait(1000);
+            }
+            total_ns += bench::now_ns() - woken_at.load();
+            waker.join();
+            woken_at.store(0);
+        }
+        return static_cast<double>(total_ns) / WAKES / 1e3;
+    }
+
+}
+
+int main()
+{
+    const char* iface = std::getenv("NET_IFACE");
+    const char* peer_iface = std::getenv("NET_PEER_IFACE");
+    if (iface == nullptr || peer_iface == nullptr) {
+        std::printf("set NET_IFACE and NET_PEER_IFACE to the two ends of a veth pair (see the top of this file)\n");
+        return 0;
+    }
+    hal_timer_init();
+
+    net::NetworkConfig stack_config = {
+        .mac_address = {},
+        .ipv4_address = STACK_IP,
+        .gateway_address = {},
+        .subnet_mask = {255, 255, 255, 0},
+        .interface_name = iface};
+    net::NetworkConfig peer_config = stack_config;
+    peer_config.ipv4_address = PEER_IP;
+    peer_config.interface_name = peer_iface;
+
+    LinuxRawSocketHal hal;
+    LinuxRawSocketHal peer;
+    if (hal.init(&stack_config, NetworkFiltering::ARP) != 0 || peer.init(&peer_config, NetworkFiltering::ARP) != 0) {
+        std::printf("raw sockets unavailable on %s/%s; skipping\n", iface, peer_iface);
+        return 0;
+    }
+    std::memcpy(stack_config.mac_address.data(), hal.mac(), 6);
+
+    auto stack = std::make_unique<net::BasicNetworkStack<LinuxRawSocketHal>>(hal, &stack_config);
+    net::ArpPolicy answer_everything;
+    answer_everything.reply_rate_per_sec = 0;
+    answer_everything.per_source_rate_per_sec = 0;
+    stack->get_arp_cache().set_policy(answer_everything);
+
+    std::printf("ARP request -> reply through BasicNetworkStack on %s, peer on %s, %llu requests per case\n",
+                iface, peer_iface, static_cast<unsigned long long>(REQUESTS));
+    std::printf("%-10s %6s %14s %18s %8s\n", "path", "burst", "poll ns/req", "round trip ns/req", "lost");
+
+    constexpr size_t BURSTS[] = { 1, 8, 32 };
+    for (int mode = 0; mode < 2; ++mode) {
+        if (mode == 1 && hal.enable_io_uring(64, 32) != 0) {
+            std::printf("io_uring unavailable; skipping\n");
+            break;
+        }
+        const char* label = mode == 0 ? "recv/send" : "io_uring";
+        (void)drain_replies(peer);
+        for (size_t burst : BURSTS) {
+            const Result result = run(*stack, peer, burst);
+            std::printf("%-10s %6zu %14.1f %18.1f %8llu\n", label, burst, result.poll_ns, result.round_trip_ns,
+                        static_cast<unsigned long long>(result.lost));
+        }
+        std::printf("%-10s wake() -> wait() returns: %.1f us\n", label, wake_us(hal));
+    }
+    if (hal.io_uring_enabled()) {
+        std::printf("io_uring send errors: %u, dropped on a full TX ring: %u\n", hal.io_uring_tx_errors(),
+                    hal.io_uring_tx_ring_full());
+    }
+    return 0;
+}
@@ -0,0 +1,206 @@
+// IPv4 fragment reassembly: throughput and behaviour under fragment floods.
+//
+// Packets go through Ipv4Input::process_packet() (header checks, checksum,
+// reassembly) with the stack's default MemoryConfig: slots and slot size as
+// configured, one slot per source.
+//   throughput  - 4000-byte datagrams in 3 fragments, in order, reversed,
+//                 and two datagrams interleaved
+//   flood       - a legitimate sensor sends a 3-fragment datagram now and
+//                 then while an attacker sends first fragments that never
+//                 complete, either from random spoofed sources or from one
+//                 source; 'gap' flood fragments arrive between the sensor's
+//                 fragments. Reported: sensor datagrams completed. With
+//                 spoofed sources the sensor survives while 'gap' is below
+//                 the slot count; a single source only recycles its own slot.
+//   holes       - tiny fragments with gaps, to exhaust hole descriptors
+// Time is simulated (1 ms per 100 packets) so timeouts are deterministic.
+
+#include "bench_common.hpp"
+
+#include "net_stack/byte_order.hpp"
+#include "net_stack/inet_checksum.hpp"
+#include "net_stack/ipv4_input.hpp"
+#include "protocols/ipv4.hpp"
+
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace {
+
+    constexpr std::array<uint8_t, 4> OUR_IP = {10, 23, 42, 10};
+    constexpr std::array<uint8_t, 4> SENSOR_IP = {10, 23, 42, 50};
+    constexpr size_t DATAGRAM_BYTES = 4000;
+    constexpr size_t FRAGMENT_BYTES = 1480;   // MTU 1500 minus the IP header
+    constexpr uint64_t DATAGRAMS = 200'000;
+    constexpr uint32_t PACKETS_PER_MS = 100;
+
+    using Packet = std::vector<std::byte>;
+
+    Packet make_fragment(const std::array<uint8_t, 4>& source, uint16_t id, size_t offset, size_t length, bool more)
+    {
+        Packet packet(IPV4_MIN_HEADER_LENGTH + length);
+        Ipv4Header header{};
+        header.version_ihl = 0x45;
+        header.total_length = net::net_htons16(static_cast<uint16_t>(packet.size()));
+        header.identification = net::net_htons16(id);
+        header.flags_fragment_offset = net::net_htons16(static_cast<uint16_t>((more ? IPV4_FLAG_MORE_FRAGMENTS : 0) | (offset / 8)));
+        header.ttl = 64;
+        header.protocol = IPV4_PROTOCOL_UDP;
+        std::memcpy(header.source_ip, source.data(), 4);
+        std::memcpy(header.destination_ip, OUR_IP.data(), 4);
+        std::memcpy(packet.data(), &header, sizeof(header));
+        const uint16_t checksum = net::internet_checksum(std::span<const std::byte>(packet.data(), sizeof(header)));
+        header.header_checksum = net::net_htons16(checksum);
+        std::memcpy(packet.data(), &header, sizeof(header));
+        for (size_t i = 0; i < length; ++i) {
+            packet[IPV4_MIN_HEADER_LENGTH + i] = static_cast<std::byte>((offset + i) & 0xFF);
+        }
+        return packet;
+    }
+
+    std::vector<Packet> split(const std::array<uint8_t, 4>& source, uint16_t id)
+    {
+        std::vector<Packet> fragments;
+        for (size_t offset = 0; offset < DATAGRAM_BYTES; offset += FRAGMENT_BYTES) {
+            const size_t length = std::min(FRAGMENT_BYTES, DATAGRAM_BYTES - offset);
+            fragments.push_back(make_fragment(source, id, offset, length, offset + length < DATAGRAM_BYTES));
+        }
+        return fragments;
+    }
+
+    struct Feeder {
+        std::unique_ptr<net::Ipv4Input> input = std::make_unique<net::Ipv4Input>();
+        uint64_t packets = 0;
+        uint64_t completed = 0;
+        uint64_t bad_payload = 0;
+
+        void feed(const Packet& packet)
+        {
+            const uint32_t now_ms = static_cast<uint32_t>(packets++ / PACKETS_PER_MS);
+            if (packets % PACKETS_PER_MS == 0) {
+                input->expire(now_ms);
+            }
+            const auto datagram = input->process_packet(packet, OUR_IP, now_ms);
+            if (datagram.has_value()) {
+                ++completed;
+                if (datagram->payload.size() != DATAGRAM_BYTES ||
+                    datagram->payload[DATAGRAM_BYTES - 1] != static_cast<std::byte>((DATAGRAM_BYTES - 1) & 0xFF)) {
+                    ++bad_payload;
+                }
+            }
+        }
+    };
+
+    void throughput_case(const char* label, const std::vector<size_t>& order, size_t datagrams_per_round)
+    {
+        std::vector<std::vector<Packet>> datagrams;
+        for (size_t d = 0; d < datagrams_per_round; ++d) {
+            datagrams.push_back(split({10, 23, 42, static_cast<uint8_t>(50 + d)}, static_cast<uint16_t>(d)));
+        }
+
+        Feeder feeder;
+        const uint64_t rounds = DATAGRAMS / datagrams_per_round;
+        const uint64_t start = bench::now_ns();
+        for (uint64_t r = 0; r < rounds; ++r) {
+            for (size_t index : order) {
+                feeder.feed(datagrams[index % datagrams_per_round][index / datagrams_per_round]);
+            }
+        }
+        const double ns = static_cast<double>(bench::now_ns() - start) / static_cast<double>(rounds * datagrams_per_round);
+        std::printf("%-34s %8.1f ns/datagram %8.0f MB/s  completed %llu/%llu  bad %llu\n", label, ns,
+                    static_cast<double>(DATAGRAM_BYTES) * 1e3 / ns,
+                    static_cast<unsigned long long>(feeder.completed),
+                    static_cast<unsigned long long>(rounds * datagrams_per_round),
+                    static_cast<unsigned long long>(feeder.bad_payload));
+    }
+
+    void flood_case(bool spoofed, size_t gap)
+    {
+        constexpr uint64_t SENSOR_DATAGRAMS = 10'000;
+        constexpr size_t FLOOD_PER_DATAGRAM = 50;
+
+        bench::XorShift32 rng;
+        Feeder feeder;
+        uint16_t flood_id = 0;
+        auto flood = [&] {
+            std::array<uint8_t, 4> source = {203, 0, 113, 66};
+            if (spoofed) {
+                const uint32_t r = rng.next();
+                source = {static_cast<uint8_t>(r >> 24), static_cast<uint8_t>(r >> 16), static_cast<uint8_t>(r >> 8),
+                          static_cast<uint8_t>(r)};
+            }
+            static Packet packet = make_fragment(source, 0, 0, FRAGMENT_BYTES, true);
+            Ipv4Header header;
+            std::memcpy(&header, packet.data(), sizeof(header));
+            std::memcpy(header.source_ip, source.data(), 4);
+            header.identification = net::net_htons16(++flood_id);
+            header.header_checksum = 0;
+            std::memcpy(packet.data(), &header, sizeof(header));
+            header.header_checksum = net::net_htons16(net::internet_checksum(std::span<const std::byte>(packet.data(), sizeof(header))));
+            std::memcpy(packet.data(), &header, sizeof(header));
+            feeder.feed(packet);
+        };
+
+        const uint64_t start = bench::now_ns();
+        for (uint64_t d = 0; d < SENSOR_DATAGRAMS; ++d) {
+            const std::vector<Packet> fragments = split(SENSOR_IP, static_cast<uint16_t>(d));
+            for (size_t i = 0; i < FLOOD_PER_DATAGRAM - gap * (fragments.size() - 1); ++i) flood();
+            for (size_t f = 0; f < fragments.size(); ++f) {
+                feeder.feed(fragments[f]);
+                if (f + 1 < fragments.size()) {
+                    for (size_t i = 0; i < gap; ++i) flood();
+                }
+            }
+        }
+        const double ns = static_cast<double>(bench::now_ns() - start) / static_cast<double>(feeder.packets);
+
+        const net::ReassemblyStats& stats = feeder.input->get_reassembler().get_stats();
+        std::printf("%-8s flood, gap %zu: sensor %5llu/%llu complete  %6.1f ns/packet  evicted %u  source-limited %u  timeouts %u\n",
+                    spoofed ? "spoofed" : "1-source", gap,
+                    static_cast<unsigned long long>(feeder.completed), static_cast<unsigned long long>(SENSOR_DATAGRAMS),
+                    ns, stats.evicted, stats.source_limited, stats.timeouts);
+    }
+
+    // 8-byte fragments every 16 bytes: each one adds a hole until the slot gives up.
+    void hole_case()
+    {
+        constexpr uint64_t DATAGRAMS_SENT = 100'000;
+        Feeder feeder;
+        const uint64_t start = bench::now_ns();
+        for (uint64_t d = 0; d < DATAGRAMS_SENT; ++d) {
+            for (size_t offset = 16; offset < 16 * 12; offset += 16) {
+                feeder.feed(make_fragment({198, 51, 100, 7}, static_cast<uint16_t>(d), offset, 8, true));
+            }
+        }
+        const double ns = static_cast<double>(bench::now_ns() - start) / static_cast<double>(feeder.packets);
+        const net::ReassemblyStats& stats = feeder.input->get_reassembler().get_stats();
+        std::printf("hole exhaustion: %llu fragments, %.1f ns/packet (incl. building), too many holes %u, slots in use %zu\n",
+                    static_cast<unsigned long long>(feeder.packets), ns, stats.too_many_holes,
+                    feeder.input->get_reassembler().slots_in_use());
+    }
+
+}
+
+int main()
+{
+    std::printf("IPv4 reassembly: %zu slots of %zu bytes, %zu-byte datagrams in %zu-byte fragments\n",
+                net::Ipv4Reassembler::slot_count(), net::Ipv4Reassembler::max_datagram_bytes(), DATAGRAM_BYTES,
+                FRAGMENT_BYTES);
+
+    // Fragment index i of datagram d is encoded as i * datagrams + d.
+    throughput_case("in order", {0, 1, 2}, 1);
+    throughput_case("reversed", {2, 1, 0}, 1);
+    throughput_case("two interleaved", {0, 1, 2, 3, 4, 5}, 2);
+
+    for (bool spoofed : {true, false}) {
+        for (size_t gap : {0, 1, 2, 4}) {
+            flood_case(spoofed, gap);
+        }
+    }
+    hole_case();
+    return 0;
+}
@@ -0,0 +1,23 @@
+#ifndef BENCHMARKS_LARGE_MEMORY_H
+#define BENCHMARKS_LARGE_MEMORY_H
+
+// MemoryConfig of the benchmarks that need more than the default 40 KB:
+// room for 10k owned addresses with 1k MACs (proxy_arp_bench) and 4096
+// outstanding sweep requests (arp_sweep_bench). CMakeLists.txt builds a copy
+// of the core with it (NET_MEMORY_CONFIG_HEADER); included by
+// net_stack/memory_config.hpp.
+
+namespace bench {
+
+    inline constexpr net::MemoryConfig large_memory = [] {
+        net::MemoryConfig config;
+        config.owned_address_slots = 16384;
+        config.owned_macs = 1024;
+        config.arp_sweep_in_flight = 4096;
+        config.ram_budget_bytes = 1024 * 1024;
+        return config;
+    }();
+
+}
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef BENCHMARKS_MEMORY_HAL_H
+#define BENCHMARKS_MEMORY_HAL_H
+
+// In-memory HAL policies for benchmarks: receive() replays one canned frame a
+// configurable number of times and send() just counts. No syscalls, so the
+// numbers isolate the stack's own cost.
+
+#include "bench_common.hpp"
+#include "hal/hal_network.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+namespace bench {
+
+    struct MemoryHalState {
+        std::array<std::byte, 1514> rx_frame{};
+        size_t rx_length = 0;
+        uint64_t rx_pending = 0;   // frames left to hand out
+        uint64_t tx_frames = 0;
+        uint64_t tx_bytes = 0;
+
+        void load_rx_frame(std::span<const std::byte> frame)
+        {
+            std::memcpy(rx_frame.data(), frame.data(), frame.size());
+            rx_length = frame.size();
+        }
+    };
+
+    // Everything visible to the compiler: the stack inlines it.
+    class InlineMemoryHal {
+    public:
+        MemoryHalState state;
+
+        int send(const void* data, size_t length)
+        {
+            do_not_optimize(data); // the frame must really be built
+            ++state.tx_frames;
+            state.tx_bytes += length;
+            return 0;
+        }
+
+        size_t receive(void* buffer, size_t max_length)
+        {
+            if (state.rx_pending == 0 || state.rx_length > max_length) return 0;
+            --state.rx_pending;
+            std::memcpy(buffer, state.rx_frame.data(), state.rx_length);
+            return state.rx_length;
+        }
+
+        bool wait(uint32_t) { return state.rx_pending != 0; }
+    };
+
+    // Same behaviour, but defined in out_of_line_hal.cpp: every send/receive
+    // is an opaque call, as with the original hal_net_* free functions.
+    class OutOfLineMemoryHal {
+    public:
+        MemoryHalState state;
+
+        int send(const void* data, size_t length);
+        size_t receive(void* buffer, size_t max_length);
+        bool wait(uint32_t timeout_ms);
+    };
+
+    static_assert(NetworkHal<InlineMemoryHal>);
+    static_assert(NetworkHal<OutOfLineMemoryHal>);
+
+}
+
+#endif
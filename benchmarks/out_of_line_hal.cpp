@@ -0,0 +1,28 @@
+// Kept in its own translation unit so the compiler cannot inline it into the stack.
+
+#include "memory_hal.hpp"
+
+namespace bench {
+
+    int OutOfLineMemoryHal::send(const void* data, size_t length)
+    {
+        do_not_optimize(data);
+        ++state.tx_frames;
+        state.tx_bytes += length;
+        return 0;
+    }
+
+    size_t OutOfLineMemoryHal::receive(void* buffer, size_t max_length)
+    {
+        if (state.rx_pending == 0 || state.rx_length > max_length) return 0;
+        --state.rx_pending;
+        std::memcpy(buffer, state.rx_frame.data(), state.rx_length);
+        return state.rx_length;
+    }
+
+    bool OutOfLineMemoryHal::wait(uint32_t)
+    {
+        return state.rx_pending != 0;
+    }
+
+}
@@ -0,0 +1,125 @@
+// Dispatch cost of the compile-time protocol registry as protocols are added,
+// compared with the linear EtherType if-chain it replaces.
+
+#include "bench_common.hpp"
+#include "net_stack/protocol_dispatch.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <utility>
+
+namespace {
+
+    // Real EtherTypes, so the perfect hash is exercised on realistic keys.
+    constexpr std::array<uint16_t, 16> k_ethertypes = {
+        0x0806, 0x0800, 0x86DD, 0x8100, 0x88CC, 0x8847, 0x8848, 0x88A8,
+        0x8863, 0x8864, 0x88E5, 0x88F7, 0x8035, 0x809B, 0x88B5, 0x9000,
+    };
+
+    struct BenchContext {
+        uint64_t handled = 0;
+    };
+
+    template <uint16_t EtherType>
+    struct CountingHandler {
+        static constexpr uint16_t ethertype = EtherType;
+
+        template <typename Context>
+        static void handle(Context& ctx, std::span<const std::byte> payload)
+        {
+            ctx.handled += payload.size();
+        }
+    };
+
+    template <size_t... I>
+    auto make_dispatcher(std::index_sequence<I...>)
+        -> net::ProtocolDispatcher<BenchContext, CountingHandler<k_ethertypes[I]>...>;
+
+    template <size_t N>
+    using DispatcherOf = decltype(make_dispatcher(std::make_index_sequence<N>{}));
+
+    // The shape of the old process_incoming_frame(): compare against each
+    // protocol in turn until one matches.
+    template <size_t N>
+    bool if_chain_dispatch(BenchContext& ctx, uint16_t ethertype, std::span<const std::byte> payload)
+    {
+        for (size_t i = 0; i < N; ++i) {
+            if (ethertype == k_ethertypes[i]) {
+                ctx.handled += payload.size();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    constexpr size_t STREAM_LENGTH = 4096;
+
+    // Mixed stream: registered protocols uniformly, plus ~10% unknown EtherTypes.
+    template <size_t N>
+    std::array<uint16_t, STREAM_LENGTH> make_stream()
+    {
+        std::array<uint16_t, STREAM_LENGTH> stream{};
+        bench::XorShift32 rng;
+        for (auto& type : stream) {
+            uint32_t r = rng.next();
+            type = (r % 10 == 0) ? static_cast<uint16_t>(0xA000 + (r & 0xFF))
+                                 : k_ethertypes[(r >> 8) % N];
+        }
+        return stream;
+    }
+
+    template <size_t N>
+    void run_case()
+    {
+        using Dispatcher = DispatcherOf<N>;
+        const auto stream = make_stream<N>();
+        std::array<std::byte, 64> payload_storage{};
+        const std::span<const std::byte> payload(payload_storage);
+        constexpr uint64_t iterations = 20'000'000;
+
+        BenchContext ctx;
+        uint64_t dropped = 0;
+        double registry_ns = bench::time_per_op_ns(iterations, [&](uint64_t i) {
+            if (!Dispatcher::dispatch(ctx, stream[i % STREAM_LENGTH], payload)) {
+                ++dropped;
+            }
+        });
+        bench::do_not_optimize(ctx.handled);
+        bench::do_not_optimize(dropped);
+
+        BenchContext chain_ctx;
+        uint64_t chain_dropped = 0;
+        double chain_ns = bench::time_per_op_ns(iterations, [&](uint64_t i) {
+            if (!if_chain_dispatch<N>(chain_ctx, stream[i % STREAM_LENGTH], payload)) {
+                ++chain_dropped;
+            }
+        });
+        bench::do_not_optimize(chain_ctx.handled);
+        bench::do_not_optimize(chain_dropped);
+
+        char name[64];
+        if constexpr (Dispatcher::linear) {
+            std::snprintf(name, sizeof(name), "registry  protocols=%-2zu linear", N);
+        } else {
+            std::snprintf(name, sizeof(name), "registry  protocols=%-2zu table=%zu", N, Dispatcher::table_size());
+        }
+        bench::report(name, registry_ns);
+        std::snprintf(name, sizeof(name), "if-chain  protocols=%-2zu", N);
+        bench::report(name, chain_ns);
+    }
+
+}
+
+int main()
+{
+    std::printf("Protocol dispatch cost per frame (10%% unknown EtherTypes)\n");
+    run_case<1>();
+    run_case<2>();
+    run_case<4>();
+    run_case<8>();
+    run_case<16>();
+    return 0;
+}
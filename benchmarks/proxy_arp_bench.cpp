@@ -0,0 +1,224 @@
+// Proxy ARP: answering for 10k owned addresses, each with one of 1k MACs.
+//
+// First the lookup alone: the owned-address table (hash for single
+// addresses, range list) against a linear memcmp scan, which is what
+// comparing the target with one configured address grows into. Then ARP
+// requests through BasicNetworkStack::poll() with 10k owned addresses as
+// single entries and as one range, for addresses that are not ours, and for
+// the stack's own address only (as before). Built against a copy of the
+// core with a larger MemoryConfig (large_memory.hpp). Every owned
+// address is asked for once first and its reply checked.
+
+#include "bench_common.hpp"
+#include "arp_frames.hpp"
+
+#include "hal/hal_timer.hpp"
+#include "net_stack/network_stack_impl.hpp"
+#include "net_stack/owned_addresses.hpp"
+
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace {
+
+    constexpr size_t OWNED = 10'000;
+    constexpr size_t MACS = 1'000;
+    constexpr size_t LOOKUPS = 1 << 22;
+    constexpr uint64_t REQUESTS = 2'000'000;
+    constexpr uint32_t OWNED_BASE = (10u << 24) | (200u << 16);       // 10.200.0.0
+    constexpr uint32_t NOT_OWNED_BASE = (10u << 24) | (201u << 16);   // 10.201.0.0
+
+    const net::NetworkConfig k_config = {
+        .mac_address = {0xF4, 0x7B, 0x09, 0x51, 0x91, 0x63},
+        .ipv4_address = {10, 23, 42, 10},
+        .gateway_address = {10, 23, 42, 1},
+        .subnet_mask = {255, 0, 0, 0}};
+
+    constexpr uint8_t REQUESTER_MAC[6] = {0x02, 0xAA, 0x00, 0x00, 0x00, 0x01};
+    constexpr std::array<uint8_t, 4> REQUESTER_IP = {10, 1, 0, 1};
+
+    std::array<uint8_t, 4> to_bytes(uint32_t address)
+    {
+        return {static_cast<uint8_t>(address >> 24), static_cast<uint8_t>(address >> 16),
+                static_cast<uint8_t>(address >> 8), static_cast<uint8_t>(address)};
+    }
+
+    std::array<uint8_t, 6> owned_mac(size_t index)
+    {
+        const size_t id = index % MACS;
+        return {0x02, 0xBB, 0x00, 0x00, static_cast<uint8_t>(id >> 8), static_cast<uint8_t>(id)};
+    }
+
+    // Replays pre-built requests; sends are replies, the last one kept.
+    class RequestHal {
+    public:
+        std::vector<std::array<std::byte, bench::ARP_FRAME_BYTES>> frames;
+        uint64_t rx_pending = 0;
+        uint64_t next = 0;
+        uint64_t tx_frames = 0;
+        std::array<std::byte, bench::ARP_FRAME_BYTES> last_tx{};
+
+        int send(const void* data, size_t length)
+        {
+            std::memcpy(last_tx.data(), data, std::min(length, last_tx.size()));
+            ++tx_frames;
+            return 0;
+        }
+
+        size_t receive(void* buffer, size_t max_length)
+        {
+            if (rx_pending == 0 || max_length < bench::ARP_FRAME_BYTES) return 0;
+            --rx_pending;
+            std::memcpy(buffer, frames[next++ % frames.size()].data(), bench::ARP_FRAME_BYTES);
+            return bench::ARP_FRAME_BYTES;
+        }
+
+        bool wait(uint32_t) { return rx_pending != 0; }
+    };
+
+    using Stack = net::BasicNetworkStack<RequestHal>;
+
+    void load_requests(RequestHal& hal, const std::vector<uint32_t>& targets)
+    {
+        hal.frames.resize(targets.size());
+        for (size_t i = 0; i < targets.size(); ++i) {
+            bench::write_arp(hal.frames[i].data(), ARP_OPCODE_REQUEST, REQUESTER_MAC, REQUESTER_IP, to_bytes(targets[i]));
+        }
+        hal.next = 0;
+    }
+
+    std::vector<uint32_t> shuffled_targets(uint32_t base, size_t count, size_t length)
+    {
+        bench::XorShift32 rng;
+        std::vector<uint32_t> targets(length);
+        for (uint32_t& target : targets) {
+            target = base + rng.next() % static_cast<uint32_t>(count);
+        }
+        return targets;
+    }
+
+    // ns per request through poll(), and the replies sent per request.
+    std::pair<double, double> run_requests(Stack& stack, RequestHal& hal, const std::vector<uint32_t>& targets)
+    {
+        load_requests(hal, targets);
+        hal.tx_frames = 0;
+        hal.rx_pending = REQUESTS;
+        const uint64_t start = bench::now_ns();
+        while (stack.poll() != 0) {
+        }
+        const double ns = static_cast<double>(bench::now_ns() - start) / static_cast<double>(REQUESTS);
+        return { ns, static_cast<double>(hal.tx_frames) / static_cast<double>(REQUESTS) };
+    }
+
+    // Asks once for every owned address; counts replies with the wrong sender.
+    size_t check_replies(Stack& stack, RequestHal& hal, bool single_entries)
+    {
+        size_t wrong = 0;
+        for (size_t i = 0; i < OWNED; ++i) {
+            load_requests(hal, { OWNED_BASE + static_cast<uint32_t>(i) });
+            hal.tx_frames = 0;
+            hal.rx_pending = 1;
+            (void)stack.poll();
+            const auto* arp = reinterpret_cast<const ArpPacket*>(hal.last_tx.data() + sizeof(EthernetHeader));
+            const std::array<uint8_t, 6> expected = single_entries ? owned_mac(i) : owned_mac(MACS);
+            const std::array<uint8_t, 4> ip = to_bytes(OWNED_BASE + static_cast<uint32_t>(i));
+            if (hal.tx_frames != 1 || std::memcmp(arp->sender_mac, expected.data(), 6) != 0 ||
+                std::memcmp(arp->sender_ip, ip.data(), 4) != 0) {
+                ++wrong;
+            }
+        }
+        return wrong;
+    }
+
+    void lookup_benchmarks()
+    {
+        using Table = Stack::OwnedAddresses;
+        auto table = std::make_unique<Table>();
+        auto ranged = std::make_unique<Table>();
+        std::vector<std::array<uint8_t, 4>> linear(OWNED);
+        for (size_t i = 0; i < OWNED; ++i) {
+            linear[i] = to_bytes(OWNED_BASE + static_cast<uint32_t>(i));
+            (void)table->add(linear[i], owned_mac(i));
+        }
+        (void)ranged->add_range(to_bytes(OWNED_BASE), OWNED, owned_mac(MACS));
+
+        // Half owned, half not.
+        bench::XorShift32 rng;
+        std::vector<uint32_t> queries(LOOKUPS);
+        for (uint32_t& query : queries) {
+            query = (rng.next() & 1 ? OWNED_BASE : NOT_OWNED_BASE) + rng.next() % static_cast<uint32_t>(OWNED);
+        }
+
+        uint64_t found = 0;
+        bench::report("lookup: owned table, 10k single addresses", bench::time_per_op_ns(LOOKUPS, [&](uint64_t i) {
+            found += table->find(queries[i]) != nullptr;
+        }));
+        bench::report("lookup: owned table, one range of 10k", bench::time_per_op_ns(LOOKUPS, [&](uint64_t i) {
+            found += ranged->find(queries[i]) != nullptr;
+        }));
+        constexpr uint64_t LINEAR_LOOKUPS = LOOKUPS / 256;
+        bench::report("lookup: linear memcmp scan of 10k", bench::time_per_op_ns(LINEAR_LOOKUPS, [&](uint64_t i) {
+            const std::array<uint8_t, 4> target = to_bytes(queries[i]);
+            for (const auto& address : linear) {
+                if (std::memcmp(address.data(), target.data(), 4) == 0) {
+                    ++found;
+                    break;
+                }
+            }
+        }));
+        bench::do_not_optimize(found);
+    }
+
+}
+
+int main()
+{
+    hal_timer_init();
+    std::printf("Proxy ARP, %zu owned addresses, %zu MACs, %llu requests per stack case\n", OWNED, MACS,
+                static_cast<unsigned long long>(REQUESTS));
+    lookup_benchmarks();
+
+    net::ArpPolicy answer_everything;
+    answer_everything.reply_rate_per_sec = 0;
+    answer_everything.per_source_rate_per_sec = 0;
+
+    RequestHal hal;
+    auto stack = std::make_unique<Stack>(hal, &k_config);
+    stack->get_arp_cache().set_policy(answer_everything);
+
+    const std::vector<uint32_t> own_ip = { net::BasicOwnedAddressTable<{}>::to_u32(k_config.ipv4_address) };
+    const std::vector<uint32_t> owned = shuffled_targets(OWNED_BASE, OWNED, 1 << 16);
+    const std::vector<uint32_t> not_owned = shuffled_targets(NOT_OWNED_BASE, OWNED, 1 << 16);
+
+    auto report = [](const char* name, std::pair<double, double> result) {
+        std::printf("%-48s %10.2f ns/req %11.0f req/s %6.2f replies/req\n", name, result.first,
+                    1e9 / result.first, result.second);
+    };
+
+    report("poll: own address only (no owned table)", run_requests(*stack, hal, own_ip));
+
+    for (size_t i = 0; i < OWNED; ++i) {
+        if (!stack->get_owned_addresses().add(to_bytes(OWNED_BASE + static_cast<uint32_t>(i)), owned_mac(i))) {
+            std::printf("owned address table full at %zu\n", i);
+            return 1;
+        }
+    }
+    const size_t wrong_single = check_replies(*stack, hal, true);
+    report("poll: 10k single owned addresses", run_requests(*stack, hal, owned));
+    report("poll: 10k single owned, requests for others", run_requests(*stack, hal, not_owned));
+    report("poll: 10k single owned, own address", run_requests(*stack, hal, own_ip));
+
+    for (size_t i = 0; i < OWNED; ++i) {
+        (void)stack->get_owned_addresses().remove(to_bytes(OWNED_BASE + static_cast<uint32_t>(i)));
+    }
+    (void)stack->get_owned_addresses().add_range(to_bytes(OWNED_BASE), OWNED, owned_mac(MACS));
+    const size_t wrong_range = check_replies(*stack, hal, false);
+    report("poll: one owned range of 10k", run_requests(*stack, hal, owned));
+    report("poll: one owned range, requests for others", run_requests(*stack, hal, not_owned));
+
+    std::printf("wrong or missing replies: %zu (single), %zu (range)\n", wrong_single, wrong_range);
+    return wrong_single + wrong_range == 0 ? 0 : 1;
+}
@@ -0,0 +1,175 @@
+// Longest-prefix match: compiled poptrie vs. a linear scan over the routes,
+// at 10, 1k and 100k routes, plus the stack's per-destination next-hop cache.
+//
+// Routes follow a BGP-like length mix (mostly /24, some /16-/23, a few
+// shorter) over 16 gateways. Destinations are half inside a route, half
+// uniformly random, pre-generated so the loop measures only the lookup.
+// Every poptrie answer is checked against the linear scan on a sample.
+
+#include "bench_common.hpp"
+
+#include "hal/hal_timer.hpp"
+#include "net_stack/network_stack_impl.hpp"
+#include "net_stack/routing_table.hpp"
+
+#include <array>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+namespace {
+
+    constexpr size_t LOOKUPS = 1 << 20;
+    constexpr size_t CHECKED = 1 << 14;
+    constexpr size_t GATEWAYS = 16;
+
+    constexpr net::RoutingTableLimits SMALL = {
+        .routes = 16, .nodes = 64, .leaves = 1024, .next_hops = GATEWAYS + 1, .direct_bits = 8};
+    constexpr net::RoutingTableLimits LARGE = {
+        .routes = 1 << 17, .nodes = 1 << 18, .leaves = 1 << 21, .next_hops = GATEWAYS + 1, .direct_bits = 16};
+
+    std::vector<net::Route> make_routes(size_t count, bench::XorShift32& rng)
+    {
+        std::vector<net::Route> routes;
+        routes.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            const uint32_t mix = rng.next() % 100;
+            const uint8_t length = mix < 2 ? static_cast<uint8_t>(8 + rng.next() % 8)
+                                 : mix < 40 ? static_cast<uint8_t>(16 + rng.next() % 8) : 24;
+            uint32_t prefix = rng.next();
+            prefix = (prefix & 0x00FFFFFFu) | ((1 + prefix % 223) << 24);
+            net::Route route;
+            route.prefix = net::BasicRoutingTable<SMALL>::to_bytes(prefix);
+            route.prefix_length = length;
+            route.gateway = {10, 0, 0, static_cast<uint8_t>(1 + rng.next() % GATEWAYS)};
+            routes.push_back(route);
+        }
+        return routes;
+    }
+
+    std::vector<uint32_t> make_destinations(const std::vector<net::Route>& routes, bench::XorShift32& rng)
+    {
+        std::vector<uint32_t> destinations(LOOKUPS);
+        for (size_t i = 0; i < LOOKUPS; ++i) {
+            if (i % 2 == 0) {
+                const net::Route& route = routes[rng.next() % routes.size()];
+                const uint32_t host_bits = route.prefix_length >= 32 ? 0 : (~uint32_t{ 0 } >> route.prefix_length);
+                destinations[i] = (net::BasicRoutingTable<SMALL>::to_u32(route.prefix) & ~host_bits) | (rng.next() & host_bits);
+            }
+            else {
+                destinations[i] = rng.next();
+            }
+        }
+        return destinations;
+    }
+
+    // Reference: the longest matching route's gateway, 0 if none.
+    uint32_t linear_lookup(const std::vector<net::Route>& routes, uint32_t address)
+    {
+        int best_length = -1;
+        uint32_t gateway = 0;
+        for (const net::Route& route : routes) {
+            const uint32_t mask = route.prefix_length == 0 ? 0 : ~uint32_t{ 0 } << (32 - route.prefix_length);
+            if ((address & mask) == (net::BasicRoutingTable<SMALL>::to_u32(route.prefix) & mask) &&
+                route.prefix_length >= best_length) { // later duplicates win, as in assign()
+                best_length = route.prefix_length;
+                gateway = net::BasicRoutingTable<SMALL>::to_u32(route.gateway);
+            }
+        }
+        return gateway;
+    }
+
+    template <net::RoutingTableLimits Limits>
+    void lpm_case(size_t route_count, bool with_linear)
+    {
+        bench::XorShift32 rng;
+        const std::vector<net::Route> routes = make_routes(route_count, rng);
+        const std::vector<uint32_t> destinations = make_destinations(routes, rng);
+
+        auto table = std::make_unique<net::BasicRoutingTable<Limits>>();
+        const uint64_t build_start = bench::now_ns();
+        if (!table->assign(routes)) {
+            std::printf("%zu routes: table capacity exceeded\n", route_count);
+            return;
+        }
+        const double build_ms = static_cast<double>(bench::now_ns() - build_start) / 1e6;
+
+        size_t mismatches = 0;
+        for (size_t i = 0; i < CHECKED; ++i) {
+            const uint16_t hop = table->lookup(destinations[i]);
+            const uint32_t got = hop == 0 ? 0 : table->next_hop_address(hop);
+            mismatches += got != linear_lookup(routes, destinations[i]) ? 1 : 0;
+        }
+
+        std::printf("%6zu routes: compiled in %7.2f ms, %6zu nodes, %7zu leaves, %8zu bytes (direct 2^%u), %zu mismatches\n",
+                    route_count, build_ms, table->node_count(), table->leaf_count(), table->compiled_bytes(),
+                    Limits.direct_bits, mismatches);
+
+        char name[64];
+        std::snprintf(name, sizeof(name), "poptrie lookup, %zu routes", route_count);
+        bench::report(name, bench::time_per_op_ns(LOOKUPS, [&](uint64_t i) {
+            bench::do_not_optimize(table->lookup(destinations[i]));
+        }));
+        if (with_linear) {
+            std::snprintf(name, sizeof(name), "linear scan, %zu routes", route_count);
+            bench::report(name, bench::time_per_op_ns(LOOKUPS / 16, [&](uint64_t i) {
+                bench::do_not_optimize(linear_lookup(routes, destinations[i]));
+            }));
+        }
+    }
+
+    class NullHal {
+    public:
+        int send(const void*, size_t) { return 0; }
+        size_t receive(void*, size_t) { return 0; }
+        bool wait(uint32_t) { return false; }
+    };
+
+    // What a sender pays per frame to find the destination MAC: routing +
+    // ArpCache scan, vs. the memoised next-hop cache in front of them.
+    void next_hop_cache_case()
+    {
+        const net::NetworkConfig config = {
+            .mac_address = {0xF4, 0x7B, 0x09, 0x51, 0x91, 0x63},
+            .ipv4_address = {10, 23, 42, 10},
+            .gateway_address = {10, 23, 42, 1}};
+        NullHal hal;
+        net::BasicNetworkStack<NullHal> stack(hal, &config);
+        net::ArpCache& arp = stack.get_arp_cache();
+        (void)arp.add_or_update_entry(config.gateway_address, {0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0x01}, net::ArpEntryState::RESOLVED);
+        for (uint8_t i = 0; i < 8; ++i) {
+            (void)arp.add_or_update_entry({10, 23, 42, static_cast<uint8_t>(100 + i)}, {0xAA, 0xBB, 0xCC, 0, 0, i},
+                                          net::ArpEntryState::RESOLVED);
+        }
+
+        // 4 neighbours and 4 remote hosts behind the gateway.
+        std::array<std::array<uint8_t, 4>, 8> destinations;
+        for (uint8_t i = 0; i < 4; ++i) {
+            destinations[i] = {10, 23, 42, static_cast<uint8_t>(100 + i)};
+            destinations[4 + i] = {93, 184, 216, static_cast<uint8_t>(i)};
+        }
+
+        bench::report("route + ARP lookup (uncached)", bench::time_per_op_ns(LOOKUPS, [&](uint64_t i) {
+            const auto hop = stack.get_routing_table().next_hop(destinations[i % destinations.size()]);
+            bench::do_not_optimize(arp.lookup(*hop));
+        }));
+        bench::report("next_hop_mac() (next-hop cache)", bench::time_per_op_ns(LOOKUPS, [&](uint64_t i) {
+            bench::do_not_optimize(stack.next_hop_mac(destinations[i % destinations.size()]));
+        }));
+        const net::NextHopCacheStats& stats = stack.get_next_hop_cache_stats();
+        std::printf("next-hop cache: %llu hits, %llu misses, MAC %llu hits, %llu misses\n",
+                    static_cast<unsigned long long>(stats.hits), static_cast<unsigned long long>(stats.misses),
+                    static_cast<unsigned long long>(stats.mac_hits), static_cast<unsigned long long>(stats.mac_misses));
+    }
+
+}
+
+int main()
+{
+    hal_timer_init();
+    lpm_case<SMALL>(10, true);
+    lpm_case<LARGE>(1000, true);
+    lpm_case<LARGE>(100'000, false);
+    next_hop_cache_case();
+    return 0;
+}
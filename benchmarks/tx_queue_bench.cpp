@@ -0,0 +1,207 @@
+// Cross-thread TX: lock-free submission queue vs. a mutex around HAL::send.
+//
+// N producer threads each push small frames; the main thread runs poll(),
+// which drains the queue into a HAL that burns SEND_COST_NS per frame (a
+// stand-in for the send syscall). Reported per case: submit latency
+// (sampled, including retries while the queue is full), aggregate
+// throughput and how often producers hit backpressure.
+//   stack     - BasicNetworkStack::submit_frame() with the configured queue
+//   queue-1k  - the same MpscQueue with 1024 slots, drained by hand
+//   mutex     - what callers would otherwise do: lock, send, unlock
+// Scaling needs spare cores: with fewer cores than producers + 1 the
+// numbers mostly measure the scheduler.
+
+#include "bench_common.hpp"
+
+#include "hal/hal_timer.hpp"
+#include "net_stack/network_stack_impl.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    const net::NetworkConfig k_config = {
+        .mac_address = {0xF4, 0x7B, 0x09, 0x51, 0x91, 0x63},
+        .ipv4_address = {10, 23, 42, 10},
+        .gateway_address = {10, 23, 42, 1}};
+
+    constexpr uint64_t TOTAL_FRAMES = 1'000'000;
+    constexpr size_t FRAME_BYTES = 64;
+    constexpr uint64_t SAMPLE_EVERY = 16;
+    constexpr uint64_t SEND_COST_NS = 200;
+
+    void burn(uint64_t ns)
+    {
+        const uint64_t until = bench::now_ns() + ns;
+        while (bench::now_ns() < until) {}
+    }
+
+    class SinkHal {
+    public:
+        std::atomic<uint64_t> tx_frames{ 0 };
+
+        int send(const void* data, size_t)
+        {
+            bench::do_not_optimize(data);
+            burn(SEND_COST_NS);
+            tx_frames.fetch_add(1, std::memory_order_relaxed);
+            return 0;
+        }
+        size_t receive(void*, size_t) { return 0; }
+        bool wait(uint32_t) { return false; }
+    };
+
+    struct Result {
+        double avg_ns = 0;
+        double p50_ns = 0;
+        double p99_ns = 0;
+        double frames_per_sec = 0;
+        uint64_t full = 0;
+    };
+
+    Result summarize(std::vector<uint64_t>& samples, uint64_t elapsed_ns, uint64_t full)
+    {
+        Result result;
+        std::sort(samples.begin(), samples.end());
+        uint64_t total = 0;
+        for (uint64_t s : samples) total += s;
+        result.avg_ns = static_cast<double>(total) / static_cast<double>(samples.size());
+        result.p50_ns = static_cast<double>(samples[samples.size() / 2]);
+        result.p99_ns = static_cast<double>(samples[samples.size() * 99 / 100]);
+        result.frames_per_sec = static_cast<double>(TOTAL_FRAMES) * 1e9 / static_cast<double>(elapsed_ns);
+        result.full = full;
+        return result;
+    }
+
+    // Runs 'producers' threads calling submit(frame) TOTAL_FRAMES times in
+    // total while 'consume()' runs on this thread until 'done()'.
+    template <typename Submit, typename Consume, typename Done>
+    Result run(size_t producers, Submit submit, Consume consume, Done done)
+    {
+        std::atomic<bool> go{ false };
+        std::atomic<uint64_t> full{ 0 };
+        std::vector<std::vector<uint64_t>> samples(producers);
+        std::vector<std::thread> threads;
+
+        const uint64_t per_thread = TOTAL_FRAMES / producers;
+        for (size_t p = 0; p < producers; ++p) {
+            threads.emplace_back([&, p] {
+                std::array<std::byte, FRAME_BYTES> frame{};
+                frame[0] = static_cast<std::byte>(p);
+                samples[p].reserve(per_thread / SAMPLE_EVERY + 1);
+                uint64_t my_full = 0;
+                while (!go.load(std::memory_order_acquire)) {}
+
+                for (uint64_t i = 0; i < per_thread; ++i) {
+                    const bool sample = i % SAMPLE_EVERY == 0;
+                    const uint64_t start = sample ? bench::now_ns() : 0;
+                    while (!submit(frame)) {
+                        ++my_full;
+                        std::this_thread::yield();
+                    }
+                    if (sample) samples[p].push_back(bench::now_ns() - start);
+                }
+                full.fetch_add(my_full, std::memory_order_relaxed);
+            });
+        }
+
+        const uint64_t start = bench::now_ns();
+        go.store(true, std::memory_order_release);
+        while (!done(per_thread * producers)) {
+            consume();
+        }
+        const uint64_t elapsed = bench::now_ns() - start;
+        for (std::thread& t : threads) t.join();
+
+        std::vector<uint64_t> all;
+        for (auto& s : samples) all.insert(all.end(), s.begin(), s.end());
+        return summarize(all, elapsed, full.load());
+    }
+
+    void print(const char* label, size_t producers, const Result& r)
+    {
+        std::printf("%-10s %2zu producers  submit avg %8.1f ns  p50 %7.0f ns  p99 %9.0f ns  %12.0f frames/s  queue full %llu\n",
+                    label, producers, r.avg_ns, r.p50_ns, r.p99_ns, r.frames_per_sec,
+                    static_cast<unsigned long long>(r.full));
+    }
+
+    void stack_case(size_t producers)
+    {
+        SinkHal hal;
+        auto stack = std::make_unique<net::BasicNetworkStack<SinkHal>>(hal, &k_config);
+        Result r = run(producers,
+            [&](const std::array<std::byte, FRAME_BYTES>& frame) {
+                return stack->submit_frame(frame) == net::TxSubmitResult::QUEUED;
+            },
+            [&] {
+                if (stack->poll() == 0 && stack->tx_queue_depth() == 0) std::this_thread::yield();
+            },
+            [&](uint64_t expected) { return hal.tx_frames.load(std::memory_order_relaxed) >= expected; });
+        print("stack", producers, r);
+    }
+
+    struct Frame {
+        uint16_t length;
+        std::array<std::byte, FRAME_BYTES> bytes;
+    };
+
+    void big_queue_case(size_t producers)
+    {
+        SinkHal hal;
+        auto queue = std::make_unique<net::MpscQueue<Frame, 1024>>();
+        Result r = run(producers,
+            [&](const std::array<std::byte, FRAME_BYTES>& frame) {
+                return queue->try_push([&](Frame& slot) {
+                    slot.length = FRAME_BYTES;
+                    slot.bytes = frame;
+                });
+            },
+            [&] {
+                bool any = false;
+                while (queue->try_pop([&](Frame& slot) { hal.send(slot.bytes.data(), slot.length); })) {
+                    any = true;
+                }
+                if (!any) std::this_thread::yield();
+            },
+            [&](uint64_t expected) { return hal.tx_frames.load(std::memory_order_relaxed) >= expected; });
+        print("queue-1k", producers, r);
+    }
+
+    void mutex_case(size_t producers)
+    {
+        SinkHal hal;
+        std::mutex lock;
+        Result r = run(producers,
+            [&](const std::array<std::byte, FRAME_BYTES>& frame) {
+                std::lock_guard<std::mutex> guard(lock);
+                return hal.send(frame.data(), frame.size()) == 0;
+            },
+            [] { std::this_thread::yield(); },
+            [&](uint64_t expected) { return hal.tx_frames.load(std::memory_order_relaxed) >= expected; });
+        print("mutex", producers, r);
+    }
+
+}
+
+int main()
+{
+    hal_timer_init();
+    std::printf("TX submission: %llu frames of %zu bytes, %llu ns per send, stack queue of %zu slots, %u hardware threads\n",
+                static_cast<unsigned long long>(TOTAL_FRAMES), FRAME_BYTES,
+                static_cast<unsigned long long>(SEND_COST_NS),
+                net::BasicNetworkStack<SinkHal>::TxQueue::capacity(), std::thread::hardware_concurrency());
+
+    for (size_t producers : {1, 2, 4, 8}) {
+        stack_case(producers);
+        big_queue_case(producers);
+        mutex_case(producers);
+    }
+    return 0;
+}
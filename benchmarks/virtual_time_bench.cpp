@@ -0,0 +1,188 @@
+// Timer-heavy workloads on virtual time (VirtualClock + SimulatedHal).
+//
+// Each case simulates hours of traffic and timer expiry; the clock only
+// moves when the stack would otherwise sleep, so a run takes as long as the
+// work itself. The counters are deterministic: identical on every run and
+// every machine. Only the wall-clock columns vary.
+//   arp aging     - 16 neighbours ask for us every 10 min for 24 h; each
+//                   entry expires after 5 min and is learned again
+//   dead resolve  - 4 coroutines resolving hosts that never answer
+//                   (3 s timeout, 1 s retransmits) for 1 h
+//   live resolve  - a simulated peer answers after 3 ms; 4 coroutines
+//                   re-resolve every 30 s for 6 h, riding the 5 min expiry
+
+#include "bench_common.hpp"
+#include "arp_frames.hpp"
+
+#include "hal/simulated_hal.hpp"
+#include "hal/virtual_clock.hpp"
+#include "net_stack/network_stack_impl.hpp"
+
+#include <array>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+    using SimHal = SimulatedHal<>;
+    using SimStack = net::BasicNetworkStack<SimHal>;
+
+    const net::NetworkConfig k_config = {
+        .mac_address = {0xF4, 0x7B, 0x09, 0x51, 0x91, 0x63},
+        .ipv4_address = {10, 23, 42, 10},
+        .gateway_address = {10, 23, 42, 1}};
+
+    constexpr uint64_t MINUTE_MS = 60'000;
+    constexpr uint64_t HOUR_MS = 60 * MINUTE_MS;
+
+    std::array<uint8_t, 4> neighbor_ip(size_t i) { return {10, 23, 42, static_cast<uint8_t>(100 + i)}; }
+
+    void report(const char* label, uint64_t virtual_ms, uint64_t wall_ns, const SimStack& stack)
+    {
+        const net::RunLoopStats& run = stack.get_run_stats();
+        std::printf("%-14s %5.1f h virtual in %8.2f ms wall (x%9.0f)  %9llu polls  %6.0f ns/poll\n",
+                    label, static_cast<double>(virtual_ms) / HOUR_MS, static_cast<double>(wall_ns) / 1e6,
+                    static_cast<double>(virtual_ms) * 1e6 / static_cast<double>(wall_ns),
+                    static_cast<unsigned long long>(run.polls),
+                    static_cast<double>(wall_ns) / static_cast<double>(run.polls));
+    }
+
+    void arp_aging_case()
+    {
+        constexpr size_t NEIGHBORS = 16;
+        constexpr uint64_t PERIOD_MS = 10 * MINUTE_MS;
+        constexpr uint64_t DURATION_MS = 24 * HOUR_MS;
+
+        VirtualClock clock;
+        clock.install();
+        SimHal hal(clock);
+        SimStack stack(hal, &k_config);
+
+        const uint64_t start = bench::now_ns();
+        std::array<std::byte, bench::ARP_FRAME_BYTES> frame;
+        for (uint64_t t = 0; t < DURATION_MS; t += PERIOD_MS) {
+            // Script: each neighbour asks for us once per period, 7 s apart.
+            for (size_t i = 0; i < NEIGHBORS; ++i) {
+                const uint8_t mac[6] = {0xAA, 0xBB, 0xCC, 0xDD, 0xEE, static_cast<uint8_t>(i)};
+                bench::write_arp(frame.data(), ARP_OPCODE_REQUEST, mac, neighbor_ip(i), k_config.ipv4_address);
+                hal.inject_at_us((t + i * 7'000) * 1000u, frame);
+            }
+            hal.run_until_ms(stack, t + PERIOD_MS);
+        }
+        const uint64_t wall = bench::now_ns() - start;
+
+        size_t cached = 0;
+        for (size_t i = 0; i < NEIGHBORS; ++i) {
+            cached += stack.get_arp_cache().lookup(neighbor_ip(i)).has_value() ? 1 : 0;
+        }
+        report("arp aging", DURATION_MS, wall, stack);
+        std::printf("%-14s   requests %llu  replies %llu  learned %u (expected %llu)  cached at end %zu\n", "",
+                    static_cast<unsigned long long>(hal.rx_frames()),
+                    static_cast<unsigned long long>(hal.tx_frames()),
+                    stack.get_arp_cache().get_stats().entries_learned,
+                    static_cast<unsigned long long>(NEIGHBORS * (DURATION_MS / PERIOD_MS)), cached);
+    }
+
+    struct ResolveCounters {
+        uint64_t resolved = 0;
+        uint64_t timed_out = 0;
+        uint64_t latency_ms_total = 0;
+    };
+
+    net::Task resolve_forever(SimStack& stack, std::array<uint8_t, 4> ip, uint32_t timeout_ms,
+                              uint32_t pause_ms, ResolveCounters& counters)
+    {
+        while (true) {
+            const uint32_t asked = hal_timer_get_ms();
+            auto mac = co_await stack.resolve(ip, timeout_ms);
+            if (mac.has_value()) {
+                ++counters.resolved;
+                counters.latency_ms_total += hal_timer_get_ms() - asked;
+            }
+            else {
+                ++counters.timed_out;
+            }
+            if (pause_ms != 0) {
+                // Sleep: nothing else is sent to us, so this only times out.
+                (void)co_await stack.next_frame(pause_ms);
+            }
+        }
+    }
+
+    void dead_resolve_case()
+    {
+        constexpr uint64_t DURATION_MS = HOUR_MS;
+
+        VirtualClock clock;
+        clock.install();
+        SimHal hal(clock);
+        SimStack stack(hal, &k_config);
+
+        ResolveCounters counters;
+        std::array<net::Task, 4> tasks;
+        for (size_t i = 0; i < tasks.size(); ++i) {
+            tasks[i] = resolve_forever(stack, neighbor_ip(50 + i), 3000, 0, counters);
+        }
+
+        const uint64_t start = bench::now_ns();
+        hal.run_until_ms(stack, DURATION_MS);
+        const uint64_t wall = bench::now_ns() - start;
+
+        report("dead resolve", DURATION_MS, wall, stack);
+        std::printf("%-14s   ARP requests %llu  timeouts %llu\n", "",
+                    static_cast<unsigned long long>(hal.tx_frames()),
+                    static_cast<unsigned long long>(counters.timed_out));
+    }
+
+    // Simulated peer: answers every ARP request for a 10.23.42.x host after 3 ms.
+    void answer_arp(void*, SimHal& hal, std::span<const std::byte> frame)
+    {
+        if (frame.size() < bench::ARP_FRAME_BYTES) return;
+        const auto* arp = reinterpret_cast<const ArpPacket*>(frame.data() + sizeof(EthernetHeader));
+        if (net::net_ntohs16(arp->opcode) != ARP_OPCODE_REQUEST) return;
+
+        std::array<uint8_t, 4> target;
+        std::memcpy(target.data(), arp->target_ip, 4);
+        const uint8_t mac[6] = {0xAA, 0xBB, 0xCC, 0x00, 0x00, target[3]};
+        std::array<std::byte, bench::ARP_FRAME_BYTES> reply;
+        bench::write_arp(reply.data(), ARP_OPCODE_REPLY, mac, target, k_config.ipv4_address);
+        hal.inject_after_ms(3, reply);
+    }
+
+    void live_resolve_case()
+    {
+        constexpr uint64_t DURATION_MS = 6 * HOUR_MS;
+
+        VirtualClock clock;
+        clock.install();
+        SimHal hal(clock);
+        hal.on_send(&answer_arp, nullptr);
+        SimStack stack(hal, &k_config);
+
+        ResolveCounters counters;
+        std::array<net::Task, 4> tasks;
+        for (size_t i = 0; i < tasks.size(); ++i) {
+            tasks[i] = resolve_forever(stack, neighbor_ip(i), 3000, 30'000, counters);
+        }
+
+        const uint64_t start = bench::now_ns();
+        hal.run_until_ms(stack, DURATION_MS);
+        const uint64_t wall = bench::now_ns() - start;
+
+        report("live resolve", DURATION_MS, wall, stack);
+        std::printf("%-14s   resolves %llu  from the wire %llu  avg latency %.2f ms  timeouts %llu\n", "",
+                    static_cast<unsigned long long>(counters.resolved),
+                    static_cast<unsigned long long>(hal.tx_frames()),
+                    counters.resolved == 0 ? 0.0 : static_cast<double>(counters.latency_ms_total) / static_cast<double>(counters.resolved),
+                    static_cast<unsigned long long>(counters.timed_out));
+    }
+
+}
+
+int main()
+{
+    arp_aging_case();
+    dead_resolve_case();
+    live_resolve_case();
+    return 0;
+}
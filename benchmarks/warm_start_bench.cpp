@@ -0,0 +1,336 @@
+// Warm start: time to the first successful send after a restart, with the
+// ARP cache cold and restored from a snapshot (attach_arp_snapshot()).
+//
+// Needs a veth pair (or two cabled NICs) and raw-socket rights:
+//   ip link add vb0 type veth peer name vb1
+//   ip link set vb0 up && ip link set vb1 up
+//   NET_IFACE=vb0 NET_PEER_IFACE=vb1 ./warm_start_bench
+// A peer socket on NET_PEER_IFACE plays 16 neighbours (10.99.0.100-115),
+// answering ARP requests after a configurable delay (a busy gateway, a
+// sleeping sensor) and checking that every UDP datagram reaching it is
+// addressed to the right MAC. Each restart builds a fresh stack on
+// NET_IFACE and sends one datagram to every neighbour as soon as its MAC is
+// known: cold, each waits for an ARP round trip; warm, the snapshot saved
+// by the previous run (an mmapped file) has them all, and the probes that
+// confirm them run alongside. In the "moved" case every neighbour answers
+// from a new MAC, so the restored entries are stale until a probe comes
+// back; datagrams keep going out every millisecond until then. Reported per
+// restart: first datagram sent and received, one sent to every neighbour,
+// datagrams that went to a stale MAC, and ARP frames on the wire until every
+// restored entry is confirmed or dropped.
+// Leave the interfaces without IP addresses so the kernel stays quiet.
+
+#include "bench_common.hpp"
+#include "arp_frames.hpp"
+
+#include "hal/hal_persist.hpp"
+#include "hal/hal_timer.hpp"
+#include "hal/linux_raw_socket_hal.hpp"
+#include "net_stack/inet_checksum.hpp"
+#include "net_stack/network_stack_impl.hpp"
+#include "protocols/ipv4.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace {
+
+    using Stack = net::BasicNetworkStack<LinuxRawSocketHal>;
+    using Mac = std::array<uint8_t, 6>;
+
+    constexpr std::array<uint8_t, 4> STACK_IP = {10, 99, 0, 1};
+    constexpr uint8_t FIRST_NEIGHBOUR = 100;
+    constexpr size_t NEIGHBOURS = 16;
+    constexpr int RESTARTS = 20;
+    constexpr uint64_t SETTLE_TIMEOUT_NS = 5'000'000'000;
+    constexpr Mac MOVED_MAC = {0x02, 0x00, 0x5E, 0x00, 0x00, 0x99};
+    constexpr size_t UDP_PAYLOAD_BYTES = 16;
+    constexpr size_t UDP_FRAME_BYTES = sizeof(EthernetHeader) + sizeof(Ipv4Header) + 8 + UDP_PAYLOAD_BYTES;
+
+    std::array<uint8_t, 4> neighbour_ip(size_t index)
+    {
+        return {10, 99, 0, static_cast<uint8_t>(FIRST_NEIGHBOUR + index)};
+    }
+
+    // The neighbours, answering ARP after 'reply_delay_ns' from 'mac'.
+    struct Peer {
+        explicit Peer(LinuxRawSocketHal& peer_hal) : hal(peer_hal) {}
+
+        LinuxRawSocketHal& hal;
+        Mac mac{};
+        uint64_t reply_delay_ns = 0;
+
+        struct PendingReply {
+            uint64_t due_ns;
+            std::array<uint8_t, 4> ip;
+        };
+        std::vector<PendingReply> pending;
+        uint64_t arp_frames = 0;        // from the stack: requests, probes, announcements
+        uint64_t datagrams = 0;
+        uint64_t stale_datagrams = 0;   // sent to a MAC we no longer answer from
+        uint64_t first_datagram_ns = 0;
+
+        void reset()
+        {
+            pending.clear();
+            arp_frames = datagrams = stale_datagrams = first_datagram_ns = 0;
+        }
+
+        void service()
+        {
+            std::array<std::byte, 1514> frame;
+            while (size_t n = hal.receive(frame.data(), frame.size())) {
+                const auto* eth = reinterpret_cast<const EthernetHeader*>(frame.data());
+                if (n < sizeof(EthernetHeader) || std::memcmp(eth->source_mac, hal.mac(), 6) == 0) {
+                    continue;   // our own replies coming back
+                }
+                if (net::net_ntohs16(eth->ethertype) == ETHERTYPE_ARP && n >= bench::ARP_FRAME_BYTES) {
+                    const auto* arp = reinterpret_cast<const ArpPacket*>(frame.data() + sizeof(EthernetHeader));
+                    ++arp_frames;
+                    const uint8_t target = arp->target_ip[3];
+                    if (net::net_ntohs16(arp->opcode) == ARP_OPCODE_REQUEST && target >= FIRST_NEIGHBOUR &&
+                        target < FIRST_NEIGHBOUR + NEIGHBOURS) {
+                        pending.push_back({ bench::now_ns() + reply_delay_ns, neighbour_ip(target - FIRST_NEIGHBOUR) });
+                    }
+                }
+                else if (net::net_ntohs16(eth->ethertype) == ETHERTYPE_IPV4) {
+                    if (first_datagram_ns == 0) {
+                        first_datagram_ns = bench::now_ns();
+                    }
+                    ++datagrams;
+                    stale_datagrams += std::memcmp(eth->destination_mac, mac.data(), 6) != 0;
+                }
+            }
+            const uint64_t now = bench::now_ns();
+            for (size_t i = 0; i < pending.size();) {
+                if (pending[i].due_ns <= now) {
+                    std::array<std::byte, bench::ARP_FRAME_BYTES> reply{};
+                    bench::write_arp(reply.data(), ARP_OPCODE_REPLY, mac.data(), pending[i].ip, STACK_IP);
+                    (void)hal.send(reply.data(), reply.size());
+                    pending[i] = pending.back();
+                    pending.pop_back();
+                }
+                else {
+                    ++i;
+                }
+            }
+        }
+    };
+
+    void write_udp(std::byte* frame, const Mac& destination_mac, const uint8_t source_mac[6],
+                   const std::array<uint8_t, 4>& destination_ip)
+    {
+        auto* eth = reinterpret_cast<EthernetHeader*>(frame);
+        std::memcpy(eth->destination_mac, destination_mac.data(), 6);
+        std::memcpy(eth->source_mac, source_mac, 6);
+        eth->ethertype = net::net_htons16(ETHERTYPE_IPV4);
+
+        auto* ip = reinterpret_cast<Ipv4Header*>(frame + sizeof(EthernetHeader));
+        std::memset(ip, 0, sizeof(*ip));
+        ip->version_ihl = 0x45;
+        ip->total_length = net::net_htons16(static_cast<uint16_t>(sizeof(Ipv4Header) + 8 + UDP_PAYLOAD_BYTES));
+        ip->ttl = 64;
+        ip->protocol = 17;
+        std::memcpy(ip->source_ip, STACK_IP.data(), 4);
+        std::memcpy(ip->destination_ip, destination_ip.data(), 4);
+        ip->header_checksum = net::net_htons16(net::internet_checksum(std::as_bytes(std::span(ip, 1))));
+
+        std::byte* udp = frame + sizeof(EthernetHeader) + sizeof(Ipv4Header);
+        const uint16_t udp_fields[4] = { net::net_htons16(40000), net::net_htons16(9),
+                                         net::net_htons16(8 + UDP_PAYLOAD_BYTES), 0 };
+        std::memcpy(udp, udp_fields, sizeof(udp_fields));
+        std::memset(udp + 8, 0xA5, UDP_PAYLOAD_BYTES);
+    }
+
+    struct Restart {
+        uint64_t first_send_ns = 0;    // restart -> first datagram handed to the HAL
+        uint64_t all_sent_ns = 0;      // restart -> one datagram to every neighbour
+        uint64_t first_arrival_ns = 0; // restart -> first datagram at the peer
+        uint64_t stale = 0;
+        uint64_t arp_frames = 0;
+        uint32_t probes = 0;
+        bool complete = false;
+    };
+
+    // One restart: a fresh stack, warm from 'snapshot' or cold, sends to
+    // every neighbour, waits for the restored entries to settle, saves.
+    Restart restart(LinuxRawSocketHal& hal, const net::NetworkConfig& config, Peer& peer,
+                    std::span<std::byte> snapshot, bool warm)
+    {
+        peer.reset();
+        Restart result;
+        const uint64_t start = bench::now_ns();
+        auto stack = std::make_unique<Stack>(hal, &config);
+        if (warm) {
+            (void)stack->attach_arp_snapshot(snapshot, { .save_interval_ms = UINT32_MAX });
+        }
+
+        std::array<bool, NEIGHBOURS> sent{};
+        std::array<bool, NEIGHBOURS> requested{};
+        size_t sent_count = 0;
+        std::array<std::byte, UDP_FRAME_BYTES> frame{};
+        while (sent_count < NEIGHBOURS && bench::now_ns() - start < SETTLE_TIMEOUT_NS) {
+            for (size_t i = 0; i < NEIGHBOURS; ++i) {
+                if (sent[i]) {
+                    continue;
+                }
+                if (const auto mac = stack->next_hop_mac(neighbour_ip(i))) {
+                    write_udp(frame.data(), *mac, config.mac_address.data(), neighbour_ip(i));
+                    if (stack->send_frame(frame) == 0) {
+                        sent[i] = true;
+                        if (sent_count++ == 0) {
+                            result.first_send_ns = bench::now_ns() - start;
+                        }
+                    }
+                }
+                else if (!requested[i]) {
+                    stack->send_arp_request(neighbour_ip(i));
+                    requested[i] = true;
+                }
+            }
+            (void)stack->poll();
+            peer.service();
+        }
+        result.all_sent_ns = bench::now_ns() - start;
+        result.complete = sent_count == NEIGHBOURS;
+
+        // Keep sending, one datagram per neighbour per millisecond, until
+        // every restored entry is confirmed or dropped.
+        const net::ArpStats& arp = stack->get_arp_cache().get_stats();
+        uint64_t next_round_ns = bench::now_ns();
+        while (arp.tentative_confirmed + arp.tentative_expired < arp.tentative_loaded &&
+               bench::now_ns() - start < SETTLE_TIMEOUT_NS) {
+            if (bench::now_ns() >= next_round_ns) {
+                for (size_t i = 0; i < NEIGHBOURS; ++i) {
+                    if (const auto mac = stack->next_hop_mac(neighbour_ip(i))) {
+                        write_udp(frame.data(), *mac, config.mac_address.data(), neighbour_ip(i));
+                        (void)stack->send_frame(frame);
+                    }
+                }
+                next_round_ns += 1'000'000;
+            }
+            (void)stack->poll();
+            peer.service();
+        }
+        for (int drain = 0; drain < 1000; ++drain) {
+            peer.service();
+        }
+        result.first_arrival_ns = peer.first_datagram_ns == 0 ? 0 : peer.first_datagram_ns - start;
+        result.stale = peer.stale_datagrams;
+        result.arp_frames = peer.arp_frames;
+        result.probes = arp.probes_sent;
+
+        if (!warm) {
+            (void)stack->attach_arp_snapshot(snapshot, { .announce = false });
+        }
+        stack->save_arp_snapshot();
+        return result;
+    }
+
+    void run(const char* name, LinuxRawSocketHal& hal, const net::NetworkConfig& config, Peer& peer,
+             std::span<std::byte> snapshot, bool warm, bool moved)
+    {
+        const Mac home_mac = peer.mac;
+        std::vector<Restart> restarts;
+        for (int i = 0; i < RESTARTS; ++i) {
+            // Prime the snapshot from the neighbours' old home, then move them.
+            if (moved) {
+                peer.mac = home_mac;
+                (void)restart(hal, config, peer, snapshot, false);
+                peer.mac = MOVED_MAC;
+            }
+            restarts.push_back(restart(hal, config, peer, snapshot, warm));
+        }
+        peer.mac = home_mac;
+
+        auto median_us = [&](uint64_t Restart::*field) {
+            std::vector<uint64_t> values;
+            for (const Restart& r : restarts) {
+                values.push_back(r.*field);
+            }
+            std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+            return static_cast<double>(values[values.size() / 2]) / 1e3;
+        };
+        uint64_t stale = 0;
+        uint64_t arp_frames = 0;
+        uint64_t probes = 0;
+        int incomplete = 0;
+        for (const Restart& r : restarts) {
+            stale += r.stale;
+            arp_frames += r.arp_frames;
+            probes += r.probes;
+            incomplete += !r.complete;
+        }
+        std::printf("%-28s %10.1f %10.1f %10.1f %7.1f %7.1f %7.1f %6d\n", name, median_us(&Restart::first_send_ns),
+                    median_us(&Restart::first_arrival_ns), median_us(&Restart::all_sent_ns),
+                    static_cast<double>(stale) / RESTARTS, static_cast<double>(arp_frames) / RESTARTS,
+                    static_cast<double>(probes) / RESTARTS, incomplete);
+    }
+
+}
+
+int main()
+{
+    const char* iface = std::getenv("NET_IFACE");
+    const char* peer_iface = std::getenv("NET_PEER_IFACE");
+    if (iface == nullptr || peer_iface == nullptr) {
+        std::printf("set NET_IFACE and NET_PEER_IFACE to the two ends of a veth pair (see the top of this file)\n");
+        return 0;
+    }
+    hal_timer_init();
+
+    net::NetworkConfig config = {
+        .mac_address = {},
+        .ipv4_address = STACK_IP,
+        .gateway_address = {},
+        .subnet_mask = {255, 255, 255, 0},
+        .interface_name = iface};
+    net::NetworkConfig peer_config = config;
+    peer_config.ipv4_address = {10, 99, 0, 2};
+    peer_config.interface_name = peer_iface;
+
+    LinuxRawSocketHal hal;
+    LinuxRawSocketHal peer_hal;
+    if (hal.init(&config, NetworkFiltering::ARP_IPV4) != 0 ||
+        peer_hal.init(&peer_config, NetworkFiltering::ARP_IPV4) != 0) {
+        std::printf("raw sockets unavailable on %s/%s; skipping\n", iface, peer_iface);
+        return 0;
+    }
+    std::memcpy(config.mac_address.data(), hal.mac(), 6);
+
+    const char* path = std::getenv("NET_ARP_SNAPSHOT");
+    HalPersistentRegion region{};
+    if (hal_persist_map(path != nullptr ? path : "/tmp/warm_start_bench.snap",
+                        net::arp_snapshot_bytes(net::k_memory_config.arp_cache_entries), region) != 0) {
+        std::printf("cannot map the snapshot file; skipping\n");
+        return 0;
+    }
+    const std::span<std::byte> snapshot(static_cast<std::byte*>(region.data), region.size);
+
+    Peer peer(peer_hal);
+    std::memcpy(peer.mac.data(), peer_hal.mac(), 6);
+
+    std::printf("Restart -> datagram to each of %zu neighbours on %s, medians of %d restarts (us)\n", NEIGHBOURS,
+                iface, RESTARTS);
+    std::printf("%-28s %10s %10s %10s %7s %7s %7s %6s\n", "case", "1st sent", "1st recv", "all sent", "stale",
+                "ARP", "probes", "failed");
+    constexpr uint64_t DELAYS_US[] = { 0, 2'000, 20'000 };
+    for (uint64_t delay_us : DELAYS_US) {
+        peer.reply_delay_ns = delay_us * 1'000;
+        char name[64];
+        std::snprintf(name, sizeof(name), "cold, ARP reply %llu us", static_cast<unsigned long long>(delay_us));
+        std::memset(snapshot.data(), 0, snapshot.size());
+        run(name, hal, config, peer, snapshot, false, false);
+        std::snprintf(name, sizeof(name), "warm, ARP reply %llu us", static_cast<unsigned long long>(delay_us));
+        run(name, hal, config, peer, snapshot, true, false);
+        std::snprintf(name, sizeof(name), "warm, moved, reply %llu us", static_cast<unsigned long long>(delay_us));
+        run(name, hal, config, peer, snapshot, true, true);
+    }
+    hal_persist_unmap(region);
+    return 0;
+}
@@ -0,0 +1,18 @@
+#ifndef HAL_DEFAULT_HAL_H
+#define HAL_DEFAULT_HAL_H
+
+// Compile-time selection of the HAL policy behind net::NetworkStack.
+// A port can override it by defining NET_DEFAULT_HAL_HEADER/NET_DEFAULT_HAL.
+
+#if defined(NET_DEFAULT_HAL_HEADER) && defined(NET_DEFAULT_HAL)
+#include NET_DEFAULT_HAL_HEADER
+using DefaultNetworkHal = NET_DEFAULT_HAL;
+#elif defined(__linux__)
+#include "hal/linux_raw_socket_hal.hpp"
+using DefaultNetworkHal = LinuxRawSocketHal;
+#else
+#include "hal/free_function_hal.hpp"
+using DefaultNetworkHal = FreeFunctionHal;
+#endif
+
+#endif // HAL_DEFAULT_HAL_H
@@ -0,0 +1,49 @@
+#ifndef HAL_EXTENDED_FREE_FUNCTION_HAL_H
+#define HAL_EXTENDED_FREE_FUNCTION_HAL_H
+
+#include "hal/free_function_hal.hpp"
+#include "hal/hal_network_extensions.hpp"
+
+/**
+ * @brief FreeFunctionHal plus every optional capability, forwarded to the
+ * * functions in hal/hal_network_extensions.hpp.
+ * * Opt-in, for ports that implement them all (the PC's default instance in
+ * * pc_linux_hal.cpp does). Note that the stack then takes the timestamped
+ * * receive path for every frame.
+ */
+struct ExtendedFreeFunctionHal : FreeFunctionHal {
+    using FreeFunctionHal::receive;
+    using FreeFunctionHal::send;
+
+    void wake() { hal_net_wake(); }
+    void flush() { hal_net_flush(); }
+
+    int enable_timestamping(TimestampMode mode) { return hal_net_enable_timestamping(mode); }
+    int enable_busy_poll(uint32_t busy_poll_us, bool prefer_busy_poll)
+    {
+        return hal_net_enable_busy_poll(busy_poll_us, prefer_busy_poll);
+    }
+    size_t receive(void* buffer, size_t max_length, net::FrameTimestamp& timestamp)
+    {
+        return hal_net_receive(buffer, max_length, &timestamp);
+    }
+    bool poll_tx_completion(net::TxCompletion& completion) { return hal_net_poll_tx_completion(&completion); }
+    uint64_t timestamp_now_ns() { return hal_net_timestamp_now_ns(); }
+
+    int enable_offloads(bool enable) { return hal_net_enable_offloads(enable); }
+    int send(const void* data, size_t length, const net::PacketOffload& offload)
+    {
+        return hal_net_send(data, length, &offload);
+    }
+    const net::PacketOffload& last_rx_offload() { return *hal_net_last_rx_offload(); }
+
+    int enable_io_uring(uint32_t rx_buffers, uint32_t tx_slots) { return hal_net_enable_io_uring(rx_buffers, tx_slots); }
+};
+
+static_assert(NetworkHal<ExtendedFreeFunctionHal>);
+static_assert(TimestampingHal<ExtendedFreeFunctionHal>);
+static_assert(OffloadHal<ExtendedFreeFunctionHal>);
+static_assert(WakeableHal<ExtendedFreeFunctionHal>);
+static_assert(BatchingHal<ExtendedFreeFunctionHal>);
+
+#endif // HAL_EXTENDED_FREE_FUNCTION_HAL_H
@@ -0,0 +1,22 @@
+#ifndef HAL_FREE_FUNCTION_HAL_H
+#define HAL_FREE_FUNCTION_HAL_H
+
+#include "hal/hal_network.hpp"
+
+/**
+ * @brief HAL policy that forwards to the free-function API
+ * * (hal_net_send / hal_net_receive / hal_net_wait).
+ * * For ports that only provide the C-style functions. Every call is an
+ * * out-of-line call into the driver, exactly like the original stack.
+ * * Only the NetworkHal basics: the optional capabilities are in
+ * * ExtendedFreeFunctionHal (hal/extended_free_function_hal.hpp).
+ */
+struct FreeFunctionHal {
+    int send(const void* data, size_t length) { return hal_net_send(data, length); }
+    size_t receive(void* buffer, size_t max_length) { return hal_net_receive(buffer, max_length); }
+    bool wait(uint32_t timeout_ms) { return hal_net_wait(timeout_ms); }
+};
+
+static_assert(NetworkHal<FreeFunctionHal>);
+
+#endif // HAL_FREE_FUNCTION_HAL_H
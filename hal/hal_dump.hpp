@@ -0,0 +1,41 @@
+#ifndef HAL_DUMP_H
+#define HAL_DUMP_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Where a post-mortem dump goes (a file on the PC, flash or a UART on an MCU).
+ * * write() appends bytes and is async-signal-safe.
+ */
+struct HalDumpSink {
+    void (*write)(void* sink_context, const void* data, size_t size) = nullptr;
+    void* sink_context = nullptr;
+    // Add to hal_timer_get_us() values to get microseconds since the Unix
+    // epoch (0 if the platform has no wall clock).
+    uint64_t epoch_offset_us = 0;
+
+    void operator()(const void* data, size_t size) const { write(sink_context, data, size); }
+};
+
+/**
+ * @brief Produces the dump, e.g. FlightRecorder::write_pcapng().
+ * * May run inside a fatal-signal handler: no allocation, no locks, no logging.
+ */
+using HalDumpHook = void (*)(void* context, const HalDumpSink& sink);
+
+/**
+ * @brief Runs 'hook' into 'path' when the process dies on a fatal signal
+ * * (SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT) or on demand on SIGUSR1, after
+ * * which it keeps running. The file is overwritten on each dump.
+ * @return 0 on success, non-zero on failure.
+ */
+int hal_dump_install(const char* path, HalDumpHook hook, void* context);
+
+/**
+ * @brief Runs the installed hook now, from ordinary code.
+ * @return 0 on success, non-zero if nothing is installed or the file can't be written.
+ */
+int hal_dump_now();
+
+#endif // HAL_DUMP_H
@@ -1,6 +1,5 @@
 #pragma once
 #include <cstdint>
-#include <string>
 #include "hal_logging_configuration.hpp"
 
 // Forward declare the component enum to avoid circular includes
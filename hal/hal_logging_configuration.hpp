@@ -23,10 +23,19 @@ namespace net {
 
 
 
+// Each level can be overridden from the build (e.g. -DLOG_LEVEL_NET=LogLevel::NONE).
+#ifndef LOG_LEVEL_HAL
 #define LOG_LEVEL_HAL LogLevel::INFO
+#endif
+#ifndef LOG_LEVEL_NET
 #define LOG_LEVEL_NET LogLevel::DEBUG
+#endif
+#ifndef LOG_LEVEL_ARP
 #define LOG_LEVEL_ARP LogLevel::DEBUG
+#endif
+#ifndef LOG_LEVEL_IP
+#define LOG_LEVEL_IP LogLevel::INFO
+#endif
 
 // Add future components here
-// #define LOG_LEVEL_IP   net::LogLevel::INFO
 // #define LOG_LEVEL_TCP  net::LogLevel::NONE
@@ -4,6 +4,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <array>
+#include <concepts>
 
 namespace net {
     // A structure to hold network configuration.
@@ -12,15 +13,131 @@ namespace net {
         std::array<uint8_t, 6> mac_address;
         std::array<uint8_t, 4> ipv4_address;
         std::array<uint8_t, 4> gateway_address;
+        // Defines the connected (on-link) subnet; everything else is routed
+        // via gateway_address (see BasicNetworkStack::get_routing_table()).
+        std::array<uint8_t, 4> subnet_mask = {255, 255, 255, 0};
+        // Interface to bind (PC HALs). nullptr = NET_IFACE env or auto-pick.
+        // Give each NetworkConfig/NetworkStack pair its own name to drive
+        // several interfaces from one process.
+        const char* interface_name = nullptr;
+    };
+
+    // Arrival/departure time of one frame as stamped by the kernel and, if
+    // supported, the NIC. Nanoseconds on the HAL's timestamp clock
+    // (CLOCK_REALTIME on Linux; hardware stamps are in the NIC's clock, which
+    // is only comparable if it is synchronised). 0 = not available.
+    struct FrameTimestamp {
+        uint64_t software_ns = 0;
+        uint64_t hardware_ns = 0;
+    };
+
+    // Reported once the kernel has put a frame we sent on the wire.
+    struct TxCompletion {
+        uint32_t id = 0;            // n-th frame sent since timestamping was enabled
+        uint64_t submitted_ns = 0;  // when send() handed it to the kernel
+        FrameTimestamp wire;        // when the kernel/NIC transmitted it
+    };
+
+    // Segmentation/checksum offload metadata for one frame (virtio_net_hdr on
+    // Linux). On receive it describes a GRO-coalesced super-frame; on send it
+    // asks the kernel/NIC to split the frame (GSO) and fill in the L4 checksum.
+    struct PacketOffload {
+        enum class Gso : uint8_t { NONE, TCPV4, TCPV6, UDP_L4 };
+
+        Gso gso = Gso::NONE;
+        uint16_t gso_size = 0;        // L4 payload bytes per segment (MSS)
+        uint16_t header_bytes = 0;    // Ethernet + IP + L4 header length
+        bool needs_checksum = false;  // L4 checksum still to be computed at csum_start + csum_offset
+        bool checksum_valid = false;  // RX only: already verified by the kernel/NIC
+        uint16_t csum_start = 0;      // from the start of the frame
+        uint16_t csum_offset = 0;     // from csum_start
     };
 
 }
 
+enum class TimestampMode {
+    NONE,
+    SOFTWARE,   // kernel RX/TX stamps
+    HARDWARE,   // NIC stamps where supported, software stamps always
+};
+
+/**
+ * @brief The contract a HAL policy type must satisfy for net::BasicNetworkStack.
+ * * The stack holds a reference to one HAL object per interface and calls these
+ * * members directly (static dispatch), so a HAL that defines them inline gets
+ * * its send and receive paths inlined into the stack.
+ * * Semantics match hal_net_send / hal_net_receive / hal_net_wait below.
+ */
+template <typename Hal>
+concept NetworkHal = requires(Hal& hal, const void* data, void* buffer, size_t length, uint32_t timeout_ms) {
+    { hal.send(data, length) } -> std::same_as<int>;
+    { hal.receive(buffer, length) } -> std::same_as<size_t>;
+    { hal.wait(timeout_ms) } -> std::same_as<bool>;
+};
+
+/**
+ * @brief Optional HAL capability: per-frame kernel/NIC timestamps.
+ * * Detected by the stack at compile time; HALs without it cost nothing.
+ * * receive(..., ts) fills 'ts' (zeros when timestamping is off),
+ * * poll_tx_completion() reports transmitted frames one at a time and
+ * * timestamp_now_ns() reads the clock the software stamps are taken on.
+ */
+template <typename Hal>
+concept TimestampingHal = NetworkHal<Hal> &&
+    requires(Hal& hal, void* buffer, size_t length, net::FrameTimestamp& ts, net::TxCompletion& tx) {
+        { hal.receive(buffer, length, ts) } -> std::same_as<size_t>;
+        { hal.poll_tx_completion(tx) } -> std::same_as<bool>;
+        { hal.timestamp_now_ns() } -> std::same_as<uint64_t>;
+    };
+
+/**
+ * @brief Optional HAL capability: segmentation/checksum offload.
+ * * send(..., offload) hands the kernel/NIC a frame larger than the MTU or
+ * * without its L4 checksum; last_rx_offload() describes the frame returned by
+ * * the latest receive() (GRO super-frames have gso != NONE).
+ */
+template <typename Hal>
+concept OffloadHal = NetworkHal<Hal> &&
+    requires(Hal& hal, const void* data, size_t length, const net::PacketOffload& offload) {
+        { hal.send(data, length, offload) } -> std::same_as<int>;
+        { hal.last_rx_offload() } -> std::convertible_to<const net::PacketOffload&>;
+    };
+
+/**
+ * @brief Optional HAL capability: wake() interrupts a wait() in progress.
+ * * Must be callable from any thread. Lets producers on other threads hand
+ * * work to a poll thread that is parked in wait().
+ */
+template <typename Hal>
+concept WakeableHal = NetworkHal<Hal> && requires(Hal& hal) {
+    { hal.wake() } -> std::same_as<void>;
+};
+
+/**
+ * @brief Optional HAL capability: send() may queue frames until flush().
+ * * The stack calls flush() at the end of every poll(), so replies produced
+ * * while draining a burst of received frames leave in one submission.
+ * * wait() must also submit anything still queued before it blocks.
+ */
+template <typename Hal>
+concept BatchingHal = NetworkHal<Hal> && requires(Hal& hal) {
+    { hal.flush() } -> std::same_as<void>;
+};
+
 /*Only usefull for testing on computers*/
 enum class NetworkFiltering {
     ARP,
+    ARP_IPV4,   // ARP and IPv4 frames
+    NONE,       // deliver every frame
 };
 
+// --- Free-function HAL ---
+// The original single-interface API. On the PC it drives one default
+// LinuxRawSocketHal instance; an MCU port may implement only these and use
+// FreeFunctionHal (hal/free_function_hal.hpp) as the stack's policy.
+// Optional capabilities have their own functions in
+// hal/hal_network_extensions.hpp.
+
 int hal_net_init(const net::NetworkConfig* config, NetworkFiltering Filtering);
 
 /**
@@ -47,6 +164,15 @@ int hal_net_send(const void* data, size_t length);
  */
 size_t hal_net_receive(void* buffer, size_t max_length);
 
+/**
+ * @brief Blocks until a frame may be available or the timeout expires.
+ * * Lets the application sleep between events instead of spinning on poll().
+ * * An MCU port without an RX interrupt can simply delay for the timeout.
+ * @param timeout_ms Maximum time to block, in milliseconds.
+ * @return true if a frame is likely waiting, false on timeout.
+ */
+bool hal_net_wait(uint32_t timeout_ms);
+
 /**
  * @brief Cleans up and deinitializes the network hardware/driver.
  */
@@ -0,0 +1,75 @@
+#ifndef HAL_NETWORK_EXTENSIONS_H
+#define HAL_NETWORK_EXTENSIONS_H
+
+#include "hal/hal_network.hpp"
+
+// --- Optional free-function HAL capabilities ---
+// Timestamps, offloads, wake-ups and the Linux socket modes (busy poll,
+// io_uring). pc_linux_hal.cpp implements all of them for its default
+// instance; ExtendedFreeFunctionHal (hal/extended_free_function_hal.hpp)
+// forwards to them. A port using plain FreeFunctionHal needs none of them.
+
+/**
+ * @brief Turns on per-frame timestamping (SO_TIMESTAMPING on Linux).
+ * @return 0 on success; HARDWARE falls back to software stamps if the NIC can't.
+ */
+int hal_net_enable_timestamping(TimestampMode mode);
+
+/**
+ * @brief hal_net_receive() that also reports when the frame arrived.
+ * @param timestamp Filled with the frame's stamps (zeros if timestamping is off).
+ */
+size_t hal_net_receive(void* buffer, size_t max_length, net::FrameTimestamp* timestamp);
+
+/**
+ * @brief TX completion path: fetches the next transmit timestamp, if any.
+ * @return true if 'completion' was filled.
+ */
+bool hal_net_poll_tx_completion(net::TxCompletion* completion);
+
+/**
+ * @brief Current time on the clock software timestamps are taken on.
+ */
+uint64_t hal_net_timestamp_now_ns();
+
+/**
+ * @brief Lets receive calls poll the driver directly for up to 'busy_poll_us'
+ * * (SO_BUSY_POLL / SO_PREFER_BUSY_POLL on Linux). 0 turns it off.
+ * @return 0 on success, non-zero if the platform does not support it.
+ */
+int hal_net_enable_busy_poll(uint32_t busy_poll_us, bool prefer_busy_poll);
+
+/**
+ * @brief Enables segmentation/checksum offload (PACKET_VNET_HDR on Linux).
+ * @return 0 on success, non-zero if the platform does not support it.
+ */
+int hal_net_enable_offloads(bool enable);
+
+/**
+ * @brief hal_net_send() for a frame that needs GSO and/or checksum offload.
+ */
+int hal_net_send(const void* data, size_t length, const net::PacketOffload* offload);
+
+/**
+ * @brief Offload metadata of the frame returned by the last hal_net_receive().
+ */
+const net::PacketOffload* hal_net_last_rx_offload();
+
+/**
+ * @brief Makes a hal_net_wait() in progress (on another thread) return early.
+ */
+void hal_net_wake();
+
+/**
+ * @brief Moves RX/TX onto io_uring on Linux (multishot recv, batched sends).
+ * @return 0 on success, non-zero if the platform does not support it.
+ */
+int hal_net_enable_io_uring(uint32_t rx_buffers, uint32_t tx_slots);
+
+/**
+ * @brief Submits sends that hal_net_send() queued (io_uring mode); else no-op.
+ */
+void hal_net_flush();
+
+
+#endif // HAL_NETWORK_EXTENSIONS_H
@@ -0,0 +1,36 @@
+#ifndef HAL_PERSIST_H
+#define HAL_PERSIST_H
+
+#include <cstddef>
+
+/**
+ * @brief A small block of memory whose contents survive a restart.
+ * * A memory-mapped file on the PC, a reserved flash sector or backup RAM
+ * * on an MCU. The stack writes to it like ordinary memory.
+ */
+struct HalPersistentRegion {
+    void* data = nullptr;
+    size_t size = 0;
+};
+
+/**
+ * @brief Maps the region called 'name' (a file path on the PC), creating it
+ * * zero-filled or resizing it to 'size' bytes. What was last written there,
+ * * by this process or an earlier one, is visible at once.
+ * @return 0 on success, non-zero on failure.
+ */
+int hal_persist_map(const char* name, size_t size, HalPersistentRegion& region);
+
+/**
+ * @brief Starts writing the region back to its storage without waiting.
+ * * A process that dies keeps what it wrote anyway; this is for power loss.
+ * @return 0 on success, non-zero on failure.
+ */
+int hal_persist_flush(const HalPersistentRegion& region);
+
+/**
+ * @brief Unmaps the region (after writing it back) and clears 'region'.
+ */
+void hal_persist_unmap(HalPersistentRegion& region);
+
+#endif // HAL_PERSIST_H
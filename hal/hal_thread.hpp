@@ -0,0 +1,22 @@
+#ifndef HAL_THREAD_H
+#define HAL_THREAD_H
+
+#include <cstdint>
+
+/**
+ * @brief Pins the calling thread (the poll thread) to one CPU core.
+ * * On an MCU without an OS this is a no-op that returns 0.
+ * @return 0 on success, non-zero on failure.
+ */
+int hal_thread_pin_to_cpu(uint32_t cpu);
+
+/**
+ * @brief Switches the calling thread to real-time FIFO scheduling.
+ * * Combined with pinning this keeps the poll thread from being preempted by
+ * * ordinary work on its core. Needs CAP_SYS_NICE on Linux.
+ * @param priority SCHED_FIFO priority (1..99 on Linux).
+ * @return 0 on success, non-zero on failure.
+ */
+int hal_thread_set_realtime(int priority);
+
+#endif // HAL_THREAD_H
@@ -15,4 +15,33 @@ void hal_timer_init();
  */
 uint32_t hal_timer_get_ms();
 
+/**
+ * @brief Microsecond variant of hal_timer_get_ms() (same clock and start point).
+ * * Used where millisecond resolution is too coarse, e.g. busy-poll idle timing.
+ */
+uint64_t hal_timer_get_us();
+
+/**
+ * @brief Milliseconds since the Unix epoch, 0 if the platform has no wall clock.
+ * * Not monotonic and not affected by hal_timer_set_source(); only for
+ * * timestamps that must mean something after a restart (e.g. ARP snapshots).
+ */
+uint64_t hal_timer_get_wall_ms();
+
+/**
+ * @brief A clock that replaces the platform timer, e.g. hal/virtual_clock.hpp.
+ * * now_us(context) returns microseconds since an arbitrary start point and
+ * * must never go backwards.
+ */
+struct HalTimeSource {
+    uint64_t (*now_us)(void* context) = nullptr;
+    void* context = nullptr;
+};
+
+/**
+ * @brief Routes hal_timer_get_ms()/hal_timer_get_us() to 'source'.
+ * * nullptr restores the platform clock. The source must outlive its use.
+ */
+void hal_timer_set_source(const HalTimeSource* source);
+
 #endif // HAL_TIMER_H
@@ -0,0 +1,259 @@
+#ifndef HAL_LINUX_IO_URING_H
+#define HAL_LINUX_IO_URING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @brief io_uring I/O path for an AF_PACKET socket (raw syscalls, no liburing).
+ * * RX is one multishot recv drawing from a registered provided-buffer ring:
+ * * the kernel posts a completion per frame and receive() reaps them from
+ * * shared memory without a syscall. TX copies each frame into a ring-owned
+ * * slot and queues a send SQE; queued sends go to the kernel in one
+ * * io_uring_enter() from flush() or wait(). The wake-up eventfd is watched
+ * * by a multishot poll, so wake() ends a wait() like any other completion.
+ * * Owned by LinuxRawSocketHal (see enable_io_uring()); needs Linux 6.0+.
+ * * init()/shutdown() and the slow paths live in pc_io_uring.cpp, the only
+ * * file that includes <linux/io_uring.h> (it drags in <linux/fs.h> macros
+ * * such as BLOCK_SIZE); the ring layouts used inline are spelled out below.
+ */
+class LinuxIoUring {
+public:
+    // A received frame, still in its ring buffer until release().
+    struct Frame {
+        const uint8_t* data = nullptr;
+        size_t length = 0;
+        bool truncated = false;  // filled its buffer: the frame was longer
+        uint16_t buffer_id = 0;
+    };
+
+    LinuxIoUring() = default;
+    ~LinuxIoUring() { shutdown(); }
+
+    LinuxIoUring(const LinuxIoUring&) = delete;
+    LinuxIoUring& operator=(const LinuxIoUring&) = delete;
+
+    /**
+     * @brief Sets up the ring on a bound socket and arms RX.
+     * * 'rx_buffers' and 'tx_slots' are powers of two; each buffer holds
+     * * 'buffer_bytes'. 'wake_fd' may be -1.
+     * @return 0 on success, non-zero on failure (nothing is left behind).
+     */
+    int init(int sock, int wake_fd, uint32_t rx_buffers, uint32_t tx_slots, size_t buffer_bytes);
+    void shutdown();
+
+    bool active() const { return m_ring_fd >= 0; }
+    // The kernel refused the multishot recv; RX has stopped (see receive_ring()).
+    bool rx_failed() const { return m_rx_failed; }
+
+    // Next received frame, reaping TX and wake-up completions on the way.
+    bool next_frame(Frame& frame)
+    {
+        while (true) {
+            const uint32_t head = *m_cq_head;
+            if (head == std::atomic_ref<uint32_t>(*m_cq_tail).load(std::memory_order_acquire)) {
+                return false;
+            }
+            const Cqe& cqe = m_cqes[head & m_cq_mask];
+            const uint64_t user_data = cqe.user_data;
+            const int32_t res = cqe.res;
+            const uint32_t flags = cqe.flags;
+            std::atomic_ref<uint32_t>(*m_cq_head).store(head + 1, std::memory_order_release);
+
+            if (user_data == USER_DATA_RX && res > 0 && (flags & CQE_F_BUFFER)) {
+                if (!(flags & CQE_F_MORE)) {
+                    arm_recv(); // the kernel ended the multishot
+                }
+                frame.buffer_id = static_cast<uint16_t>(flags >> CQE_BUFFER_SHIFT);
+                frame.data = rx_buffer(frame.buffer_id);
+                frame.length = static_cast<size_t>(res);
+                frame.truncated = frame.length >= m_buffer_bytes;
+                return true;
+            }
+            complete(user_data, res, flags);
+        }
+    }
+
+    // Hands the frame's buffer back to the kernel.
+    void release(const Frame& frame) { recycle(frame.buffer_id); }
+
+    /**
+     * @brief Copies the frame into a free TX slot and queues its send.
+     * * If every slot is in flight, submits what is queued and reaps finished
+     * * sends first; frames only ever leave through the ring, in order.
+     * @return false if the frame is too long or no slot frees up (counted in
+     * *       tx_ring_full()); the frame is then dropped.
+     */
+    bool queue_send(const void* data, size_t length)
+    {
+        if (length > m_buffer_bytes) {
+            return false;
+        }
+        return try_queue_send(data, length) || queue_send_after_reap(data, length);
+    }
+
+    // Submits queued SQEs; no syscall if there are none.
+    void flush()
+    {
+        if (active() && queued() != 0) {
+            (void)enter(0, 0);
+        }
+    }
+
+    // Submits queued SQEs and blocks until a completion arrives or the
+    // timeout expires. True only if a frame is waiting.
+    bool wait(uint32_t timeout_ms);
+
+    // Sends the kernel reported as failed after queue_send() accepted them.
+    uint32_t tx_errors() const { return m_tx_errors; }
+    // Frames queue_send() dropped because no TX slot was free.
+    uint32_t tx_ring_full() const { return m_tx_ring_full; }
+    // Times the multishot recv had to be re-armed (e.g. buffers ran out).
+    uint32_t rx_rearms() const { return m_rx_rearms; }
+
+private:
+    // Kernel ABI, checked against <linux/io_uring.h> in pc_io_uring.cpp.
+    struct Sqe {
+        uint8_t  opcode;
+        uint8_t  flags;
+        uint16_t ioprio;
+        int32_t  fd;
+        uint64_t off;
+        uint64_t addr;
+        uint32_t len;
+        uint32_t op_flags;
+        uint64_t user_data;
+        uint16_t buf_group;
+        uint16_t personality;
+        int32_t  splice_fd_in;
+        uint64_t addr3;
+        uint64_t pad;
+    };
+    struct Cqe {
+        uint64_t user_data;
+        int32_t  res;
+        uint32_t flags;
+    };
+    struct Buf {
+        uint64_t addr;
+        uint32_t len;
+        uint16_t bid;
+        uint16_t resv;  // bufs[0].resv is the ring's tail
+    };
+    static constexpr uint8_t  OP_SEND = 26;
+    static constexpr uint32_t CQE_F_BUFFER = 1u << 0;
+    static constexpr uint32_t CQE_F_MORE = 1u << 1;
+    static constexpr uint32_t CQE_BUFFER_SHIFT = 16;
+
+    static constexpr uint64_t USER_DATA_RX = 1;
+    static constexpr uint64_t USER_DATA_WAKE = 2;
+    static constexpr uint64_t USER_DATA_CANCEL = 3;
+    static constexpr uint64_t USER_DATA_TX = uint64_t{ 1 } << 32;  // | slot
+
+    uint32_t queued() const
+    {
+        return m_sq_tail_local - std::atomic_ref<uint32_t>(*m_sq_head).load(std::memory_order_acquire);
+    }
+
+    Sqe* next_sqe()
+    {
+        if (queued() >= m_sq_entries) {
+            return nullptr;
+        }
+        Sqe* sqe = &m_sqes[m_sq_tail_local & m_sq_mask];
+        std::memset(sqe, 0, sizeof(*sqe));
+        ++m_sq_tail_local;
+        return sqe;
+    }
+
+    bool try_queue_send(const void* data, size_t length)
+    {
+        const uint32_t slot = m_tx_next & (m_tx_slots - 1);
+        if (m_tx_busy[slot]) {
+            return false;
+        }
+        Sqe* sqe = next_sqe();
+        if (sqe == nullptr) {
+            return false;
+        }
+        uint8_t* buffer = tx_buffer(slot);
+        std::memcpy(buffer, data, length);
+        sqe->opcode = OP_SEND;
+        sqe->fd = m_sock;
+        sqe->addr = reinterpret_cast<uint64_t>(buffer);
+        sqe->len = static_cast<uint32_t>(length);
+        sqe->user_data = USER_DATA_TX | slot;
+        m_tx_busy[slot] = 1;
+        ++m_tx_next;
+        return true;
+    }
+    // Slow path of queue_send(): flush, reap and try once more.
+    bool queue_send_after_reap(const void* data, size_t length);
+
+    uint8_t* rx_buffer(uint16_t id) const { return m_buffers + static_cast<size_t>(id) * m_buffer_bytes; }
+    uint8_t* tx_buffer(uint32_t slot) const { return m_buffers + static_cast<size_t>(m_rx_buffers + slot) * m_buffer_bytes; }
+
+    void recycle(uint16_t id)
+    {
+        // Field by field: bufs[0].resv doubles as the ring's tail.
+        Buf& entry = m_buf_ring[m_buf_tail & (m_rx_buffers - 1)];
+        entry.addr = reinterpret_cast<uint64_t>(rx_buffer(id));
+        entry.len = static_cast<uint32_t>(m_buffer_bytes);
+        entry.bid = id;
+        ++m_buf_tail;
+        std::atomic_ref<uint16_t>(m_buf_ring[0].resv).store(m_buf_tail, std::memory_order_release);
+    }
+
+    // Publishes the SQ tail and calls io_uring_enter(); returns its result.
+    int enter(uint32_t min_complete, uint32_t timeout_ms);
+    void arm_recv();
+    void arm_wake();
+    // TX, wake-up and failed RX completions.
+    void complete(uint64_t user_data, int32_t res, uint32_t flags);
+    // Reaps completions up to the first received frame; true if there is one.
+    bool reap_until_frame();
+    // An RX completion in the CQ says the recv was refused (init() only).
+    bool rx_rejected() const;
+    // Cancels every request still in the kernel and reaps their completions.
+    void cancel_in_flight();
+
+    int m_ring_fd = -1;
+    int m_sock = -1;
+    int m_wake_fd = -1;
+
+    // Shared with the kernel.
+    void* m_ring_map = nullptr;
+    size_t m_ring_map_bytes = 0;
+    Sqe* m_sqes = nullptr;
+    size_t m_sqes_bytes = 0;
+    uint32_t* m_sq_head = nullptr;
+    uint32_t* m_sq_tail = nullptr;
+    uint32_t m_sq_mask = 0;
+    uint32_t m_sq_entries = 0;
+    uint32_t m_sq_tail_local = 0;
+    uint32_t* m_cq_head = nullptr;
+    uint32_t* m_cq_tail = nullptr;
+    uint32_t m_cq_mask = 0;
+    Cqe* m_cqes = nullptr;
+
+    // One anonymous mapping: buffer ring, RX buffers, TX slots, TX busy flags.
+    void* m_buffer_map = nullptr;
+    size_t m_buffer_map_bytes = 0;
+    Buf* m_buf_ring = nullptr;
+    uint8_t* m_buffers = nullptr;
+    uint8_t* m_tx_busy = nullptr;
+    size_t m_buffer_bytes = 0;
+    uint32_t m_rx_buffers = 0;
+    uint16_t m_buf_tail = 0;
+    uint32_t m_tx_slots = 0;
+    uint32_t m_tx_next = 0;
+
+    bool m_rx_failed = false;
+    uint32_t m_tx_errors = 0;
+    uint32_t m_tx_ring_full = 0;
+    uint32_t m_rx_rearms = 0;
+};
+
+#endif // HAL_LINUX_IO_URING_H
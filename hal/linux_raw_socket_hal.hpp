@@ -0,0 +1,288 @@
+#ifndef HAL_LINUX_RAW_SOCKET_HAL_H
+#define HAL_LINUX_RAW_SOCKET_HAL_H
+
+#include "hal/hal_network.hpp"
+#include "hal/hal_logging.hpp"
+#include "hal/linux_io_uring.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include <climits>
+#include <cstring>
+#include <ctime>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <net/if.h>           // IFNAMSIZ
+
+/**
+ * @brief AF_PACKET raw-socket HAL for Linux, one instance per interface.
+ * * init()/shutdown() live in pc_linux_hal.cpp; send/receive/wait are defined
+ * * here so that BasicNetworkStack<LinuxRawSocketHal> inlines them.
+ */
+class LinuxRawSocketHal {
+public:
+    LinuxRawSocketHal() = default;
+    ~LinuxRawSocketHal() { shutdown(); }
+
+    LinuxRawSocketHal(const LinuxRawSocketHal&) = delete;
+    LinuxRawSocketHal& operator=(const LinuxRawSocketHal&) = delete;
+
+    /**
+     * @brief Opens and binds the raw socket.
+     * * Interface: config->interface_name, else NET_IFACE, else the first
+     * * UP/RUNNING non-loopback interface.
+     * @return 0 on success, non-zero on failure.
+     */
+    int init(const net::NetworkConfig* config, NetworkFiltering filtering);
+    void shutdown();
+
+    /**
+     * @brief Enables SO_TIMESTAMPING on the socket (call after init()).
+     * * HARDWARE also asks the NIC (SIOCSHWTSTAMP) and falls back to software
+     * * stamps if it refuses. TX stamps are reported via poll_tx_completion().
+     * @return 0 on success, non-zero on failure.
+     */
+    int enable_timestamping(TimestampMode mode);
+    bool hardware_timestamping() const { return m_hw_timestamping; }
+
+    /**
+     * @brief Socket-level busy polling (SO_BUSY_POLL, SO_PREFER_BUSY_POLL).
+     * * receive() then polls the driver queue for up to 'busy_poll_us' instead
+     * * of waiting for the interrupt path. Values above net.core.busy_read
+     * * need CAP_NET_ADMIN. 0 turns it off.
+     * @return 0 on success, non-zero on failure.
+     */
+    int enable_busy_poll(uint32_t busy_poll_us, bool prefer_busy_poll);
+
+    /**
+     * @brief PACKET_VNET_HDR mode: every frame carries a virtio_net_hdr, so
+     * * receive() can return GRO-coalesced super-frames (see last_rx_offload())
+     * * and send(..., offload) can hand the kernel GSO segments and frames
+     * * needing checksum offload. GRO itself is enabled on the interface
+     * * (ethtool -K <if> gro on). Call after init().
+     * @return 0 on success, non-zero on failure.
+     */
+    int enable_offloads(bool enable);
+
+    /**
+     * @brief Switches RX/TX to io_uring (see LinuxIoUring): frames arrive
+     * * through a multishot recv into 'rx_buffers' kernel-provided buffers and
+     * * sends are queued in 'tx_slots' slots, then submitted together by
+     * * flush() (the stack calls it at the end of each poll()) or wait().
+     * * send() returns once the frame is queued; later failures are counted
+     * * in io_uring_tx_errors(). Excludes timestamping and offloads. Call
+     * * after init(); shutdown() returns to recv/send.
+     * @return 0 on success, non-zero on failure (recv/send stays in use).
+     */
+    int enable_io_uring(uint32_t rx_buffers, uint32_t tx_slots);
+    bool io_uring_enabled() const { return m_uring.active(); }
+    uint32_t io_uring_tx_errors() const { return m_uring.tx_errors(); }
+    uint32_t io_uring_tx_ring_full() const { return m_uring.tx_ring_full(); }
+
+    int send(const void* data, size_t length)
+    {
+        if (m_vnet_hdr) return send(data, length, net::PacketOffload{});
+        if (m_sock < 0 || data == nullptr || length == 0) return -1;
+        if (m_uring.active()) {
+            // Only through the ring: a direct send could overtake frames the
+            // kernel has not sent yet. With no slot free the frame is dropped,
+            // as by a NIC whose TX ring is full.
+            return m_uring.queue_send(data, length) ? 0 : -1;
+        }
+        note_tx_submit();
+        // Ethernet header (dst/src/type) is already in 'data' — just send it.
+        ssize_t n = ::send(m_sock, data, length, 0);
+        if (n != static_cast<ssize_t>(length)) {
+            NET_LOG_ERROR(HAL, "send() failed on %s (%zd/%zu)", m_ifname, n, length);
+            return -1;
+        }
+        note_tx_sent();
+        return 0;
+    }
+
+    // Sends with GSO/checksum offload; needs enable_offloads() unless 'offload' is empty.
+    int send(const void* data, size_t length, const net::PacketOffload& offload);
+
+    size_t receive(void* buffer, size_t max_length)
+    {
+        if (m_timestamping || m_vnet_hdr) return receive_msg(buffer, max_length, nullptr);
+        if (m_sock < 0 || buffer == nullptr || max_length == 0) return 0;
+        if (m_uring.active()) return receive_ring(buffer, max_length);
+
+        // Non-blocking read of a single frame. MSG_TRUNC reports the real
+        // length, so frames larger than the buffer are dropped, not cut short.
+        ssize_t n = ::recv(m_sock, buffer, max_length, MSG_DONTWAIT | MSG_TRUNC);
+        if (n <= 0) {
+            return 0; // nothing available or EAGAIN; caller polls again
+        }
+        if (static_cast<size_t>(n) > max_length) {
+            note_truncated(static_cast<size_t>(n), max_length);
+            return 0;
+        }
+
+        return passes_filter(buffer, static_cast<size_t>(n)) ? static_cast<size_t>(n) : 0;
+    }
+
+    // receive() plus the kernel/NIC arrival stamps (zeros if timestamping is off).
+    size_t receive(void* buffer, size_t max_length, net::FrameTimestamp& timestamp)
+    {
+        if (!m_timestamping && !m_vnet_hdr) {
+            timestamp = {};
+            return receive(buffer, max_length);
+        }
+        return receive_msg(buffer, max_length, &timestamp);
+    }
+
+    // Offload metadata of the frame returned by the last receive().
+    const net::PacketOffload& last_rx_offload() const { return m_rx_offload; }
+
+    // Fetches one TX timestamp from the socket error queue, if any.
+    bool poll_tx_completion(net::TxCompletion& completion);
+
+    // Software stamps are taken on CLOCK_REALTIME.
+    uint64_t timestamp_now_ns()
+    {
+        timespec ts{};
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000u + static_cast<uint64_t>(ts.tv_nsec);
+    }
+
+    // Submits the sends queued in io_uring mode; nothing to do otherwise.
+    void flush() { m_uring.flush(); }
+
+    bool wait(uint32_t timeout_ms)
+    {
+        if (m_sock < 0) return false;
+        if (m_uring.active()) return m_uring.wait(timeout_ms);
+
+        // Socket plus the wake-up eventfd (poll() ignores a negative fd).
+        pollfd pfd[2]{};
+        pfd[0].fd = m_sock;
+        pfd[0].events = POLLIN;
+        pfd[1].fd = m_wake_fd;
+        pfd[1].events = POLLIN;
+        // poll() takes an int; clamp "forever"-sized timeouts.
+        const int timeout = timeout_ms > static_cast<uint32_t>(INT_MAX) ? -1 : static_cast<int>(timeout_ms);
+        const int ready = ::poll(pfd, 2, timeout);
+        if (ready > 0 && (pfd[1].revents & POLLIN)) {
+            uint64_t count = 0;
+            (void)::read(m_wake_fd, &count, sizeof(count));
+        }
+        // A wake() is not a frame (RunLoopStats counts the difference).
+        return ready > 0 && (pfd[0].revents & POLLIN) != 0;
+    }
+
+    // Thread-safe: makes a wait() in progress on the poll thread return.
+    void wake()
+    {
+        if (m_wake_fd >= 0) {
+            const uint64_t one = 1;
+            (void)::write(m_wake_fd, &one, sizeof(one));
+        }
+    }
+
+    const char* interface_name() const { return m_ifname; }
+    int ifindex() const { return m_ifindex; }
+    const uint8_t* mac() const { return m_mac; }
+    int fd() const { return m_sock; }
+    uint32_t mtu() const { return m_mtu; }
+
+    // Frames dropped because they did not fit the receive buffer.
+    uint32_t rx_truncated() const { return m_rx_truncated; }
+
+private:
+    // Optional software filter: drop frames the stack doesn't handle
+    bool passes_filter(const void* buffer, size_t n) const
+    {
+        if (m_filtering != NetworkFiltering::NONE && n >= 14) {
+            const uint8_t* p = static_cast<const uint8_t*>(buffer);
+            // ethertype = bytes 12..13
+            uint16_t ethertype_be = static_cast<uint16_t>((p[12] << 8) | p[13]);
+            if (ethertype_be != 0x0806 &&
+                !(ethertype_be == 0x0800 && m_filtering == NetworkFiltering::ARP_IPV4)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Kernel numbers timestamped sends from 0 (SOF_TIMESTAMPING_OPT_ID); mirror
+    // it. The submit time goes into the next id's slot before the send, and
+    // the id only advances once the send succeeded, as the kernel's does.
+    void note_tx_submit()
+    {
+        if (m_timestamping) {
+            m_tx_submit_ns[m_tx_next_id % TX_TRACK_SLOTS] = timestamp_now_ns();
+        }
+    }
+
+    void note_tx_sent()
+    {
+        if (m_timestamping) {
+            ++m_tx_next_id;
+        }
+    }
+
+    void note_truncated(size_t frame_length, size_t max_length);
+
+    // receive() in io_uring mode: copy the next frame out of its ring buffer.
+    size_t receive_ring(void* buffer, size_t max_length)
+    {
+        LinuxIoUring::Frame frame;
+        while (m_uring.next_frame(frame)) {
+            const size_t n = frame.length;
+            const bool fits = n <= max_length && !frame.truncated;
+            if (fits) {
+                std::memcpy(buffer, frame.data, n);
+            }
+            m_uring.release(frame);
+            if (!fits) {
+                note_truncated(n, max_length);
+            } else if (passes_filter(buffer, n)) {
+                return n;
+            }
+        }
+        if (m_uring.rx_failed()) {
+            // RX stopped for good: back to recv()/send() rather than deaf.
+            NET_LOG_WARN(HAL, "%s: io_uring RX failed, back to recv/send", m_ifname);
+            m_uring.shutdown();
+        }
+        return 0;
+    }
+
+    // recvmsg() path for timestamps and/or the virtio_net_hdr ('timestamp' may be null).
+    size_t receive_msg(void* buffer, size_t max_length, net::FrameTimestamp* timestamp);
+
+    // Submit times of recent sends, indexed by TX id, to pair with completions.
+    static constexpr uint32_t TX_TRACK_SLOTS = 64;
+
+    int     m_sock = -1;
+    int     m_wake_fd = -1;
+    int     m_ifindex = 0;
+    char    m_ifname[IFNAMSIZ] = {};
+    NetworkFiltering m_filtering = NetworkFiltering::NONE;
+    uint8_t m_mac[6] = {0};
+    uint32_t m_mtu = 0;
+    uint32_t m_rx_truncated = 0;
+
+    bool     m_vnet_hdr = false;
+    net::PacketOffload m_rx_offload;
+
+    bool     m_timestamping = false;
+    bool     m_hw_timestamping = false;
+    uint32_t m_tx_next_id = 0;
+    uint64_t m_tx_submit_ns[TX_TRACK_SLOTS] = {};
+
+    LinuxIoUring m_uring;
+};
+
+static_assert(NetworkHal<LinuxRawSocketHal>);
+static_assert(TimestampingHal<LinuxRawSocketHal>);
+static_assert(OffloadHal<LinuxRawSocketHal>);
+static_assert(WakeableHal<LinuxRawSocketHal>);
+static_assert(BatchingHal<LinuxRawSocketHal>);
+
+#endif // HAL_LINUX_RAW_SOCKET_HAL_H
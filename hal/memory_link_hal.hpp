@@ -0,0 +1,105 @@
+#ifndef HAL_MEMORY_LINK_HAL_H
+#define HAL_MEMORY_LINK_HAL_H
+
+#include "hal/hal_network.hpp"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @brief One end of an in-memory Ethernet link between two stacks in a process.
+ * * connect() joins two ends; send() on one copies the frame into the other's
+ * * receive ring. A full ring drops the frame and counts it, like a NIC out
+ * * of RX descriptors; the sender cannot tell, as on a real wire. No syscalls
+ * * and no clock, so a pair of stacks polled in turn costs only what the
+ * * stacks themselves do (see LoadTest.cpp). Not thread-safe: poll both ends
+ * * from the same thread. Fixed capacity, no heap.
+ * @tparam RxSlots       frames queued towards this end, power of two
+ * @tparam MaxFrameBytes largest frame the link carries
+ */
+template <size_t RxSlots = 256, size_t MaxFrameBytes = 1514>
+class MemoryLinkHal {
+    static_assert(std::has_single_bit(RxSlots), "MemoryLinkHal RxSlots must be a power of two");
+
+public:
+    MemoryLinkHal() = default;
+    MemoryLinkHal(const MemoryLinkHal&) = delete;
+    MemoryLinkHal& operator=(const MemoryLinkHal&) = delete;
+
+    static void connect(MemoryLinkHal& a, MemoryLinkHal& b)
+    {
+        a.m_peer = &b;
+        b.m_peer = &a;
+    }
+
+    // --- NetworkHal ---
+    int send(const void* data, size_t length)
+    {
+        if (m_peer == nullptr || length > MaxFrameBytes) {
+            return -1;
+        }
+        ++m_tx_frames;
+        m_peer->deliver(data, length);
+        return 0;
+    }
+
+    size_t receive(void* buffer, size_t max_length)
+    {
+        // A frame too large for the caller's buffer is dropped and counted;
+        // returning 0 for it would end the caller's poll batch early.
+        while (m_rx_head != m_rx_tail) {
+            const Slot& slot = m_rx[m_rx_head & (RxSlots - 1)];
+            ++m_rx_head;
+            if (slot.length > max_length) {
+                ++m_rx_drops;
+                continue;
+            }
+            std::memcpy(buffer, slot.bytes.data(), slot.length);
+            ++m_rx_frames;
+            return slot.length;
+        }
+        return 0;
+    }
+
+    // Never blocks: both ends run on the caller's thread.
+    bool wait(uint32_t) { return m_rx_head != m_rx_tail; }
+
+    size_t rx_queued() const { return m_rx_tail - m_rx_head; }
+    uint64_t tx_frames() const { return m_tx_frames; }
+    uint64_t rx_frames() const { return m_rx_frames; }
+    uint64_t rx_drops() const { return m_rx_drops; }   // ring full, or frame too large
+
+private:
+    struct Slot {
+        size_t length = 0;
+        std::array<std::byte, MaxFrameBytes> bytes;
+    };
+
+    void deliver(const void* data, size_t length)
+    {
+        if (m_rx_tail - m_rx_head == RxSlots) {
+            ++m_rx_drops;
+            return;
+        }
+        Slot& slot = m_rx[m_rx_tail & (RxSlots - 1)];
+        slot.length = length;
+        std::memcpy(slot.bytes.data(), data, length);
+        ++m_rx_tail;
+    }
+
+    MemoryLinkHal* m_peer = nullptr;
+    std::array<Slot, RxSlots> m_rx;
+    size_t m_rx_head = 0;
+    size_t m_rx_tail = 0;
+
+    uint64_t m_tx_frames = 0;
+    uint64_t m_rx_frames = 0;
+    uint64_t m_rx_drops = 0;
+};
+
+static_assert(NetworkHal<MemoryLinkHal<>>);
+
+#endif // HAL_MEMORY_LINK_HAL_H
@@ -0,0 +1,106 @@
+#include "hal/hal_dump.hpp"
+#include "hal/hal_logging.hpp"
+#include "hal/hal_timer.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+    constexpr int FATAL_SIGNALS[] = { SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT };
+
+    char dump_path[256];
+    HalDumpHook dump_hook = nullptr;
+    void* dump_context = nullptr;
+    std::atomic<bool> dumping{ false };
+
+    void write_fd(void* sink_context, const void* data, size_t size)
+    {
+        const int fd = *static_cast<int*>(sink_context);
+        const char* bytes = static_cast<const char*>(data);
+        while (size > 0) {
+            const ssize_t written = ::write(fd, bytes, size);
+            if (written <= 0) {
+                if (written < 0 && errno == EINTR) {
+                    continue;
+                }
+                return;
+            }
+            bytes += written;
+            size -= static_cast<size_t>(written);
+        }
+    }
+
+    // Only async-signal-safe calls from here on: open/write/close/clock_gettime.
+    int run_dump()
+    {
+        if (dump_hook == nullptr || dumping.exchange(true)) {
+            return -1;
+        }
+        const int saved_errno = errno;
+        int fd = ::open(dump_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd >= 0) {
+            timespec realtime{};
+            ::clock_gettime(CLOCK_REALTIME, &realtime);
+            HalDumpSink sink;
+            sink.write = write_fd;
+            sink.sink_context = &fd;
+            sink.epoch_offset_us = static_cast<uint64_t>(realtime.tv_sec) * 1000000u +
+                                   static_cast<uint64_t>(realtime.tv_nsec) / 1000u - hal_timer_get_us();
+            dump_hook(dump_context, sink);
+            ::close(fd);
+        }
+        errno = saved_errno;
+        dumping.store(false);
+        return fd >= 0 ? 0 : -1;
+    }
+
+    void on_dump_signal(int signal)
+    {
+        (void)run_dump();
+        if (signal != SIGUSR1) {
+            // Die the way we would have without the handler (core dump, exit status).
+            ::signal(signal, SIG_DFL);
+            ::raise(signal);
+        }
+    }
+
+}
+
+int hal_dump_install(const char* path, HalDumpHook hook, void* context)
+{
+    if (path == nullptr || hook == nullptr || std::strlen(path) >= sizeof(dump_path)) {
+        NET_LOG_ERROR(HAL, "Invalid dump path or hook");
+        return -1;
+    }
+    std::strcpy(dump_path, path);
+    dump_context = context;
+    dump_hook = hook;
+
+    struct sigaction action{};
+    action.sa_handler = on_dump_signal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    for (int signal : FATAL_SIGNALS) {
+        if (::sigaction(signal, &action, nullptr) != 0) {
+            NET_LOG_ERROR(HAL, "sigaction(%d) failed (errno %d)", signal, errno);
+            return -1;
+        }
+    }
+    if (::sigaction(SIGUSR1, &action, nullptr) != 0) {
+        NET_LOG_ERROR(HAL, "sigaction(SIGUSR1) failed (errno %d)", errno);
+        return -1;
+    }
+    NET_LOG_INFO(HAL, "Post-mortem dump to %s on a fatal signal or SIGUSR1", dump_path);
+    return 0;
+}
+
+int hal_dump_now()
+{
+    return run_dump();
+}
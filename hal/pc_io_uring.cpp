@@ -0,0 +1,389 @@
+// hal/pc_io_uring.cpp
+#include "hal/linux_io_uring.hpp"
+#include "hal/hal_logging.hpp"
+
+#include <linux/io_uring.h>
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+int io_uring_setup(uint32_t entries, io_uring_params* params) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int io_uring_enter(int fd, uint32_t to_submit, uint32_t min_complete, uint32_t flags, const void* arg, size_t arg_size) {
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, arg_size));
+}
+
+int io_uring_register(int fd, uint32_t opcode, const void* arg, uint32_t count) {
+    return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+template <typename T>
+T* at_offset(void* base, uint32_t offset) {
+    return reinterpret_cast<T*>(static_cast<uint8_t*>(base) + offset);
+}
+
+size_t page_align(size_t bytes) {
+    const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    return (bytes + page - 1) & ~(page - 1);
+}
+
+} // namespace
+
+int LinuxIoUring::init(int sock, int wake_fd, uint32_t rx_buffers, uint32_t tx_slots, size_t buffer_bytes)
+{
+    // The inline paths use LinuxIoUring's own copies of the ring layouts.
+    static_assert(sizeof(Sqe) == sizeof(io_uring_sqe) && offsetof(Sqe, addr) == offsetof(io_uring_sqe, addr) &&
+                  offsetof(Sqe, user_data) == offsetof(io_uring_sqe, user_data) &&
+                  offsetof(Sqe, buf_group) == offsetof(io_uring_sqe, buf_group));
+    static_assert(sizeof(Cqe) == sizeof(io_uring_cqe) && offsetof(Cqe, flags) == offsetof(io_uring_cqe, flags));
+    static_assert(sizeof(Buf) == sizeof(io_uring_buf) && offsetof(Buf, bid) == offsetof(io_uring_buf, bid) &&
+                  offsetof(Buf, resv) == offsetof(io_uring_buf_ring, tail));
+    static_assert(OP_SEND == IORING_OP_SEND && CQE_F_BUFFER == IORING_CQE_F_BUFFER &&
+                  CQE_F_MORE == IORING_CQE_F_MORE && CQE_BUFFER_SHIFT == IORING_CQE_BUFFER_SHIFT);
+
+    shutdown();
+    if (sock < 0 || !std::has_single_bit(rx_buffers) || rx_buffers > 32768 ||
+        !std::has_single_bit(tx_slots) || tx_slots > 4096 || buffer_bytes == 0) {
+        NET_LOG_ERROR(HAL, "io_uring: RX buffers and TX slots must be powers of two");
+        return -1;
+    }
+
+    // SQ: every TX slot plus the RX and wake-up re-arms. CQ: a completion
+    // per RX buffer and TX slot can be outstanding at once.
+    io_uring_params params{};
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SUBMIT_ALL;
+    params.cq_entries = std::bit_ceil(rx_buffers + tx_slots + 4);
+    const int ring_fd = io_uring_setup(std::bit_ceil(tx_slots + 4), &params);
+    if (ring_fd < 0) {
+        NET_LOG_ERROR(HAL, "io_uring_setup failed (errno %d)", errno);
+        return -1;
+    }
+    m_ring_fd = ring_fd;
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_EXT_ARG)) {
+        NET_LOG_ERROR(HAL, "io_uring: kernel too old (features 0x%x)", params.features);
+        shutdown();
+        return -1;
+    }
+
+    // 1) Map the SQ/CQ rings (one mapping) and the SQE array
+    m_ring_map_bytes = std::max<size_t>(params.sq_off.array + params.sq_entries * sizeof(uint32_t),
+                                        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+    void* ring_map = ::mmap(nullptr, m_ring_map_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            ring_fd, IORING_OFF_SQ_RING);
+    m_sqes_bytes = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = ::mmap(nullptr, m_sqes_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ring_fd, IORING_OFF_SQES);
+    m_ring_map = ring_map == MAP_FAILED ? nullptr : ring_map;
+    m_sqes = sqes == MAP_FAILED ? nullptr : static_cast<Sqe*>(sqes);
+    if (m_ring_map == nullptr || m_sqes == nullptr) {
+        NET_LOG_ERROR(HAL, "io_uring: mmap of the rings failed (errno %d)", errno);
+        shutdown();
+        return -1;
+    }
+    m_sq_head = at_offset<uint32_t>(m_ring_map, params.sq_off.head);
+    m_sq_tail = at_offset<uint32_t>(m_ring_map, params.sq_off.tail);
+    m_sq_mask = *at_offset<uint32_t>(m_ring_map, params.sq_off.ring_mask);
+    m_sq_entries = params.sq_entries;
+    m_sq_tail_local = *m_sq_tail;
+    uint32_t* sq_array = at_offset<uint32_t>(m_ring_map, params.sq_off.array);
+    for (uint32_t i = 0; i < m_sq_entries; ++i) {
+        sq_array[i] = i;  // SQE i always sits in slot i
+    }
+    m_cq_head = at_offset<uint32_t>(m_ring_map, params.cq_off.head);
+    m_cq_tail = at_offset<uint32_t>(m_ring_map, params.cq_off.tail);
+    m_cq_mask = *at_offset<uint32_t>(m_ring_map, params.cq_off.ring_mask);
+    m_cqes = at_offset<Cqe>(m_ring_map, params.cq_off.cqes);
+
+    // 2) Buffer ring, RX buffers, TX slots and their busy flags in one mapping
+    m_buffer_bytes = (buffer_bytes + 63) & ~size_t{ 63 };
+    m_rx_buffers = rx_buffers;
+    m_tx_slots = tx_slots;
+    const size_t ring_bytes = page_align(rx_buffers * sizeof(io_uring_buf));
+    m_buffer_map_bytes = page_align(ring_bytes + (rx_buffers + tx_slots) * m_buffer_bytes + tx_slots);
+    void* buffer_map = ::mmap(nullptr, m_buffer_map_bytes, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (buffer_map == MAP_FAILED) {
+        NET_LOG_ERROR(HAL, "io_uring: mmap of %zu buffer bytes failed", m_buffer_map_bytes);
+        shutdown();
+        return -1;
+    }
+    m_buffer_map = buffer_map;
+    m_buf_ring = static_cast<Buf*>(buffer_map);
+    m_buffers = static_cast<uint8_t*>(buffer_map) + ring_bytes;
+    m_tx_busy = m_buffers + (rx_buffers + tx_slots) * m_buffer_bytes;
+
+    io_uring_buf_reg reg{};
+    reg.ring_addr = reinterpret_cast<uint64_t>(m_buf_ring);
+    reg.ring_entries = rx_buffers;
+    reg.bgid = 0;
+    if (io_uring_register(ring_fd, IORING_REGISTER_PBUF_RING, &reg, 1) != 0) {
+        NET_LOG_ERROR(HAL, "io_uring: registering the buffer ring failed (errno %d)", errno);
+        shutdown();
+        return -1;
+    }
+    for (uint32_t id = 0; id < rx_buffers; ++id) {
+        recycle(static_cast<uint16_t>(id));
+    }
+
+    // 3) Arm RX and the wake-up eventfd
+    m_sock = sock;
+    m_wake_fd = wake_fd;
+    arm_recv();
+    m_rx_rearms = 0;
+    if (wake_fd >= 0) {
+        arm_wake();
+    }
+    if (enter(0, 0) < 0) {
+        NET_LOG_ERROR(HAL, "io_uring_enter failed (errno %d)", errno);
+        shutdown();
+        return -1;
+    }
+    // Kernels with buffer rings but without multishot recv reject it as soon
+    // as it is submitted: fail here, so the caller stays on recv().
+    if (rx_rejected()) {
+        NET_LOG_ERROR(HAL, "io_uring: multishot recv not supported");
+        shutdown();
+        return -1;
+    }
+
+    NET_LOG_INFO(HAL, "io_uring: %u RX buffers, %u TX slots of %zu bytes", rx_buffers, tx_slots, m_buffer_bytes);
+    return 0;
+}
+
+bool LinuxIoUring::rx_rejected() const
+{
+    const uint32_t tail = std::atomic_ref<uint32_t>(*m_cq_tail).load(std::memory_order_acquire);
+    for (uint32_t head = *m_cq_head; head != tail; ++head) {
+        const Cqe& cqe = m_cqes[head & m_cq_mask];
+        if (cqe.user_data == USER_DATA_RX && (cqe.res == -EINVAL || cqe.res == -EOPNOTSUPP)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void LinuxIoUring::cancel_in_flight()
+{
+    // Make room for the cancel: submit whatever is still queued.
+    if (queued() >= m_sq_entries) {
+        (void)enter(0, 0);
+    }
+    Sqe* sqe = next_sqe();
+    if (sqe == nullptr) {
+        return;
+    }
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->op_flags = IORING_ASYNC_CANCEL_ANY;  // cancel_flags
+    sqe->user_data = USER_DATA_CANCEL;
+
+    // Every request ends with a completion without F_MORE (sends with any
+    // completion); wait for all of them, for at most ~100 ms.
+    bool rx_done = m_rx_failed;
+    bool wake_done = m_wake_fd < 0;
+    bool cancel_done = false;
+    auto tx_idle = [this] {
+        return std::all_of(m_tx_busy, m_tx_busy + m_tx_slots, [](uint8_t busy) { return busy == 0; });
+    };
+    for (int round = 0; round < 100 && !(rx_done && wake_done && cancel_done && tx_idle()); ++round) {
+        (void)enter(1, 1);
+        const uint32_t tail = std::atomic_ref<uint32_t>(*m_cq_tail).load(std::memory_order_acquire);
+        for (uint32_t head = *m_cq_head; head != tail; ++head) {
+            const Cqe& cqe = m_cqes[head & m_cq_mask];
+            const bool more = (cqe.flags & IORING_CQE_F_MORE) != 0;
+            if (cqe.user_data >= USER_DATA_TX) {
+                m_tx_busy[cqe.user_data & (m_tx_slots - 1)] = 0;
+            } else if (cqe.user_data == USER_DATA_RX) {
+                rx_done = rx_done || !more;
+            } else if (cqe.user_data == USER_DATA_WAKE) {
+                wake_done = wake_done || !more;
+            } else if (cqe.user_data == USER_DATA_CANCEL) {
+                cancel_done = true;
+            }
+        }
+        std::atomic_ref<uint32_t>(*m_cq_head).store(tail, std::memory_order_release);
+    }
+}
+
+void LinuxIoUring::shutdown()
+{
+    // The kernel may still be writing into RX buffers or reading TX slots:
+    // cancel everything and wait for it before anything is unmapped.
+    if (m_ring_fd >= 0 && m_ring_map != nullptr && m_sqes != nullptr && m_buffer_map != nullptr) {
+        cancel_in_flight();
+    }
+    if (m_ring_fd >= 0) {
+        ::close(m_ring_fd);
+    }
+    if (m_ring_map != nullptr) {
+        ::munmap(m_ring_map, m_ring_map_bytes);
+    }
+    if (m_sqes != nullptr) {
+        ::munmap(m_sqes, m_sqes_bytes);
+    }
+    if (m_buffer_map != nullptr) {
+        ::munmap(m_buffer_map, m_buffer_map_bytes);
+    }
+    m_ring_fd = -1;
+    m_sock = -1;
+    m_wake_fd = -1;
+    m_ring_map = nullptr;
+    m_sqes = nullptr;
+    m_sq_head = m_sq_tail = m_cq_head = m_cq_tail = nullptr;
+    m_cqes = nullptr;
+    m_sq_mask = m_sq_entries = m_sq_tail_local = m_cq_mask = 0;
+    m_buffer_map = nullptr;
+    m_buf_ring = nullptr;
+    m_buffers = m_tx_busy = nullptr;
+    m_buffer_bytes = 0;
+    m_rx_buffers = m_tx_slots = m_tx_next = 0;
+    m_buf_tail = 0;
+    m_rx_failed = false;
+    m_tx_errors = m_tx_ring_full = m_rx_rearms = 0;
+}
+
+bool LinuxIoUring::wait(uint32_t timeout_ms)
+{
+    if (!active()) return false;
+
+    // Only a received frame counts: TX and wake-up completions are reaped
+    // here, so a wake() or a finished send does not look like RX.
+    if (reap_until_frame()) {
+        flush();
+        return true;
+    }
+    (void)enter(1, timeout_ms);
+    return reap_until_frame();
+}
+
+bool LinuxIoUring::queue_send_after_reap(const void* data, size_t length)
+{
+    // Submitting frees SQ entries; AF_PACKET sends mostly complete during
+    // the submit, so reaping frees their slots. Completions behind a
+    // received frame stay queued until next_frame() gets past it.
+    flush();
+    (void)reap_until_frame();
+    if (try_queue_send(data, length)) {
+        return true;
+    }
+    ++m_tx_ring_full;
+    return false;
+}
+
+bool LinuxIoUring::reap_until_frame()
+{
+    while (true) {
+        const uint32_t head = *m_cq_head;
+        if (head == std::atomic_ref<uint32_t>(*m_cq_tail).load(std::memory_order_acquire)) {
+            return false;
+        }
+        const Cqe& cqe = m_cqes[head & m_cq_mask];
+        if (cqe.user_data == USER_DATA_RX && cqe.res > 0 && (cqe.flags & IORING_CQE_F_BUFFER)) {
+            return true;  // left for next_frame()
+        }
+        const uint64_t user_data = cqe.user_data;
+        const int32_t res = cqe.res;
+        const uint32_t flags = cqe.flags;
+        std::atomic_ref<uint32_t>(*m_cq_head).store(head + 1, std::memory_order_release);
+        complete(user_data, res, flags);
+    }
+}
+
+int LinuxIoUring::enter(uint32_t min_complete, uint32_t timeout_ms)
+{
+    std::atomic_ref<uint32_t>(*m_sq_tail).store(m_sq_tail_local, std::memory_order_release);
+    const uint32_t to_submit = queued();
+    if (min_complete == 0) {
+        return io_uring_enter(m_ring_fd, to_submit, 0, 0, nullptr, 0);
+    }
+
+    // EXT_ARG carries the timeout; no timeout structure means wait forever,
+    // matching the poll() path's clamp of huge values.
+    __kernel_timespec timeout{};
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_nsec = static_cast<long long>(timeout_ms % 1000) * 1'000'000;
+    io_uring_getevents_arg arg{};
+    if (timeout_ms <= static_cast<uint32_t>(INT_MAX)) {
+        arg.ts = reinterpret_cast<uint64_t>(&timeout);
+    }
+    return io_uring_enter(m_ring_fd, to_submit, min_complete, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                          &arg, sizeof(arg));
+}
+
+void LinuxIoUring::arm_recv()
+{
+    if (m_rx_failed) return;
+
+    Sqe* sqe = next_sqe();
+    if (sqe == nullptr) {
+        NET_LOG_ERROR(HAL, "io_uring: submission queue full, RX not re-armed");
+        return;
+    }
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = m_sock;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = 0;
+    sqe->user_data = USER_DATA_RX;
+    ++m_rx_rearms;
+    // Straight away: frames are not picked up until the recv is armed.
+    (void)enter(0, 0);
+}
+
+void LinuxIoUring::arm_wake()
+{
+    Sqe* sqe = next_sqe();
+    if (sqe == nullptr) {
+        NET_LOG_ERROR(HAL, "io_uring: submission queue full, wake-ups not re-armed");
+        return;
+    }
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = m_wake_fd;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->op_flags = POLLIN;  // poll32_events
+    sqe->user_data = USER_DATA_WAKE;
+}
+
+void LinuxIoUring::complete(uint64_t user_data, int32_t res, uint32_t flags)
+{
+    const bool more = (flags & IORING_CQE_F_MORE) != 0;
+    if (user_data >= USER_DATA_TX) {
+        m_tx_busy[user_data & (m_tx_slots - 1)] = 0;
+        if (res < 0) {
+            ++m_tx_errors;
+            NET_LOG_ERROR(HAL, "io_uring send failed (errno %d)", -res);
+        }
+    } else if (user_data == USER_DATA_WAKE) {
+        uint64_t count = 0;
+        (void)::read(m_wake_fd, &count, sizeof(count));
+        if (!more) {
+            arm_wake();
+        }
+    } else if (user_data == USER_DATA_RX) {
+        if (flags & IORING_CQE_F_BUFFER) {
+            recycle(static_cast<uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT)); // empty frame
+        }
+        if (res < 0 && res != -ENOBUFS) {
+            NET_LOG_ERROR(HAL, "io_uring recv failed (errno %d)", -res);
+            // Unsupported (pre-6.0 kernel) or a dead socket: re-arming would spin.
+            m_rx_failed = (res == -EINVAL || res == -EOPNOTSUPP || res == -EBADF);
+        }
+        if (!more) {
+            arm_recv();
+        }
+    }
+}
@@ -1,10 +1,14 @@
 // hal/pc_linux_hal.cpp
 #include "hal/hal_network.hpp"
+#include "hal/hal_network_extensions.hpp"
 #include "hal/hal_logging.hpp"
+#include "hal/linux_raw_socket_hal.hpp"
+#include "net_stack/memory_config.hpp"
 
 #include <cstdint>
 #include <cstddef>
 #include <cstring>
+#include <cstdlib>
 
 #include <unistd.h>
 #include <fcntl.h>
@@ -14,20 +18,21 @@
 
 #include <linux/if_packet.h>
 #include <linux/if_ether.h>   // ETH_P_ALL
+#include <linux/errqueue.h>   // scm_timestamping, sock_extended_err
+#include <linux/net_tstamp.h> // SOF_TIMESTAMPING_*, hwtstamp_config
+#include <linux/sockios.h>    // SIOCSHWTSTAMP
+#include <sys/uio.h>
+#include <sys/eventfd.h>
 #include <net/if.h>           // ifreq, SIOCGIF*, IFNAMSIZ
+#include <cerrno>
 
 namespace {
 
-// --- Module state (PC HAL only; no dynamic allocation) ---
-int   g_sock = -1;
-int   g_ifindex = 0;
-char  g_ifname[IFNAMSIZ] = {};
-bool  g_filter_arp_only = false;
-uint8_t g_mac[6] = {0};
+// Instance behind the free-function API (PC HAL only; no dynamic allocation)
+LinuxRawSocketHal g_default_hal;
 
-// tiny htons/ntohs wrappers (we could use the libc ones directly)
+// tiny htons wrapper (we could use the libc one directly)
 inline uint16_t be16(uint16_t x) { return htons(x); }
-inline uint16_t from_be16(uint16_t x) { return ntohs(x); }
 
 bool set_nonblocking(int fd) {
     int flags = fcntl(fd, F_GETFL, 0);
@@ -35,6 +40,14 @@ bool set_nonblocking(int fd) {
     return fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
 }
 
+// Copy an interface name into an IFNAMSIZ buffer, truncating and always
+// NUL-terminating (strncpy leaves that to the caller and GCC warns about it).
+void copy_ifname(char* dst, const char* src) {
+    const size_t len = ::strnlen(src, IFNAMSIZ - 1);
+    std::memcpy(dst, src, len);
+    dst[len] = '\0';
+}
+
 // Enumerate interfaces using SIOCGIFCONF without heap; pick first UP/RUNNING non-loopback.
 bool pick_default_iface(int fd, char out_name[IFNAMSIZ]) {
     // Buffer for list of ifreq entries
@@ -65,7 +78,7 @@ bool pick_default_iface(int fd, char out_name[IFNAMSIZ]) {
 
         // Query flags
         ifreq fr_flags{};
-        std::strncpy(fr_flags.ifr_name, ifr->ifr_name, IFNAMSIZ - 1);
+        copy_ifname(fr_flags.ifr_name, ifr->ifr_name);
         if (ioctl(fd, SIOCGIFFLAGS, &fr_flags) < 0) {
             continue;
         }
@@ -76,7 +89,7 @@ bool pick_default_iface(int fd, char out_name[IFNAMSIZ]) {
         const bool is_loopback = (fl & IFF_LOOPBACK) != 0;
 
         if (is_up && is_running && !is_loopback) {
-            std::strncpy(out_name, ifr->ifr_name, IFNAMSIZ - 1);
+            copy_ifname(out_name, ifr->ifr_name);
             return true;
         }
     }
@@ -85,7 +98,7 @@ bool pick_default_iface(int fd, char out_name[IFNAMSIZ]) {
 
 bool resolve_ifindex_mac(int fd, const char* ifname, int& out_ifindex, uint8_t mac[6]) {
     ifreq ifr{};
-    std::strncpy(ifr.ifr_name, ifname, IFNAMSIZ - 1);
+    copy_ifname(ifr.ifr_name, ifname);
 
     // ifindex
     if (ioctl(fd, SIOCGIFINDEX, &ifr) < 0) {
@@ -103,6 +116,101 @@ bool resolve_ifindex_mac(int fd, const char* ifname, int& out_ifindex, uint8_t m
     return true;
 }
 
+uint32_t read_mtu(int fd, const char* ifname) {
+    ifreq ifr{};
+    copy_ifname(ifr.ifr_name, ifname);
+    if (ioctl(fd, SIOCGIFMTU, &ifr) < 0 || ifr.ifr_mtu < 0) {
+        return 0;
+    }
+    return static_cast<uint32_t>(ifr.ifr_mtu);
+}
+
+// struct virtio_net_hdr as exchanged with PACKET_VNET_HDR sockets, in host
+// byte order. Spelled out because <linux/virtio_net.h> does not compile as C++.
+struct virtio_net_hdr {
+    uint8_t  flags;
+    uint8_t  gso_type;
+    uint16_t hdr_len;
+    uint16_t gso_size;
+    uint16_t csum_start;
+    uint16_t csum_offset;
+};
+static_assert(sizeof(virtio_net_hdr) == 10);
+
+constexpr uint8_t VIRTIO_NET_HDR_F_NEEDS_CSUM = 1;
+constexpr uint8_t VIRTIO_NET_HDR_F_DATA_VALID = 2;
+constexpr uint8_t VIRTIO_NET_HDR_GSO_NONE = 0;
+constexpr uint8_t VIRTIO_NET_HDR_GSO_TCPV4 = 1;
+constexpr uint8_t VIRTIO_NET_HDR_GSO_TCPV6 = 4;
+constexpr uint8_t VIRTIO_NET_HDR_GSO_UDP_L4 = 5;
+constexpr uint8_t VIRTIO_NET_HDR_GSO_ECN = 0x80;
+
+// virtio_net_hdr <-> PacketOffload.
+net::PacketOffload offload_from_vnet(const virtio_net_hdr& hdr) {
+    net::PacketOffload offload;
+    switch (hdr.gso_type & static_cast<uint8_t>(~VIRTIO_NET_HDR_GSO_ECN)) {
+    case VIRTIO_NET_HDR_GSO_TCPV4: offload.gso = net::PacketOffload::Gso::TCPV4; break;
+    case VIRTIO_NET_HDR_GSO_TCPV6: offload.gso = net::PacketOffload::Gso::TCPV6; break;
+    case VIRTIO_NET_HDR_GSO_UDP_L4: offload.gso = net::PacketOffload::Gso::UDP_L4; break;
+    default: break;
+    }
+    offload.gso_size = hdr.gso_size;
+    offload.header_bytes = hdr.hdr_len;
+    offload.needs_checksum = (hdr.flags & VIRTIO_NET_HDR_F_NEEDS_CSUM) != 0;
+    offload.checksum_valid = (hdr.flags & VIRTIO_NET_HDR_F_DATA_VALID) != 0;
+    offload.csum_start = hdr.csum_start;
+    offload.csum_offset = hdr.csum_offset;
+    return offload;
+}
+
+bool vnet_from_offload(const net::PacketOffload& offload, virtio_net_hdr& hdr) {
+    hdr = {};
+    switch (offload.gso) {
+    case net::PacketOffload::Gso::NONE:   hdr.gso_type = VIRTIO_NET_HDR_GSO_NONE; break;
+    case net::PacketOffload::Gso::TCPV4:  hdr.gso_type = VIRTIO_NET_HDR_GSO_TCPV4; break;
+    case net::PacketOffload::Gso::TCPV6:  hdr.gso_type = VIRTIO_NET_HDR_GSO_TCPV6; break;
+    case net::PacketOffload::Gso::UDP_L4: hdr.gso_type = VIRTIO_NET_HDR_GSO_UDP_L4; break;
+    default: return false;
+    }
+    hdr.gso_size = offload.gso_size;
+    hdr.hdr_len = offload.header_bytes;
+    if (offload.needs_checksum) {
+        hdr.flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+        hdr.csum_start = offload.csum_start;
+        hdr.csum_offset = offload.csum_offset;
+    }
+    return true;
+}
+
+uint64_t to_ns(const timespec& ts) {
+    return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000u + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+// Pulls the SO_TIMESTAMPING stamps out of a recvmsg() control buffer.
+// ts[0] is the software stamp, ts[2] the raw hardware stamp.
+void parse_timestamps(msghdr& msg, net::FrameTimestamp& out) {
+    for (cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg, cm)) {
+        if (cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_TIMESTAMPING) {
+            scm_timestamping stamps{};
+            std::memcpy(&stamps, CMSG_DATA(cm), sizeof(stamps));
+            out.software_ns = to_ns(stamps.ts[0]);
+            out.hardware_ns = to_ns(stamps.ts[2]);
+        }
+    }
+}
+
+// Asks the driver to stamp every frame in hardware. Fails on most virtual NICs.
+bool enable_hw_timestamps(int fd, const char* ifname) {
+    hwtstamp_config cfg{};
+    cfg.tx_type = HWTSTAMP_TX_ON;
+    cfg.rx_filter = HWTSTAMP_FILTER_ALL;
+
+    ifreq ifr{};
+    copy_ifname(ifr.ifr_name, ifname);
+    ifr.ifr_data = reinterpret_cast<char*>(&cfg);
+    return ioctl(fd, SIOCSHWTSTAMP, &ifr) == 0;
+}
+
 bool bind_af_packet(int fd, int ifindex) {
     sockaddr_ll sll{};
     sll.sll_family   = AF_PACKET;
@@ -113,100 +221,405 @@ bool bind_af_packet(int fd, int ifindex) {
 
 } // namespace
 
-// ------------------ Public HAL API (matches hal_network.hpp) ------------------
+// ------------------ LinuxRawSocketHal ------------------
 
-int hal_net_init(const net::NetworkConfig* /*config*/, NetworkFiltering filtering)
+int LinuxRawSocketHal::init(const net::NetworkConfig* config, NetworkFiltering filtering)
 {
-    g_filter_arp_only = (filtering == NetworkFiltering::ARP);
+    shutdown();
+    m_filtering = filtering;
 
     // 1) Open raw AF_PACKET socket
-    g_sock = ::socket(AF_PACKET, SOCK_RAW, be16(ETH_P_ALL));
-    if (g_sock < 0) {
+    m_sock = ::socket(AF_PACKET, SOCK_RAW, be16(ETH_P_ALL));
+    if (m_sock < 0) {
         NET_LOG_ERROR(HAL, "socket(AF_PACKET) failed");
         return -1;
     }
     
 
-    // 2) Pick interface: use NET_IFACE env, else first UP/RUNNING non-loopback
+    // 2) Pick interface: config name, else NET_IFACE env, else first UP/RUNNING non-loopback
     const char* env = std::getenv("NET_IFACE");
-    if (env && *env) {
-        std::strncpy(g_ifname, env, IFNAMSIZ - 1);
+    if (config != nullptr && config->interface_name != nullptr && *config->interface_name) {
+        copy_ifname(m_ifname, config->interface_name);
+    } else if (env && *env) {
+        copy_ifname(m_ifname, env);
     } else {
-        if (!pick_default_iface(g_sock, g_ifname)) {
+        if (!pick_default_iface(m_sock, m_ifname)) {
             NET_LOG_ERROR(HAL, "No suitable interface found; set NET_IFACE");
-            ::close(g_sock); g_sock = -1;
+            shutdown();
             return -1;
         }
     }
 
     // 3) Resolve ifindex + MAC
-    if (!resolve_ifindex_mac(g_sock, g_ifname, g_ifindex, g_mac)) {
-        ::close(g_sock); g_sock = -1;
+    if (!resolve_ifindex_mac(m_sock, m_ifname, m_ifindex, m_mac)) {
+        shutdown();
         return -1;
     }
 
     // 4) Bind and make non-blocking
-    if (!bind_af_packet(g_sock, g_ifindex)) {
-        NET_LOG_ERROR(HAL, "bind(AF_PACKET) failed on %s", g_ifname);
-        ::close(g_sock); g_sock = -1;
+    if (!bind_af_packet(m_sock, m_ifindex)) {
+        NET_LOG_ERROR(HAL, "bind(AF_PACKET) failed on %s", m_ifname);
+        shutdown();
         return -1;
     }
-    (void)set_nonblocking(g_sock);
+    (void)set_nonblocking(m_sock);
+
+    // Lets other threads interrupt wait() (see wake()).
+    m_wake_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_wake_fd < 0) {
+        NET_LOG_WARN(HAL, "eventfd() failed; wake() will not interrupt wait()");
+    }
+
+    m_mtu = read_mtu(m_sock, m_ifname);
+    if (m_mtu + 14u > net::k_memory_config.frame_buffer_bytes) {
+        NET_LOG_WARN(HAL, "%s MTU %u exceeds the %zu-byte frame buffer; larger frames will be dropped "
+                          "(raise MemoryConfig::mtu)", m_ifname, m_mtu, net::k_memory_config.frame_buffer_bytes);
+    }
 
-    NET_LOG_INFO(HAL, "HAL init on iface %s (ifindex %d)", g_ifname, g_ifindex);
+    NET_LOG_INFO(HAL, "HAL init on iface %s (ifindex %d, MTU %u)", m_ifname, m_ifindex, m_mtu);
     return 0;
 }
 
-// Overload without filtering argument (kept for your API)
-int hal_net_init(const net::NetworkConfig* config)
+int LinuxRawSocketHal::enable_timestamping(TimestampMode mode)
 {
-    return hal_net_init(config, NetworkFiltering::ARP);
+    if (m_sock < 0) return -1;
+    if (m_uring.active() && mode != TimestampMode::NONE) {
+        NET_LOG_ERROR(HAL, "%s: timestamping is not available in io_uring mode", m_ifname);
+        return -1;
+    }
+
+    int flags = 0;
+    bool hardware = false;
+    if (mode != TimestampMode::NONE) {
+        flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_TX_SOFTWARE |
+                SOF_TIMESTAMPING_SOFTWARE |
+                SOF_TIMESTAMPING_OPT_ID |     // number TX completions
+                SOF_TIMESTAMPING_OPT_TSONLY;  // don't loop the frame back with its stamp
+        if (mode == TimestampMode::HARDWARE) {
+            hardware = enable_hw_timestamps(m_sock, m_ifname);
+            if (hardware) {
+                flags |= SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_TX_HARDWARE |
+                         SOF_TIMESTAMPING_RAW_HARDWARE;
+            } else {
+                NET_LOG_WARN(HAL, "%s: no hardware timestamping, using software stamps", m_ifname);
+            }
+        }
+    }
+
+    if (setsockopt(m_sock, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) != 0) {
+        NET_LOG_ERROR(HAL, "SO_TIMESTAMPING failed on %s", m_ifname);
+        return -1;
+    }
+
+    m_timestamping = (mode != TimestampMode::NONE);
+    m_hw_timestamping = hardware;
+    m_tx_next_id = 0;  // the kernel restarts OPT_ID numbering too
+    NET_LOG_INFO(HAL, "%s: %s timestamping %s", m_ifname,
+                 hardware ? "hardware" : "software", m_timestamping ? "enabled" : "disabled");
+    return 0;
 }
 
-void hal_net_shutdown()
+int LinuxRawSocketHal::enable_busy_poll(uint32_t busy_poll_us, bool prefer_busy_poll)
 {
-    if (g_sock >= 0) {
-        ::close(g_sock);
+    if (m_sock < 0) return -1;
+
+    int usecs = busy_poll_us > static_cast<uint32_t>(INT_MAX) ? INT_MAX : static_cast<int>(busy_poll_us);
+    if (setsockopt(m_sock, SOL_SOCKET, SO_BUSY_POLL, &usecs, sizeof(usecs)) != 0) {
+        NET_LOG_ERROR(HAL, "SO_BUSY_POLL failed on %s (errno %d)", m_ifname, errno);
+        return -1;
+    }
+
+#ifdef SO_PREFER_BUSY_POLL
+    // Linux 5.11+: keep the driver's interrupts deferred while we are polling.
+    int prefer = (prefer_busy_poll && usecs > 0) ? 1 : 0;
+    if (setsockopt(m_sock, SOL_SOCKET, SO_PREFER_BUSY_POLL, &prefer, sizeof(prefer)) != 0) {
+        NET_LOG_WARN(HAL, "SO_PREFER_BUSY_POLL not supported on %s", m_ifname);
     }
-    g_sock = -1;
-    g_ifindex = 0;
-    std::memset(g_ifname, 0, sizeof(g_ifname));
-    std::memset(g_mac, 0, sizeof(g_mac));
-    g_filter_arp_only = false;
+#else
+    (void)prefer_busy_poll;
+#endif
+
+    NET_LOG_INFO(HAL, "%s: socket busy poll %d us", m_ifname, usecs);
+    return 0;
 }
 
-int hal_net_send(const void* data, size_t length)
+int LinuxRawSocketHal::enable_offloads(bool enable)
 {
-    if (g_sock < 0 || data == nullptr || length == 0) return -1;
-    // Ethernet header (dst/src/type) is already in 'data' — just send it.
-    ssize_t n = ::send(g_sock, data, length, 0);
-    if (n != static_cast<ssize_t>(length)) {
-        NET_LOG_ERROR(HAL, "send() failed (%zd/%zu)", n, length);
+    if (m_sock < 0) return -1;
+    if (m_uring.active() && enable) {
+        NET_LOG_ERROR(HAL, "%s: offloads are not available in io_uring mode", m_ifname);
+        return -1;
+    }
+
+    int on = enable ? 1 : 0;
+    if (setsockopt(m_sock, SOL_PACKET, PACKET_VNET_HDR, &on, sizeof(on)) != 0) {
+        NET_LOG_ERROR(HAL, "PACKET_VNET_HDR failed on %s (errno %d)", m_ifname, errno);
         return -1;
     }
+    m_vnet_hdr = enable;
+    m_rx_offload = {};
+    NET_LOG_INFO(HAL, "%s: GSO/GRO offloads %s", m_ifname, enable ? "enabled" : "disabled");
     return 0;
 }
 
-size_t hal_net_receive(void* buffer, size_t max_length)
+int LinuxRawSocketHal::enable_io_uring(uint32_t rx_buffers, uint32_t tx_slots)
 {
-    if (g_sock < 0 || buffer == nullptr || max_length == 0) return 0;
+    if (m_sock < 0) return -1;
+    if (m_timestamping || m_vnet_hdr) {
+        NET_LOG_ERROR(HAL, "%s: io_uring mode excludes timestamping and offloads", m_ifname);
+        return -1;
+    }
 
-    // Non-blocking read of a single frame
-    ssize_t n = ::recv(g_sock, buffer, max_length, MSG_DONTWAIT);
-    if (n <= 0) {
-        return 0; // nothing available or EAGAIN; caller polls again
+    // One byte more than the largest frame we accept, so a frame that fills
+    // its buffer is known to have been cut short.
+    const size_t largest = m_mtu + 14u > net::k_memory_config.frame_buffer_bytes
+        ? m_mtu + 14u : net::k_memory_config.frame_buffer_bytes;
+    if (m_uring.init(m_sock, m_wake_fd, rx_buffers, tx_slots, largest + 1) != 0) {
+        NET_LOG_WARN(HAL, "%s: io_uring unavailable, staying on recv/send", m_ifname);
+        return -1;
+    }
+    NET_LOG_INFO(HAL, "%s: io_uring RX/TX enabled", m_ifname);
+    return 0;
+}
+
+int LinuxRawSocketHal::send(const void* data, size_t length, const net::PacketOffload& offload)
+{
+    if (m_sock < 0 || data == nullptr || length == 0) return -1;
+
+    if (!m_vnet_hdr) {
+        if (offload.gso != net::PacketOffload::Gso::NONE || offload.needs_checksum) {
+            NET_LOG_ERROR(HAL, "send with offload on %s, but offloads are not enabled", m_ifname);
+            return -1;
+        }
+        return send(data, length);
+    }
+
+    virtio_net_hdr hdr{};
+    if (!vnet_from_offload(offload, hdr)) {
+        NET_LOG_ERROR(HAL, "Unsupported GSO type on %s", m_ifname);
+        return -1;
+    }
+    note_tx_submit();
+
+    // Header and frame go out in one sendmsg(); the frame is not copied here.
+    iovec iov[2] = {
+        { &hdr, sizeof(hdr) },
+        { const_cast<void*>(data), length },
+    };
+    msghdr msg{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+
+    ssize_t n = ::sendmsg(m_sock, &msg, 0);
+    if (n != static_cast<ssize_t>(sizeof(hdr) + length)) {
+        NET_LOG_ERROR(HAL, "sendmsg() failed on %s (%zd/%zu, errno %d)", m_ifname, n, length, errno);
+        return -1;
+    }
+    note_tx_sent();
+    return 0;
+}
+
+void LinuxRawSocketHal::note_truncated(size_t frame_length, size_t max_length)
+{
+    ++m_rx_truncated;
+    NET_LOG_WARN(HAL, "Dropped %zu-byte frame on %s: receive buffer is %zu bytes",
+                 frame_length, m_ifname, max_length);
+}
+
+size_t LinuxRawSocketHal::receive_msg(void* buffer, size_t max_length, net::FrameTimestamp* timestamp)
+{
+    if (timestamp != nullptr) {
+        *timestamp = {};
+    }
+    m_rx_offload = {};
+    if (m_sock < 0 || buffer == nullptr || max_length == 0) return 0;
+
+    virtio_net_hdr hdr{};
+    iovec iov[2] = {
+        { &hdr, sizeof(hdr) },
+        { buffer, max_length },
+    };
+    const size_t header_length = m_vnet_hdr ? sizeof(hdr) : 0;
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(scm_timestamping)) + 64];
+    msghdr msg{};
+    msg.msg_iov = m_vnet_hdr ? iov : iov + 1;
+    msg.msg_iovlen = m_vnet_hdr ? 2 : 1;
+    if (m_timestamping) {
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
     }
 
-    // Optional software filter: drop non-ARP frames
-    if (g_filter_arp_only && static_cast<size_t>(n) >= 14) {
-        const uint8_t* p = static_cast<const uint8_t*>(buffer);
-        // ethertype = bytes 12..13
-        uint16_t ethertype_be = (static_cast<uint16_t>(p[12]) << 8) | p[13];
-     if (ethertype_be != 0x0806) {   // compare directly
+    ssize_t n = ::recvmsg(m_sock, &msg, MSG_DONTWAIT | MSG_TRUNC);
+    if (n <= 0 || static_cast<size_t>(n) <= header_length) {
+        return 0; // nothing available or EAGAIN; caller polls again
+    }
+    const size_t frame_length = static_cast<size_t>(n) - header_length;
+    if (frame_length > max_length) {
+        note_truncated(frame_length, max_length);
         return 0;
     }
+    if (!passes_filter(buffer, frame_length)) {
+        return 0;
+    }
+    if (m_vnet_hdr) {
+        m_rx_offload = offload_from_vnet(hdr);
+    }
+    if (timestamp != nullptr && m_timestamping) {
+        parse_timestamps(msg, *timestamp);
+    }
+    return frame_length;
+}
+
+bool LinuxRawSocketHal::poll_tx_completion(net::TxCompletion& completion)
+{
+    if (m_sock < 0 || !m_timestamping) return false;
+
+    // Drain the error queue until we find a TX timestamp (or it is empty).
+    while (true) {
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(scm_timestamping)) +
+                                      CMSG_SPACE(sizeof(sock_extended_err) + sizeof(sockaddr_ll)) + 64];
+        msghdr msg{};
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        if (::recvmsg(m_sock, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            return false; // EAGAIN: nothing queued
+        }
+
+        bool have_id = false;
+        completion = {};
+        for (cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg, cm)) {
+            if (cm->cmsg_level == SOL_PACKET && cm->cmsg_type == PACKET_TX_TIMESTAMP) {
+                sock_extended_err err{};
+                std::memcpy(&err, CMSG_DATA(cm), sizeof(err));
+                if (err.ee_errno == ENOMSG && err.ee_origin == SO_EE_ORIGIN_TIMESTAMPING) {
+                    completion.id = err.ee_data;
+                    have_id = true;
+                }
+            }
+        }
+        if (!have_id) {
+            continue; // some other error-queue message; skip it
+        }
+        parse_timestamps(msg, completion.wire);
+        completion.submitted_ns = m_tx_submit_ns[completion.id % TX_TRACK_SLOTS];
+        return true;
+    }
+}
+
+void LinuxRawSocketHal::shutdown()
+{
+    m_uring.shutdown();
+    if (m_sock >= 0) {
+        ::close(m_sock);
+    }
+    if (m_wake_fd >= 0) {
+        ::close(m_wake_fd);
+    }
+    m_sock = -1;
+    m_wake_fd = -1;
+    m_ifindex = 0;
+    std::memset(m_ifname, 0, sizeof(m_ifname));
+    std::memset(m_mac, 0, sizeof(m_mac));
+    m_filtering = NetworkFiltering::NONE;
+    m_timestamping = false;
+    m_hw_timestamping = false;
+    m_tx_next_id = 0;
+    m_vnet_hdr = false;
+    m_rx_offload = {};
+    m_mtu = 0;
+}
+
+// ------------------ Public HAL API (matches hal_network.hpp) ------------------
+
+int hal_net_init(const net::NetworkConfig* config, NetworkFiltering filtering)
+{
+    return g_default_hal.init(config, filtering);
+}
+
+// Overload without filtering argument (kept for your API)
+int hal_net_init(const net::NetworkConfig* config)
+{
+    return hal_net_init(config, NetworkFiltering::ARP);
+}
+
+void hal_net_shutdown()
+{
+    g_default_hal.shutdown();
+}
+
+int hal_net_send(const void* data, size_t length)
+{
+    return g_default_hal.send(data, length);
+}
+
+size_t hal_net_receive(void* buffer, size_t max_length)
+{
+    return g_default_hal.receive(buffer, max_length);
+}
+
+bool hal_net_wait(uint32_t timeout_ms)
+{
+    return g_default_hal.wait(timeout_ms);
+}
+
+int hal_net_enable_timestamping(TimestampMode mode)
+{
+    return g_default_hal.enable_timestamping(mode);
+}
+
+size_t hal_net_receive(void* buffer, size_t max_length, net::FrameTimestamp* timestamp)
+{
+    if (timestamp == nullptr) {
+        return g_default_hal.receive(buffer, max_length);
+    }
+    return g_default_hal.receive(buffer, max_length, *timestamp);
+}
+
+bool hal_net_poll_tx_completion(net::TxCompletion* completion)
+{
+    return completion != nullptr && g_default_hal.poll_tx_completion(*completion);
+}
+
+uint64_t hal_net_timestamp_now_ns()
+{
+    return g_default_hal.timestamp_now_ns();
+}
+
+int hal_net_enable_busy_poll(uint32_t busy_poll_us, bool prefer_busy_poll)
+{
+    return g_default_hal.enable_busy_poll(busy_poll_us, prefer_busy_poll);
+}
 
+int hal_net_enable_offloads(bool enable)
+{
+    return g_default_hal.enable_offloads(enable);
+}
+
+int hal_net_send(const void* data, size_t length, const net::PacketOffload* offload)
+{
+    if (offload == nullptr) {
+        return g_default_hal.send(data, length);
     }
+    return g_default_hal.send(data, length, *offload);
+}
 
-    return static_cast<size_t>(n);
+const net::PacketOffload* hal_net_last_rx_offload()
+{
+    return &g_default_hal.last_rx_offload();
+}
+
+void hal_net_wake()
+{
+    g_default_hal.wake();
+}
+
+int hal_net_enable_io_uring(uint32_t rx_buffers, uint32_t tx_slots)
+{
+    return g_default_hal.enable_io_uring(rx_buffers, tx_slots);
+}
+
+void hal_net_flush()
+{
+    g_default_hal.flush();
 }
@@ -1,31 +1,25 @@
 #include "hal/hal_logging.hpp"
-#include <iostream>
+#include "net_stack/memory_config.hpp"
+#include <array>
 #include <cstdarg>
 #include <cstdio>
-#include <map>
 
 
 
-    // Helper to convert component enum to string for printing
-    static const std::map<net::LogComponent, std::string> component_names = {
-        {net::LogComponent::HAL, "HAL"},
-        {net::LogComponent::NET, "NET"},
-        {net::LogComponent::ARP, "ARP"},
-        {net::LogComponent::IP, "IP"},
-        {net::LogComponent::ICMP, "ICMP"},
-        {net::LogComponent::UDP, "UDP"},
-        {net::LogComponent::TCP, "TCP"},
-        {net::LogComponent::DHCP, "DHCP"},
+    // Names for printing, indexed by the enum values. Plain arrays, no heap.
+    static constexpr std::array<const char*, 8> component_names = {
+        "HAL", "NET", "ARP", "IP", "ICMP", "UDP", "TCP", "DHCP",
     };
 
-    // Helper to convert level enum to string for printing
-    static const std::map<LogLevel, std::string> level_names = {
-        {LogLevel::NONE,  "NONE"},
-        {LogLevel::ERROR, "ERROR"},
-        {LogLevel::WARN,  "WARN"},
-        {LogLevel::INFO,  "INFO"},
-        {LogLevel::DEBUG, "DEBUG"},
+    static constexpr std::array<const char*, 5> level_names = {
+        "NONE", "ERROR", "WARN", "INFO", "DEBUG",
     };
+
+    template <size_t N>
+    static const char* name_of(const std::array<const char*, N>& names, int index) {
+        return (index >= 0 && static_cast<size_t>(index) < N) ? names[static_cast<size_t>(index)] : "?";
+    }
+
     void hal_log(net::LogComponent component, LogLevel level, const char* fmt, ...) {
         // --- FIX #2: Immediately return if the level is NONE ---
         // This is the most important part of the fix.
@@ -39,26 +33,26 @@
             return;
         }
 
-        // Build the log prefix, e.g., "[ARP] [DEBUG] "
-        // This line will no longer crash because we added the NONE entry.
-        std::string prefix = "[" + component_names.at(component) + "] [" + level_names.at(level) + "] ";
+        // Build the whole line, e.g. "[ARP] [DEBUG] ...", in one fixed buffer.
+        // Lines longer than the buffer are truncated.
+        char buffer[net::k_memory_config.log_line_bytes];
+        int prefix = std::snprintf(buffer, sizeof(buffer), "[%s] [%s] ",
+                                   name_of(component_names, static_cast<int>(component)),
+                                   name_of(level_names, static_cast<int>(level)));
+        if (prefix < 0) {
+            return;
+        }
+        size_t used = static_cast<size_t>(prefix) < sizeof(buffer) ? static_cast<size_t>(prefix) : sizeof(buffer) - 1;
 
         // Use vsnprintf to handle the variable arguments safely
-        char buffer[256];
         va_list args;
         va_start(args, fmt);
-        vsnprintf(buffer, sizeof(buffer), fmt, args);
+        std::vsnprintf(buffer + used, sizeof(buffer) - used, fmt, args);
         va_end(args);
 
         // Print to the appropriate stream
-        if (level == LogLevel::ERROR) {
-            std::cerr << prefix << buffer << std::endl;
-        }
-        else {
-            std::cout << prefix << buffer << std::endl;
-        }
+        std::FILE* stream = (level == LogLevel::ERROR) ? stderr : stdout;
+        std::fputs(buffer, stream);
+        std::fputc('\n', stream);
+        std::fflush(stream);
     }
-
-
-
-
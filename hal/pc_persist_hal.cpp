@@ -0,0 +1,55 @@
+#include "hal/hal_persist.hpp"
+#include "hal/hal_logging.hpp"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+int hal_persist_map(const char* name, size_t size, HalPersistentRegion& region)
+{
+    if (name == nullptr || size == 0) {
+        NET_LOG_ERROR(HAL, "Invalid persistent region");
+        return -1;
+    }
+    const int fd = ::open(name, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        NET_LOG_ERROR(HAL, "Cannot open %s (errno %d)", name, errno);
+        return -1;
+    }
+    struct stat status{};
+    if (::fstat(fd, &status) != 0 ||
+        (static_cast<size_t>(status.st_size) != size && ::ftruncate(fd, static_cast<off_t>(size)) != 0)) {
+        NET_LOG_ERROR(HAL, "Cannot size %s to %zu bytes (errno %d)", name, size, errno);
+        ::close(fd);
+        return -1;
+    }
+    void* data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        NET_LOG_ERROR(HAL, "mmap of %s failed (errno %d)", name, errno);
+        return -1;
+    }
+    region.data = data;
+    region.size = size;
+    return 0;
+}
+
+int hal_persist_flush(const HalPersistentRegion& region)
+{
+    if (region.data == nullptr || ::msync(region.data, region.size, MS_ASYNC) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+void hal_persist_unmap(HalPersistentRegion& region)
+{
+    if (region.data == nullptr) {
+        return;
+    }
+    (void)::msync(region.data, region.size, MS_SYNC);
+    (void)::munmap(region.data, region.size);
+    region = {};
+}
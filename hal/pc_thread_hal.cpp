@@ -0,0 +1,38 @@
+#include "hal/hal_thread.hpp"
+#include "hal/hal_logging.hpp"
+
+#include <cerrno>
+#include <pthread.h>
+#include <sched.h>
+
+int hal_thread_pin_to_cpu(uint32_t cpu)
+{
+    if (cpu >= CPU_SETSIZE) {
+        NET_LOG_ERROR(HAL, "CPU %u out of range", cpu);
+        return -1;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (rc != 0) {
+        NET_LOG_ERROR(HAL, "Pinning poll thread to CPU %u failed (errno %d)", cpu, rc);
+        return -1;
+    }
+    NET_LOG_INFO(HAL, "Poll thread pinned to CPU %u", cpu);
+    return 0;
+}
+
+int hal_thread_set_realtime(int priority)
+{
+    sched_param param{};
+    param.sched_priority = priority;
+    int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (rc != 0) {
+        NET_LOG_ERROR(HAL, "SCHED_FIFO priority %d refused (errno %d)", priority, rc);
+        return -1;
+    }
+    NET_LOG_INFO(HAL, "Poll thread running SCHED_FIFO priority %d", priority);
+    return 0;
+}
@@ -2,6 +2,15 @@
 #include <chrono>
 
 static auto start_time = std::chrono::steady_clock::now();
+
+// Injected clock (tests, simulations); nullptr = steady_clock.
+static const HalTimeSource* time_source = nullptr;
+
+void hal_timer_set_source(const HalTimeSource* source)
+{
+	time_source = (source != nullptr && source->now_us != nullptr) ? source : nullptr;
+}
+
 void hal_timer_init()
 {
 	start_time = std::chrono::steady_clock::now();
@@ -9,6 +18,24 @@ void hal_timer_init()
 
 uint32_t hal_timer_get_ms()
 {
+	if (time_source != nullptr) {
+		return static_cast<uint32_t>(time_source->now_us(time_source->context) / 1000u);
+	}
 	auto now = std::chrono::steady_clock::now();
 	return std::chrono::duration_cast<std::chrono::milliseconds>(now - start_time).count();
-}
\ No newline at end of file
+}
+
+uint64_t hal_timer_get_us()
+{
+	if (time_source != nullptr) {
+		return time_source->now_us(time_source->context);
+	}
+	auto now = std::chrono::steady_clock::now();
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(now - start_time).count());
+}
+
+uint64_t hal_timer_get_wall_ms()
+{
+	auto now = std::chrono::system_clock::now().time_since_epoch();
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(now).count());
+}
@@ -0,0 +1,166 @@
+#ifndef HAL_SIMULATED_HAL_H
+#define HAL_SIMULATED_HAL_H
+
+#include "hal/hal_network.hpp"
+#include "hal/virtual_clock.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+/**
+ * @brief Scripted, virtual-time HAL for simulations and timing tests.
+ * * Frames are injected to arrive at a given virtual time; receive() hands out
+ * * those that are due and wait() fast-forwards the VirtualClock to the next
+ * * arrival (or the timeout) instead of sleeping. Sent frames are counted and
+ * * passed to an optional hook, which can inject responses, so a whole
+ * * segment can be simulated. Fixed capacity, no heap.
+ * @tparam MaxPending    frames that can be scheduled at once
+ * @tparam MaxFrameBytes largest injectable frame
+ */
+template <size_t MaxPending = 64, size_t MaxFrameBytes = 128>
+class SimulatedHal {
+public:
+    using SendHook = void (*)(void* context, SimulatedHal& hal, std::span<const std::byte> frame);
+
+    explicit SimulatedHal(VirtualClock& clock) : m_clock(clock) {}
+
+    // Schedules 'frame' to arrive 'delay_ms' from now. Returns false if the
+    // frame is too large or MaxPending frames are already scheduled.
+    bool inject_after_ms(uint32_t delay_ms, std::span<const std::byte> frame)
+    {
+        return inject_at_us(m_clock.now_us() + static_cast<uint64_t>(delay_ms) * 1000u, frame);
+    }
+
+    bool inject_at_us(uint64_t at_us, std::span<const std::byte> frame)
+    {
+        if (frame.size() > MaxFrameBytes || frame.empty()) return false;
+        for (Pending& slot : m_pending) {
+            if (!slot.in_use) {
+                slot.in_use = true;
+                slot.at_us = at_us;
+                slot.sequence = m_next_sequence++;
+                slot.length = frame.size();
+                std::copy(frame.begin(), frame.end(), slot.bytes.begin());
+                ++m_pending_count;
+                return true;
+            }
+        }
+        ++m_inject_overflows;
+        return false;
+    }
+
+    // Called for every frame the stack sends (the frame is only valid during the call).
+    void on_send(SendHook hook, void* context)
+    {
+        m_send_hook = hook;
+        m_send_context = context;
+    }
+
+    // wait() never advances the clock past this point (see run_until_ms()).
+    void set_horizon_us(uint64_t horizon_us) { m_horizon_us = horizon_us; }
+
+    // Runs stack.run_once() until virtual time reaches 'end_ms'. The stack's
+    // BusyPollPolicy must not spin (idle_spin_us = 0): virtual time only moves in wait().
+    template <typename Stack>
+    void run_until_ms(Stack& stack, uint64_t end_ms)
+    {
+        const uint64_t end_us = end_ms * 1000u;
+        set_horizon_us(end_us);
+        while (m_clock.now_us() < end_us) {
+            stack.run_once();
+        }
+        set_horizon_us(UINT64_MAX);
+    }
+
+    // --- NetworkHal ---
+    int send(const void* data, size_t length)
+    {
+        ++m_tx_frames;
+        m_tx_bytes += length;
+        if (m_send_hook != nullptr) {
+            m_send_hook(m_send_context, *this, { static_cast<const std::byte*>(data), length });
+        }
+        return 0;
+    }
+
+    size_t receive(void* buffer, size_t max_length)
+    {
+        Pending* next = earliest();
+        if (next == nullptr || next->at_us > m_clock.now_us()) return 0;
+
+        next->in_use = false;
+        --m_pending_count;
+        if (next->length > max_length) return 0;
+        std::memcpy(buffer, next->bytes.data(), next->length);
+        ++m_rx_frames;
+        return next->length;
+    }
+
+    // Jumps to the next arrival if it comes within 'timeout_ms', else to the timeout.
+    bool wait(uint32_t timeout_ms)
+    {
+        const uint64_t now = m_clock.now_us();
+        uint64_t deadline = timeout_ms == UINT32_MAX ? UINT64_MAX : now + static_cast<uint64_t>(timeout_ms) * 1000u;
+        deadline = std::min(deadline, m_horizon_us);
+
+        const Pending* next = earliest();
+        if (next != nullptr && next->at_us <= deadline) {
+            m_clock.advance_to_us(next->at_us);
+            return true;
+        }
+        if (deadline != UINT64_MAX) {
+            m_clock.advance_to_us(deadline);
+        }
+        return false;
+    }
+
+    size_t pending() const { return m_pending_count; }
+    uint64_t tx_frames() const { return m_tx_frames; }
+    uint64_t tx_bytes() const { return m_tx_bytes; }
+    uint64_t rx_frames() const { return m_rx_frames; }
+    uint64_t inject_overflows() const { return m_inject_overflows; }
+    VirtualClock& clock() { return m_clock; }
+
+private:
+    struct Pending {
+        bool in_use = false;
+        uint64_t at_us = 0;
+        uint64_t sequence = 0;   // keeps same-time frames in injection order
+        size_t length = 0;
+        std::array<std::byte, MaxFrameBytes> bytes;
+    };
+
+    Pending* earliest()
+    {
+        Pending* best = nullptr;
+        for (Pending& slot : m_pending) {
+            if (slot.in_use && (best == nullptr || slot.at_us < best->at_us ||
+                                (slot.at_us == best->at_us && slot.sequence < best->sequence))) {
+                best = &slot;
+            }
+        }
+        return best;
+    }
+
+    VirtualClock& m_clock;
+    std::array<Pending, MaxPending> m_pending{};
+    size_t m_pending_count = 0;
+    uint64_t m_next_sequence = 0;
+    uint64_t m_horizon_us = UINT64_MAX;
+
+    SendHook m_send_hook = nullptr;
+    void* m_send_context = nullptr;
+
+    uint64_t m_tx_frames = 0;
+    uint64_t m_tx_bytes = 0;
+    uint64_t m_rx_frames = 0;
+    uint64_t m_inject_overflows = 0;
+};
+
+static_assert(NetworkHal<SimulatedHal<>>);
+
+#endif // HAL_SIMULATED_HAL_H
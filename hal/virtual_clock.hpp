@@ -0,0 +1,57 @@
+#ifndef HAL_VIRTUAL_CLOCK_H
+#define HAL_VIRTUAL_CLOCK_H
+
+#include "hal/hal_timer.hpp"
+
+#include <cstdint>
+
+/**
+ * @brief Manually advanced clock for tests and simulations.
+ * * While installed, hal_timer_get_ms()/hal_timer_get_us() return this clock's
+ * * time, so ARP aging, retransmits and coroutine timeouts run on virtual
+ * * time: hours of timers pass in as long as it takes to process them.
+ * * Not thread-safe; advance it from the poll thread.
+ */
+class VirtualClock {
+public:
+    explicit VirtualClock(uint64_t start_us = 0) : m_now_us(start_us) {}
+    ~VirtualClock() { uninstall(); }
+
+    VirtualClock(const VirtualClock&) = delete;
+    VirtualClock& operator=(const VirtualClock&) = delete;
+
+    void install()
+    {
+        hal_timer_set_source(&m_source);
+        m_installed = true;
+    }
+
+    void uninstall()
+    {
+        if (m_installed) {
+            hal_timer_set_source(nullptr);
+            m_installed = false;
+        }
+    }
+
+    uint64_t now_us() const { return m_now_us; }
+    uint32_t now_ms() const { return static_cast<uint32_t>(m_now_us / 1000u); }
+
+    void advance_us(uint64_t us) { m_now_us += us; }
+    void advance_ms(uint64_t ms) { m_now_us += ms * 1000u; }
+
+    // Jumps forward to 'us'; never moves backwards.
+    void advance_to_us(uint64_t us)
+    {
+        if (us > m_now_us) m_now_us = us;
+    }
+
+private:
+    static uint64_t read(void* context) { return static_cast<VirtualClock*>(context)->m_now_us; }
+
+    uint64_t m_now_us;
+    bool m_installed = false;
+    HalTimeSource m_source{ &VirtualClock::read, this };
+};
+
+#endif // HAL_VIRTUAL_CLOCK_H
@@ -1,14 +1,18 @@
 #include "arp_cache.hpp"
-#include "network_stack.hpp"
 #include "hal/hal_logging.hpp"
 #include "hal/hal_timer.hpp"
 #include "byte_order.hpp"
 #include "cstring"
+#include <bit>
 #include <span>
 namespace net
 {
 
     static constexpr uint32_t ARP_ENTRY_TIMEOUT_MS = 5 * 60 * 1000;
+    // Our own requests that were never answered free their slot after this.
+    static constexpr uint32_t ARP_PENDING_TIMEOUT_MS = 10 * 1000;
+    // A tentative entry whose probe got no answer is dropped after this.
+    static constexpr uint32_t ARP_PROBE_TIMEOUT_MS = 3 * 1000;
 
 
     std::optional<std::array<uint8_t, MAC_ADDRESS_LENGTH>>
@@ -18,14 +22,20 @@ namespace net
         NET_LOG_DEBUG(ARP, "Searching for IP: %d.%d.%d.%d",
                       ip_to_find[0], ip_to_find[1], ip_to_find[2], ip_to_find[3]);
 
-        for (const auto &entry : m_entries)
+        for (auto &entry : m_entries)
         {
-            if (entry.state == ArpEntryState::RESOLVED)
+            if (usable(entry))
             {
                 // Compare the entry's IP with the IP we are looking for.
                 if (std::memcmp(entry.ipv4_address.data(), ip_to_find.data(), IPV4_ADDRESS_LENGTH) == 0)
                 {
                     NET_LOG_DEBUG(ARP, "  MATCH FOUND!");
+                    // Lazy verification: the caller sends now, a probe follows.
+                    if (entry.state == ArpEntryState::TENTATIVE && !entry.probe_sent)
+                    {
+                        entry.probe_due = true;
+                        m_probes_wanted = true;
+                    }
                     return entry.mac_address; // Found it!
                 }
             }
@@ -35,9 +45,27 @@ namespace net
         return std::nullopt; // Did not find it.
     }
 
-    // Called when we receive an ARP packet. It will update the cache and,
-    // if it's a request for us, it will trigger the NetworkStack to send a reply.
-    void ArpCache::process_arp_packet(NetworkStack &stack, const ArpPacket &packet)
+    void ArpCache::set_policy(const ArpPolicy &policy)
+    {
+        m_policy = policy;
+        m_learn_bucket.configure(policy.learn_rate_per_sec, policy.learn_burst);
+        m_reply_bucket.configure(policy.reply_rate_per_sec, policy.reply_burst);
+        m_probe_bucket.configure(policy.probe_rate_per_sec, policy.probe_burst);
+        for (auto &limiter : m_source_limiters)
+        {
+            limiter.in_use = false;
+        }
+    }
+
+    bool ArpCache::process_arp_packet(const ArpPacket &packet,
+                                      const std::array<uint8_t, IPV4_ADDRESS_LENGTH> &our_ip)
+    {
+        return process_arp_packet(packet, std::memcmp(packet.target_ip, our_ip.data(), IPV4_ADDRESS_LENGTH) == 0);
+    }
+
+    // Called when we receive an ARP packet. It will update the cache and
+    // report whether it's a request for us, so the caller can send the reply.
+    bool ArpCache::process_arp_packet(const ArpPacket &packet, bool for_us, bool may_learn)
     {
         /*View the data for easier handling and debugging*/
         /*TODO: find any other implementation to improve it and use less memory*/
@@ -46,21 +74,106 @@ namespace net
         std::memcpy(sender_ip.data(), packet.sender_ip, IPV4_ADDRESS_LENGTH);
         std::memcpy(sender_mac.data(), packet.sender_mac, MAC_ADDRESS_LENGTH);
 
-        // Add or update the sender's information in the cache now.
-        add_or_update_entry(sender_ip, sender_mac, ArpEntryState::RESOLVED);
+        ++m_stats.packets;
+        const uint32_t now_ms = hal_timer_get_ms();
         uint16_t opcode = net_ntohs16(packet.opcode);
         NET_LOG_DEBUG(ARP, "OP-CODE RECV: %d", opcode);
+
+        // Refreshing an entry we already hold is cheap and cannot evict anyone,
+        // so it is allowed under every policy. Pending entries are our own
+        // outstanding requests being answered.
+        bool source_charged = false;
+        ArpEntry *existing = find_entry(sender_ip);
+        if (existing != nullptr)
+        {
+            if (usable(*existing) && existing->mac_address != sender_mac)
+            {
+                ++m_generation;
+            }
+            if (existing->state == ArpEntryState::TENTATIVE)
+            {
+                ++m_stats.tentative_confirmed;
+                existing->probe_due = false;
+                existing->probe_sent = false;
+            }
+            existing->mac_address = sender_mac;
+            existing->state = ArpEntryState::RESOLVED;
+            existing->timestamp_ms = now_ms;
+            ++m_stats.entries_updated;
+            NET_LOG_DEBUG(ARP, "Updated ARP cache entry.");
+        }
+        else if (!may_learn || m_policy.learning == ArpLearningPolicy::UPDATE_ONLY ||
+                 (m_policy.learning == ArpLearningPolicy::ADDRESSED_TO_US && !for_us))
+        {
+            ++m_stats.not_learned_policy;
+        }
+        else
+        {
+            // Only packets that cost us something are charged to the sender.
+            source_charged = true;
+            if (!source_allowed(sender_ip, now_ms))
+            {
+                ++m_stats.source_rate_limited;
+                return false;
+            }
+
+            if (!m_learn_bucket.try_consume(now_ms))
+            {
+                ++m_stats.learn_rate_limited;
+            }
+            else
+            {
+                // Add the sender's information to the cache now.
+                if (add_or_update_entry(sender_ip, sender_mac, ArpEntryState::RESOLVED))
+                {
+                    ++m_stats.entries_learned;
+                }
+            }
+        }
+
         // Now, check if this packet is a request specifically for us.
-        if (opcode == ARP_OPCODE_REQUEST)
+        if (opcode == ARP_OPCODE_REQUEST && for_us)
         {
-            // Is the target IP in the packet the same as our IP?
-            if (std::memcmp(packet.target_ip, stack.get_config()->ipv4_address.data(), IPV4_ADDRESS_LENGTH) == 0)
+            // A sender we just charged for learning is not charged twice.
+            if (!source_charged && !source_allowed(sender_ip, now_ms))
             {
-                NET_LOG_DEBUG(ARP, "Received an ARP request for our IP. Sending reply...");
-                // The stack is responsible for constructing and sending the actual packet.
-                stack.send_arp_reply(sender_ip, sender_mac);
+                ++m_stats.source_rate_limited;
+                return false;
             }
+            if (!m_reply_bucket.try_consume(now_ms))
+            {
+                ++m_stats.replies_rate_limited;
+                return false;
+            }
+            NET_LOG_DEBUG(ARP, "Received an ARP request for our IP. Sending reply...");
+            // The stack is responsible for constructing and sending the actual packet.
+            return true;
+        }
+        return false;
+    }
+
+    bool ArpCache::source_allowed(const std::array<uint8_t, IPV4_ADDRESS_LENGTH> &sender_ip, uint32_t now_ms)
+    {
+        if (m_policy.per_source_rate_per_sec == 0)
+        {
+            return true;
+        }
+
+        uint32_t key = 0;
+        std::memcpy(&key, sender_ip.data(), sizeof(key));
+        // Multiplicative hash: the top log2(SOURCE_LIMITER_SLOTS) bits pick the slot.
+        constexpr int slot_bits = std::countr_zero(SOURCE_LIMITER_SLOTS);
+        const size_t slot = slot_bits == 0 ? 0 : (key * 0x9E3779B1u) >> (32 - slot_bits);
+
+        SourceLimiter &limiter = m_source_limiters[slot];
+        if (!limiter.in_use)
+        {
+            // First sender in this slot; later ones that collide with it are
+            // charged to the same bucket rather than getting a fresh one.
+            limiter.in_use = true;
+            limiter.bucket.configure(m_policy.per_source_rate_per_sec, m_policy.per_source_burst);
         }
+        return limiter.bucket.try_consume(now_ms);
     }
 
     // Periodically called to clear out old entries.
@@ -76,13 +189,33 @@ namespace net
                     // This entry is too old. Invalidate it.
                     NET_LOG_DEBUG(ARP, "ARP entry expired. Clearing.");
                     entry.state = ArpEntryState::EMPTY;
+                    ++m_generation;
+                }
+            }
+            else if (entry.state == ArpEntryState::TENTATIVE)
+            {
+                const uint32_t limit_ms = entry.probe_sent ? ARP_PROBE_TIMEOUT_MS : ARP_ENTRY_TIMEOUT_MS;
+                if (current_time_ms - entry.timestamp_ms > limit_ms)
+                {
+                    NET_LOG_DEBUG(ARP, "Tentative ARP entry not confirmed. Clearing.");
+                    entry.state = ArpEntryState::EMPTY;
+                    ++m_stats.tentative_expired;
+                    ++m_generation;
+                }
+            }
+            else if (entry.state == ArpEntryState::PENDING)
+            {
+                if (current_time_ms - entry.timestamp_ms > ARP_PENDING_TIMEOUT_MS)
+                {
+                    NET_LOG_DEBUG(ARP, "Pending ARP entry unanswered. Clearing.");
+                    entry.state = ArpEntryState::EMPTY;
                 }
             }
         }
     }
 
     // Find an empty slot or the oldest entry to create a pending entry.
-    void ArpCache::add_or_update_entry(const std::array<uint8_t, IPV4_ADDRESS_LENGTH> &ip_address,
+    bool ArpCache::add_or_update_entry(const std::array<uint8_t, IPV4_ADDRESS_LENGTH> &ip_address,
                                        const std::array<uint8_t, MAC_ADDRESS_LENGTH> &mac_address,
                                        ArpEntryState new_state)
     {
@@ -93,11 +226,17 @@ namespace net
                 std::memcmp(entry.ipv4_address.data(), ip_address.data(), IPV4_ADDRESS_LENGTH) == 0)
             {
                 // Found an existing entry. Update it.
+                if (usable(entry) && (new_state != ArpEntryState::RESOLVED || entry.mac_address != mac_address))
+                {
+                    ++m_generation;
+                }
                 entry.mac_address = mac_address;
                 entry.state = new_state;
+                entry.probe_due = false;
+                entry.probe_sent = false;
                 entry.timestamp_ms = hal_timer_get_ms();
                 NET_LOG_DEBUG(ARP, "Updated ARP cache entry.");
-                return;
+                return true;
             }
         }
 
@@ -109,15 +248,131 @@ namespace net
                 entry.ipv4_address = ip_address;
                 entry.mac_address = mac_address;
                 entry.state = new_state;
+                entry.probe_due = false;
+                entry.probe_sent = false;
                 entry.timestamp_ms = hal_timer_get_ms();
                 NET_LOG_DEBUG(ARP, "Added new ARP cache entry.");
-                return;
+                return true;
+            }
+        }
+
+        // If we are still here, the cache is full. A resolved entry replaces
+        // the oldest resolved (or tentative) one, so garbage that got in
+        // cannot pin the cache forever, or else the oldest pending one. A
+        // pending entry (our own outstanding request) only ever replaces an
+        // older pending one: resolves of dead hosts must not flush the
+        // neighbours we talk to, the gateway first of all.
+        const uint32_t now_ms = hal_timer_get_ms();
+        auto oldest_of = [&](auto &&eligible) {
+            ArpEntry *oldest = nullptr;
+            for (auto &entry : m_entries)
+            {
+                if (eligible(entry) &&
+                    (oldest == nullptr || now_ms - entry.timestamp_ms > now_ms - oldest->timestamp_ms))
+                {
+                    oldest = &entry;
+                }
+            }
+            return oldest;
+        };
+        auto is_pending = [](const ArpEntry &entry) { return entry.state == ArpEntryState::PENDING; };
+        ArpEntry *oldest = new_state == ArpEntryState::PENDING ? nullptr : oldest_of(usable);
+        if (oldest == nullptr)
+        {
+            oldest = oldest_of(is_pending);
+        }
+        if (oldest == nullptr)
+        {
+            NET_LOG_DEBUG(ARP, "ARP Cache is full! Could not add new entry.");
+            return false;
+        }
+
+        if (usable(*oldest))
+        {
+            ++m_generation;
+        }
+        oldest->ipv4_address = ip_address;
+        oldest->mac_address = mac_address;
+        oldest->state = new_state;
+        oldest->probe_due = false;
+        oldest->probe_sent = false;
+        oldest->timestamp_ms = now_ms;
+        NET_LOG_DEBUG(ARP, "ARP Cache full; replaced the oldest entry.");
+        return true;
+    }
+
+    ArpEntry *ArpCache::find_entry(const std::array<uint8_t, IPV4_ADDRESS_LENGTH> &ip_address)
+    {
+        for (auto &entry : m_entries)
+        {
+            if (entry.state != ArpEntryState::EMPTY &&
+                std::memcmp(entry.ipv4_address.data(), ip_address.data(), IPV4_ADDRESS_LENGTH) == 0)
+            {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    void ArpCache::mark_pending(const std::array<uint8_t, IPV4_ADDRESS_LENGTH> &ip_address)
+    {
+        if (find_entry(ip_address) != nullptr)
+        {
+            return;
+        }
+        (void)add_or_update_entry(ip_address, {}, ArpEntryState::PENDING);
+    }
+
+    bool ArpCache::add_tentative(const std::array<uint8_t, IPV4_ADDRESS_LENGTH> &ip_address,
+                                 const std::array<uint8_t, MAC_ADDRESS_LENGTH> &mac_address, uint32_t age_ms, bool probe)
+    {
+        if (age_ms >= ARP_ENTRY_TIMEOUT_MS || find_entry(ip_address) != nullptr)
+        {
+            return false;
+        }
+        for (auto &entry : m_entries)
+        {
+            if (entry.state == ArpEntryState::EMPTY)
+            {
+                entry.ipv4_address = ip_address;
+                entry.mac_address = mac_address;
+                entry.state = ArpEntryState::TENTATIVE;
+                entry.probe_due = probe;
+                entry.probe_sent = false;
+                // Aged as if it had stayed in the cache.
+                entry.timestamp_ms = hal_timer_get_ms() - age_ms;
+                m_probes_wanted = m_probes_wanted || probe;
+                ++m_stats.tentative_loaded;
+                ++m_generation;
+                return true;
             }
         }
+        return false;
+    }
 
-        // If we are still here, the cache is full. We would implement a
-        // strategy to replace the oldest entry here, but for now, we'll just log it.
-        NET_LOG_DEBUG(ARP, "ARP Cache is full! Could not add new entry.");
+    std::optional<ArpEntry> ArpCache::next_probe(uint32_t now_ms)
+    {
+        if (!m_probes_wanted)
+        {
+            return std::nullopt;
+        }
+        for (auto &entry : m_entries)
+        {
+            if (entry.state == ArpEntryState::TENTATIVE && entry.probe_due)
+            {
+                if (!m_probe_bucket.try_consume(now_ms))
+                {
+                    return std::nullopt;
+                }
+                entry.probe_due = false;
+                entry.probe_sent = true;
+                entry.timestamp_ms = now_ms;
+                ++m_stats.probes_sent;
+                return entry;
+            }
+        }
+        m_probes_wanted = false;
+        return std::nullopt;
     }
 
-}
\ No newline at end of file
+}
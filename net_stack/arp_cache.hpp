@@ -5,52 +5,167 @@
 #include "array"
 #include "cstdint"
 #include "optional"
+#include "span"
 
 #include "protocols/arp.hpp"
+#include "token_bucket.hpp"
+#include "memory_config.hpp"
 
 
-//forward declaration to avoid circular dependencies
-namespace net {
-	class NetworkStack;
-}
-
 namespace net {
 
 	enum class ArpEntryState {
 		EMPTY,
 		PENDING,
-		RESOLVED
+		RESOLVED,
+		TENTATIVE   // restored from a snapshot: used, but not confirmed since
+		            // start; a unicast probe must be answered to keep it
 	};
 
 	struct ArpEntry {
 		ArpEntryState state = ArpEntryState::EMPTY;
 		std::array<uint8_t, IPV4_ADDRESS_LENGTH> ipv4_address;
 		std::array<uint8_t, MAC_ADDRESS_LENGTH> mac_address;
+		bool probe_due = false;    // TENTATIVE: probe wanted
+		bool probe_sent = false;   // TENTATIVE: probed at timestamp_ms
 		uint32_t timestamp_ms = 0;
 	};
 
+	// Which ARP packets may put addresses into the cache.
+	enum class ArpLearningPolicy {
+		LEARN_ALL,        // every sender seen (original behaviour; easy to flood)
+		ADDRESSED_TO_US,  // RFC 826 merge: refresh known senders from any packet,
+		                  // create new entries only when the target IP is ours
+		UPDATE_ONLY       // never create entries from the wire; only complete our
+		                  // own pending requests and refresh existing entries
+	};
+
+	// Flood protection knobs. A rate of 0 disables that limit.
+	struct ArpPolicy {
+		ArpLearningPolicy learning = ArpLearningPolicy::ADDRESSED_TO_US;
+
+		// Global cap on new cache entries.
+		uint32_t learn_rate_per_sec = 20;
+		uint32_t learn_burst = 16;
+
+		// Global cap on ARP replies we transmit.
+		uint32_t reply_rate_per_sec = 100;
+		uint32_t reply_burst = 20;
+
+		// Cap per sender IP on packets we act on (learning or replying), so a
+		// single scanner cannot consume the global budgets.
+		uint32_t per_source_rate_per_sec = 5;
+		uint32_t per_source_burst = 5;
+
+		// Cap on unicast probes of tentative (warm-started) entries, so a
+		// restart does not hit the whole segment at once.
+		uint32_t probe_rate_per_sec = 20;
+		uint32_t probe_burst = 4;
+	};
+
+	struct ArpStats {
+		uint32_t packets = 0;
+		uint32_t entries_learned = 0;
+		uint32_t entries_updated = 0;
+		uint32_t not_learned_policy = 0;     // rejected by the learning policy
+		uint32_t learn_rate_limited = 0;     // global learning bucket empty
+		uint32_t replies_rate_limited = 0;   // global reply bucket empty
+		uint32_t source_rate_limited = 0;    // sender over its own budget
+		uint32_t tentative_loaded = 0;       // entries restored from a snapshot
+		uint32_t tentative_confirmed = 0;    // ... then heard from
+		uint32_t tentative_expired = 0;      // ... dropped: probe unanswered or too old
+		uint32_t probes_sent = 0;
+	};
+
     class ArpCache {
     public:
+        ArpCache() { set_policy(ArpPolicy{}); }
+        explicit ArpCache(const ArpPolicy& policy) { set_policy(policy); }
+
+        // Replaces the policy and resets all rate limiters.
+        void set_policy(const ArpPolicy& policy);
+        const ArpPolicy& get_policy() const { return m_policy; }
+        const ArpStats& get_stats() const { return m_stats; }
+
+        // Bumped whenever a resolved entry expires, is evicted or changes MAC,
+        // so callers memoising lookups (NextHopCache) can tell they are stale.
+        uint32_t generation() const { return m_generation; }
+
         // Tries to find the MAC address for a given IP.
-        // Returns a std::optional containing the MAC address if found and resolved.
+        // Returns a std::optional containing the MAC address if found and resolved
+        // (or tentative; the first lookup of a tentative entry asks for a probe).
         std::optional<std::array<uint8_t, MAC_ADDRESS_LENGTH>> lookup(const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& ip_address);
 
-        // Called when we receive an ARP packet. It will update the cache and,
-        // if it's a request for us, it will trigger the NetworkStack to send a reply.
-        void process_arp_packet(NetworkStack& stack, const ArpPacket& packet);
+        // Called when we receive an ARP packet. It will update the cache as the
+        // policy allows and return true if it's a request for 'our_ip' that
+        // needs a reply (within the reply rate limits).
+        // Sending the reply is the caller's job, so the cache has no stack dependency.
+        [[nodiscard]] bool process_arp_packet(const ArpPacket& packet,
+            const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& our_ip);
+
+        // Same, with the caller having decided whether the target address is
+        // ours (e.g. one of several owned addresses). With 'may_learn' false
+        // the sender only refreshes an entry it already has (e.g. a reply to
+        // an ARP sweep, which must not push real neighbours out).
+        [[nodiscard]] bool process_arp_packet(const ArpPacket& packet, bool for_us, bool may_learn = true);
 
         // Periodically called to clear out old entries.
         void age_entries(uint32_t current_time_ms);
 
         // Find an empty slot or the oldest entry to create a pending entry.
-        void add_or_update_entry(const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& ip_address,
+        // Returns false if the cache is full and nothing was stored.
+        bool add_or_update_entry(const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& ip_address,
             const std::array<uint8_t, MAC_ADDRESS_LENGTH>& mac_address,
             ArpEntryState new_state);
 
+        // Records that we asked for 'ip_address', so its reply is accepted even
+        // under UPDATE_ONLY. Does nothing if the address is already cached.
+        void mark_pending(const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& ip_address);
+
+        // --- Warm start (see arp_snapshot.hpp) ---
+
+        // Restores an entry last confirmed 'age_ms' ago as TENTATIVE, probed
+        // at once if 'probe' or else when first looked up. False if it is too
+        // old, already cached, or no slot is free (nothing is evicted).
+        bool add_tentative(const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& ip_address,
+            const std::array<uint8_t, MAC_ADDRESS_LENGTH>& mac_address, uint32_t age_ms, bool probe);
+
+        // The next tentative entry to probe with a unicast request, within the
+        // probe rate limit; the caller sends the request. Unanswered probes
+        // expire the entry in age_entries().
+        std::optional<ArpEntry> next_probe(uint32_t now_ms);
+        bool probes_wanted() const { return m_probes_wanted; }
+
+        std::span<const ArpEntry> entries() const { return m_entries; }
+
     private:
+        // Per-sender budget, direct-mapped by a hash of the sender IP. Senders
+        // whose IPs collide share it, so alternating them earns no extra budget.
+        struct SourceLimiter {
+            bool in_use = false;
+            TokenBucket bucket;
+        };
+
+        ArpEntry* find_entry(const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& ip_address);
+        static bool usable(const ArpEntry& entry) {
+            return entry.state == ArpEntryState::RESOLVED || entry.state == ArpEntryState::TENTATIVE;
+        }
+        bool source_allowed(const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& sender_ip, uint32_t now_ms);
+
         // A fixed-size array for our cache. No dynamic allocation.
-        static constexpr size_t CACHE_SIZE = 16;
+        static constexpr size_t CACHE_SIZE = k_memory_config.arp_cache_entries;
         std::array<ArpEntry, CACHE_SIZE> m_entries;
+
+        static constexpr size_t SOURCE_LIMITER_SLOTS = k_memory_config.arp_source_limiter_slots;
+        std::array<SourceLimiter, SOURCE_LIMITER_SLOTS> m_source_limiters;
+
+        ArpPolicy m_policy;
+        TokenBucket m_learn_bucket;
+        TokenBucket m_reply_bucket;
+        TokenBucket m_probe_bucket;
+        bool m_probes_wanted = false;   // a TENTATIVE entry may have probe_due set
+        ArpStats m_stats;
+        uint32_t m_generation = 0;
     };
 
 
@@ -0,0 +1,123 @@
+#include "arp_snapshot.hpp"
+#include "hal/hal_logging.hpp"
+#include "cstring"
+
+namespace net
+{
+
+    namespace
+    {
+        uint32_t fnv1a(std::span<const std::byte> data, uint32_t hash = 2166136261u)
+        {
+            for (std::byte byte : data)
+            {
+                hash = (hash ^ static_cast<uint32_t>(byte)) * 16777619u;
+            }
+            return hash;
+        }
+
+        // Checksum of a region whose header has been copied into 'header'.
+        uint32_t snapshot_checksum(ArpSnapshotHeader header, std::span<const std::byte> records)
+        {
+            header.checksum = 0;
+            return fnv1a(records, fnv1a(std::as_bytes(std::span(&header, 1))));
+        }
+    }
+
+    size_t save_arp_snapshot(const ArpCache &cache, std::span<std::byte> region, uint64_t wall_ms, uint32_t now_ms)
+    {
+        if (region.size() < sizeof(ArpSnapshotHeader))
+        {
+            return 0;
+        }
+        const size_t capacity = (region.size() - sizeof(ArpSnapshotHeader)) / sizeof(ArpSnapshotEntry);
+        std::byte *records = region.data() + sizeof(ArpSnapshotHeader);
+
+        size_t count = 0;
+        for (const ArpEntry &entry : cache.entries())
+        {
+            if (count == capacity)
+            {
+                break;
+            }
+            if (entry.state != ArpEntryState::RESOLVED && entry.state != ArpEntryState::TENTATIVE)
+            {
+                continue;
+            }
+            // A probed entry's timestamp is the probe time, not when it was
+            // last confirmed; saved, it would come back as fresh.
+            if (entry.state == ArpEntryState::TENTATIVE && entry.probe_sent)
+            {
+                continue;
+            }
+            ArpSnapshotEntry record;
+            record.ipv4_address = entry.ipv4_address;
+            record.mac_address = entry.mac_address;
+            record.age_ms = now_ms - entry.timestamp_ms;
+            std::memcpy(records + count * sizeof(record), &record, sizeof(record));
+            ++count;
+        }
+
+        ArpSnapshotHeader header;
+        header.entry_bytes = sizeof(ArpSnapshotEntry);
+        header.count = static_cast<uint32_t>(count);
+        header.saved_wall_ms = wall_ms;
+        header.checksum = snapshot_checksum(header, std::span<const std::byte>(records, count * sizeof(ArpSnapshotEntry)));
+        std::memcpy(region.data(), &header, sizeof(header));
+        return count;
+    }
+
+    ArpSnapshotLoad load_arp_snapshot(ArpCache &cache, std::span<const std::byte> region, uint64_t wall_ms,
+                                      bool probe_all)
+    {
+        ArpSnapshotLoad result;
+        ArpSnapshotHeader header;
+        if (region.size() < sizeof(header))
+        {
+            return result;
+        }
+        std::memcpy(&header, region.data(), sizeof(header));
+        if (header.magic != ARP_SNAPSHOT_MAGIC)
+        {
+            return result;
+        }
+        if (header.version != ARP_SNAPSHOT_VERSION || header.entry_bytes != sizeof(ArpSnapshotEntry))
+        {
+            result.status = ArpSnapshotLoad::Status::WRONG_VERSION;
+            return result;
+        }
+        const std::span<const std::byte> records = region.subspan(sizeof(header));
+        if (header.count > records.size() / sizeof(ArpSnapshotEntry) ||
+            header.checksum != snapshot_checksum(header, records.first(header.count * sizeof(ArpSnapshotEntry))))
+        {
+            result.status = ArpSnapshotLoad::Status::CORRUPT;
+            return result;
+        }
+
+        result.status = ArpSnapshotLoad::Status::LOADED;
+        // Unknown or backwards clocks: take the ages as saved.
+        if (wall_ms != 0 && header.saved_wall_ms != 0 && wall_ms > header.saved_wall_ms)
+        {
+            result.snapshot_age_ms = wall_ms - header.saved_wall_ms;
+        }
+        for (uint32_t i = 0; i < header.count; ++i)
+        {
+            ArpSnapshotEntry record;
+            std::memcpy(&record, records.data() + i * sizeof(record), sizeof(record));
+            const uint64_t age_ms = record.age_ms + result.snapshot_age_ms;
+            if (age_ms < UINT32_MAX &&
+                cache.add_tentative(record.ipv4_address, record.mac_address, static_cast<uint32_t>(age_ms), probe_all))
+            {
+                ++result.loaded;
+            }
+            else
+            {
+                ++result.skipped;
+            }
+        }
+        NET_LOG_INFO(ARP, "ARP snapshot: %u entries restored, %u skipped, saved %llu ms ago", result.loaded,
+                     result.skipped, static_cast<unsigned long long>(result.snapshot_age_ms));
+        return result;
+    }
+
+}
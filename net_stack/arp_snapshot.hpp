@@ -0,0 +1,73 @@
+#ifndef NET_STACK_ARP_SNAPSHOT_H
+#define NET_STACK_ARP_SNAPSHOT_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "arp_cache.hpp"
+#include "protocols/arp.hpp"
+
+namespace net {
+
+	// Image of the ArpCache kept in persistent memory (hal_persist_map()) for
+	// warm starts: a header and one fixed-size record per entry, in native
+	// byte order since the device that wrote it reads it back (another byte
+	// order fails the magic check). Entries carry their age at save time and
+	// the header the wall-clock time of the save, so ages carry over a
+	// restart. A snapshot of another version, or one torn by a crash in the
+	// middle of a save (checksum), is ignored: a cold start.
+	inline constexpr uint32_t ARP_SNAPSHOT_MAGIC = 0x4E415250;   // "NARP"
+	inline constexpr uint16_t ARP_SNAPSHOT_VERSION = 1;
+
+	struct ArpSnapshotHeader {
+		uint32_t magic = ARP_SNAPSHOT_MAGIC;
+		uint16_t version = ARP_SNAPSHOT_VERSION;
+		uint16_t entry_bytes = 0;     // sizeof(ArpSnapshotEntry)
+		uint32_t count = 0;           // records after the header
+		uint32_t checksum = 0;        // FNV-1a of the header (this field 0) and the records
+		uint64_t saved_wall_ms = 0;   // Unix time of the save, 0 if unknown
+	};
+	static_assert(sizeof(ArpSnapshotHeader) == 24);
+
+	struct ArpSnapshotEntry {
+		std::array<uint8_t, IPV4_ADDRESS_LENGTH> ipv4_address{};
+		std::array<uint8_t, MAC_ADDRESS_LENGTH> mac_address{};
+		uint16_t reserved = 0;
+		uint32_t age_ms = 0;          // since last confirmed, at save time
+	};
+	static_assert(sizeof(ArpSnapshotEntry) == 16);
+
+	// Bytes a region needs for 'entries' records.
+	constexpr size_t arp_snapshot_bytes(size_t entries) {
+		return sizeof(ArpSnapshotHeader) + entries * sizeof(ArpSnapshotEntry);
+	}
+
+	struct ArpSnapshotLoad {
+		enum class Status {
+			LOADED,      // valid snapshot (possibly with nothing usable in it)
+			NONE,        // no snapshot in the region (blank, or not ours)
+			WRONG_VERSION,
+			CORRUPT      // bad size or checksum, e.g. torn by a crash
+		};
+		Status status = Status::NONE;
+		uint32_t loaded = 0;          // entries now TENTATIVE in the cache
+		uint32_t skipped = 0;         // too old, already cached, or no room
+		uint64_t snapshot_age_ms = 0; // since the save, 0 if unknown
+	};
+
+	// Writes the resolved and tentative entries of 'cache' into 'region';
+	// entries that do not fit, and tentative ones with a probe unanswered so
+	// far, are left out. Returns the records written (0 also if the region
+	// cannot hold the header).
+	size_t save_arp_snapshot(const ArpCache& cache, std::span<std::byte> region, uint64_t wall_ms, uint32_t now_ms);
+
+	// Restores the entries of a valid snapshot as TENTATIVE (ArpCache::
+	// add_tentative()), probed at once if 'probe_all' or else on first use.
+	ArpSnapshotLoad load_arp_snapshot(ArpCache& cache, std::span<const std::byte> region, uint64_t wall_ms,
+		bool probe_all);
+
+}
+
+#endif
@@ -0,0 +1,263 @@
+#ifndef NET_STACK_ARP_SWEEP_H
+#define NET_STACK_ARP_SWEEP_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "protocols/arp.hpp"
+#include "token_bucket.hpp"
+
+namespace net {
+
+	// Pacing of an ARP sweep. A rate of 0 sends as fast as the window allows.
+	struct ArpSweepOptions {
+		uint32_t rate_per_sec = 1000;          // requests, first tries and retries
+		uint32_t burst = 32;
+		uint32_t max_in_flight = UINT32_MAX;   // capped at MemoryConfig::arp_sweep_in_flight
+		uint32_t timeout_ms = 200;             // per request
+		uint8_t retries = 1;                   // requests after the first before giving up
+	};
+
+	struct ArpSweepStats {
+		uint32_t requests = 0;     // first requests sent
+		uint32_t retries = 0;      // requests repeated after a timeout
+		uint32_t answered = 0;
+		uint32_t unanswered = 0;   // given up after the last retry
+		uint32_t late = 0;         // answers from swept addresses no longer outstanding
+	};
+
+	// One address of a sweep, reported once: with its MAC when it answered,
+	// std::nullopt when it did not.
+	struct ArpSweepResult {
+		std::array<uint8_t, IPV4_ADDRESS_LENGTH> ip{};
+		std::optional<std::array<uint8_t, MAC_ADDRESS_LENGTH>> mac;
+		uint32_t rtt_ms = 0;   // last request -> answer
+	};
+
+	using ArpSweepReceiver = void (*)(void* context, const ArpSweepResult& result);
+
+	// Bookkeeping of one ARP sweep over a contiguous address range; the stack
+	// sends and receives (see BasicNetworkStack::start_arp_sweep()). Requests
+	// go out in address order, paced by a TokenBucket, with at most
+	// max_in_flight outstanding. Outstanding requests sit in a FIFO ring in
+	// send order, so the oldest one is the next to time out; a retry moves it
+	// to the back. Answers find their ring slot through an open-addressing
+	// hash of the address (linear probing, at most half full), so matching
+	// costs the same at any window size. Fixed capacity, no heap.
+	template <size_t MaxInFlight>
+	class ArpSweep {
+		static_assert(MaxInFlight == 0 || std::has_single_bit(MaxInFlight),
+			"ArpSweep in-flight capacity must be 0 or a power of two");
+		static_assert(MaxInFlight < 0x8000, "ring slots are indexed with 16 bits");
+
+	public:
+		// What the stack has to do next.
+		struct Step {
+			enum class Kind : uint8_t {
+				NONE,      // nothing due now
+				SEND,      // send a request for 'address'
+				GIVE_UP    // report 'address' as unanswered
+			};
+			Kind kind = Kind::NONE;
+			uint32_t address = 0;
+		};
+
+		static constexpr size_t capacity() { return MaxInFlight; }
+
+		// False if a sweep is running, there is no capacity, the range is
+		// empty, starts at 0.0.0.0 or wraps past 255.255.255.255.
+		bool start(uint32_t first, uint32_t count, const ArpSweepOptions& options) {
+			if (MaxInFlight == 0 || active() || count == 0 || first == 0 || count - 1 > UINT32_MAX - first) {
+				return false;
+			}
+			m_first = first;
+			m_count = count;
+			m_next = 0;
+			m_remaining = count;
+			m_window = static_cast<uint32_t>(std::min<size_t>(std::max<uint32_t>(options.max_in_flight, 1), MaxInFlight));
+			m_timeout_ms = options.timeout_ms;
+			m_retries = std::min<uint8_t>(options.retries, 254);
+			m_bucket.configure(options.rate_per_sec, std::max<uint32_t>(options.burst, 1));
+			m_head = m_tail = 0;
+			m_index.fill(NO_SLOT);
+			m_stats = {};
+			return true;
+		}
+
+		// Drops every outstanding request; nothing more is reported.
+		void cancel() {
+			m_remaining = 0;
+			m_head = m_tail = 0;
+			m_index.fill(NO_SLOT);
+		}
+
+		bool active() const { return m_remaining != 0; }
+		uint32_t remaining() const { return m_remaining; }   // addresses not reported yet
+		size_t in_flight() const { return m_tail - m_head; } // including answered slots not yet reclaimed
+		const ArpSweepStats& get_stats() const { return m_stats; }
+
+		// Called repeatedly until it returns NONE.
+		Step step(uint32_t now_ms) {
+			if (!active()) {
+				return {};
+			}
+			reclaim();
+			if (m_head != m_tail) {
+				Slot& oldest = m_ring[m_head & MASK];
+				if (time_reached(now_ms, oldest.sent_ms + m_timeout_ms)) {
+					const uint32_t address = oldest.address;
+					if (oldest.tries > m_retries) {
+						erase(address);
+						oldest.address = 0;
+						++m_head;
+						--m_remaining;
+						++m_stats.unanswered;
+						return { Step::Kind::GIVE_UP, address };
+					}
+					if (!m_bucket.try_consume(now_ms)) {
+						return {};
+					}
+					// To the back of the ring, the hash following it.
+					const Slot retry{ address, now_ms, static_cast<uint8_t>(oldest.tries + 1) };
+					m_index[find_index(address)] = static_cast<uint16_t>(m_tail & MASK);
+					oldest.address = 0;
+					++m_head;
+					m_ring[m_tail++ & MASK] = retry;
+					++m_stats.retries;
+					return { Step::Kind::SEND, address };
+				}
+			}
+			if (m_next < m_count && m_tail - m_head < m_window && m_bucket.try_consume(now_ms)) {
+				const uint32_t address = m_first + m_next++;
+				insert(address, static_cast<uint16_t>(m_tail & MASK));
+				m_ring[m_tail++ & MASK] = { address, now_ms, 1 };
+				++m_stats.requests;
+				return { Step::Kind::SEND, address };
+			}
+			return {};
+		}
+
+		// An ARP packet came from 'address'. Returns the round trip in ms if
+		// it was outstanding (report it as answered), else std::nullopt.
+		std::optional<uint32_t> complete(uint32_t address, uint32_t now_ms) {
+			if (address - m_first >= m_next || !active()) {
+				return std::nullopt;
+			}
+			const size_t index = find_index(address);
+			if (m_index[index] == NO_SLOT) {
+				++m_stats.late;
+				return std::nullopt;
+			}
+			Slot& slot = m_ring[m_index[index]];
+			const uint32_t rtt_ms = now_ms - slot.sent_ms;
+			erase(address);
+			slot.address = 0;
+			--m_remaining;
+			++m_stats.answered;
+			return rtt_ms;
+		}
+
+		// True if a request for 'address' is waiting for its answer.
+		bool outstanding(uint32_t address) const {
+			return active() && address - m_first < m_next && m_index[find_index(address)] != NO_SLOT;
+		}
+
+		// Milliseconds until step() has something to do.
+		uint32_t ms_until_next(uint32_t now_ms) const {
+			if (!active()) {
+				return UINT32_MAX;
+			}
+			uint32_t next = UINT32_MAX;
+			size_t head = m_head;
+			while (head != m_tail && m_ring[head & MASK].address == 0) {
+				++head;
+			}
+			if (head != m_tail) {
+				const uint32_t deadline_ms = m_ring[head & MASK].sent_ms + m_timeout_ms;
+				next = time_reached(now_ms, deadline_ms) ? 0 : deadline_ms - now_ms;
+			}
+			if (m_next < m_count && m_tail - head < m_window) {
+				// A token is at most a tick away at the rates that matter.
+				next = std::min(next, m_bucket.unlimited() ? 0u : 1u);
+			}
+			return next;
+		}
+
+	private:
+		static constexpr uint16_t NO_SLOT = 0xFFFF;
+		static constexpr size_t MASK = MaxInFlight == 0 ? 0 : MaxInFlight - 1;
+		static constexpr size_t INDEX_SLOTS = MaxInFlight * 2;
+		static constexpr int INDEX_BITS = INDEX_SLOTS == 0 ? 0 : std::countr_zero(INDEX_SLOTS);
+
+		struct Slot {
+			uint32_t address = 0;   // 0 = answered
+			uint32_t sent_ms = 0;
+			uint8_t tries = 0;      // requests sent
+		};
+
+		static bool time_reached(uint32_t now_ms, uint32_t deadline_ms) {
+			return static_cast<int32_t>(now_ms - deadline_ms) >= 0;
+		}
+
+		static constexpr size_t home(uint32_t address) {
+			return INDEX_BITS == 0 ? 0 : (address * 0x9E3779B1u) >> (32 - INDEX_BITS);
+		}
+
+		// Answered slots at the front of the ring are free again.
+		void reclaim() {
+			while (m_head != m_tail && m_ring[m_head & MASK].address == 0) {
+				++m_head;
+			}
+		}
+
+		// Hash slot holding 'address', or the empty slot ending its probe run.
+		size_t find_index(uint32_t address) const {
+			size_t index = home(address);
+			while (m_index[index] != NO_SLOT && m_ring[m_index[index]].address != address) {
+				index = (index + 1) & (INDEX_SLOTS - 1);
+			}
+			return index;
+		}
+
+		void insert(uint32_t address, uint16_t slot) { m_index[find_index(address)] = slot; }
+
+		// Backward-shift deletion, as in BasicOwnedAddressTable. The ring
+		// slot must still hold 'address': keys are compared through it.
+		void erase(uint32_t address) {
+			constexpr size_t mask = INDEX_SLOTS - 1;
+			size_t hole = find_index(address);
+			if (m_index[hole] == NO_SLOT) {
+				return;
+			}
+			for (size_t next = (hole + 1) & mask; m_index[next] != NO_SLOT; next = (next + 1) & mask) {
+				const size_t wanted = home(m_ring[m_index[next]].address);
+				if (((next - wanted) & mask) >= ((next - hole) & mask)) {
+					m_index[hole] = m_index[next];
+					hole = next;
+				}
+			}
+			m_index[hole] = NO_SLOT;
+		}
+
+		std::array<Slot, MaxInFlight> m_ring{};
+		std::array<uint16_t, INDEX_SLOTS> m_index{};
+		size_t m_head = 0;
+		size_t m_tail = 0;
+		uint32_t m_first = 0;
+		uint32_t m_count = 0;
+		uint32_t m_next = 0;        // offset of the next first request
+		uint32_t m_remaining = 0;
+		uint32_t m_window = 0;
+		uint32_t m_timeout_ms = 0;
+		uint8_t m_retries = 0;
+		TokenBucket m_bucket;
+		ArpSweepStats m_stats;
+	};
+
+}
+
+#endif
@@ -0,0 +1,131 @@
+#include "coroutine.hpp"
+#include "hal/hal_logging.hpp"
+#include <array>
+namespace net
+{
+
+    namespace
+    {
+        struct alignas(std::max_align_t) FrameBlock
+        {
+            std::byte bytes[TaskFramePool::BLOCK_SIZE];
+        };
+
+        std::array<FrameBlock, TaskFramePool::BLOCK_COUNT> g_frame_blocks;
+        std::array<bool, TaskFramePool::BLOCK_COUNT> g_frame_block_used{};
+    }
+
+    void *TaskFramePool::allocate(size_t size) noexcept
+    {
+        if (size > BLOCK_SIZE)
+        {
+            NET_LOG_ERROR(NET, "Coroutine frame of %zu bytes exceeds pool block size %zu", size, BLOCK_SIZE);
+            return nullptr;
+        }
+
+        for (size_t i = 0; i < BLOCK_COUNT; ++i)
+        {
+            if (!g_frame_block_used[i])
+            {
+                g_frame_block_used[i] = true;
+                return g_frame_blocks[i].bytes;
+            }
+        }
+
+        NET_LOG_ERROR(NET, "Coroutine frame pool exhausted (%zu tasks running)", BLOCK_COUNT);
+        return nullptr;
+    }
+
+    void TaskFramePool::deallocate(void *ptr) noexcept
+    {
+        for (size_t i = 0; i < BLOCK_COUNT; ++i)
+        {
+            if (g_frame_blocks[i].bytes == ptr)
+            {
+                g_frame_block_used[i] = false;
+                return;
+            }
+        }
+    }
+
+    size_t TaskFramePool::blocks_in_use() noexcept
+    {
+        size_t count = 0;
+        for (bool used : g_frame_block_used)
+        {
+            count += used ? 1 : 0;
+        }
+        return count;
+    }
+
+    void CoroutineScheduler::schedule(AwaitNode &node)
+    {
+        node.next = nullptr;
+        if (m_tail != nullptr)
+        {
+            m_tail->next = &node;
+        }
+        else
+        {
+            m_head = &node;
+        }
+        m_tail = &node;
+    }
+
+    void CoroutineScheduler::cancel(AwaitNode &node)
+    {
+        AwaitNode *prev = nullptr;
+        for (AwaitNode *it = m_head; it != nullptr; prev = it, it = it->next)
+        {
+            if (it == &node)
+            {
+                if (prev != nullptr)
+                {
+                    prev->next = it->next;
+                }
+                else
+                {
+                    m_head = it->next;
+                }
+                if (m_tail == it)
+                {
+                    m_tail = prev;
+                }
+                it->next = nullptr;
+                return;
+            }
+        }
+    }
+
+    void CoroutineScheduler::run_ready()
+    {
+        while (m_head != nullptr)
+        {
+            // Pop before resuming: the coroutine may destroy the awaiter (and
+            // with it the node) or queue new work while it runs.
+            AwaitNode *node = m_head;
+            m_head = node->next;
+            if (m_head == nullptr)
+            {
+                m_tail = nullptr;
+            }
+            node->next = nullptr;
+            node->handle.resume();
+        }
+    }
+
+    bool unlink_await_node(AwaitNode *&head, AwaitNode &node)
+    {
+        for (AwaitNode **link = &head; *link != nullptr; link = &(*link)->next)
+        {
+            if (*link == &node)
+            {
+                *link = node.next;
+                node.next = nullptr;
+                return true;
+            }
+        }
+        return false;
+    }
+
+}
@@ -0,0 +1,113 @@
+#ifndef NET_STACK_COROUTINE_H
+#define NET_STACK_COROUTINE_H
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include "memory_config.hpp"
+
+namespace net {
+
+	// Fixed-size block pool backing every Task's coroutine frame, so starting a
+	// task never touches the heap. Like the rest of the stack it is owned by the
+	// poll thread and is not thread-safe.
+	class TaskFramePool {
+	public:
+		static constexpr size_t BLOCK_SIZE = k_memory_config.coroutine_frame_bytes;
+		static constexpr size_t BLOCK_COUNT = k_memory_config.coroutine_frames;
+
+		// Returns nullptr if the frame is too large or the pool is exhausted.
+		static void* allocate(size_t size) noexcept;
+		static void deallocate(void* ptr) noexcept;
+		static size_t blocks_in_use() noexcept;
+	};
+
+	// Owning handle to a coroutine used for application and protocol tasks.
+	//
+	// A Task starts running immediately and runs until its first co_await on a
+	// stack awaitable; from then on it is resumed from NetworkStack::poll().
+	// The frame lives until the Task is destroyed, which also destroys a
+	// coroutine that has not finished yet, so keep the Task for as long as the
+	// coroutine should run. If the frame pool is exhausted the returned Task is
+	// empty (valid() == false) and the coroutine body never runs.
+	class [[nodiscard]] Task {
+	public:
+		struct promise_type {
+			Task get_return_object() noexcept { return Task{ std::coroutine_handle<promise_type>::from_promise(*this) }; }
+			static Task get_return_object_on_allocation_failure() noexcept { return Task{}; }
+
+			std::suspend_never initial_suspend() noexcept { return {}; }
+			std::suspend_always final_suspend() noexcept { return {}; } // Task owns the frame
+			void return_void() noexcept {}
+			void unhandled_exception() noexcept { std::terminate(); }
+
+			static void* operator new(size_t size) noexcept { return TaskFramePool::allocate(size); }
+			static void operator delete(void* ptr) noexcept { TaskFramePool::deallocate(ptr); }
+		};
+
+		Task() = default;
+		Task(Task&& other) noexcept : m_handle(other.m_handle) { other.m_handle = nullptr; }
+		Task& operator=(Task&& other) noexcept {
+			if (this != &other) {
+				reset();
+				m_handle = other.m_handle;
+				other.m_handle = nullptr;
+			}
+			return *this;
+		}
+		Task(const Task&) = delete;
+		Task& operator=(const Task&) = delete;
+		~Task() { reset(); }
+
+		bool valid() const { return static_cast<bool>(m_handle); }
+		bool done() const { return !m_handle || m_handle.done(); }
+
+	private:
+		explicit Task(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+
+		void reset() {
+			if (m_handle) {
+				m_handle.destroy();
+				m_handle = nullptr;
+			}
+		}
+
+		std::coroutine_handle<promise_type> m_handle;
+	};
+
+	// Intrusive list node embedded in every awaiter. A suspended coroutine sits
+	// in exactly one list at a time: the wait list of the event it awaits, then
+	// the scheduler's ready queue once that event has fired.
+	struct AwaitNode {
+		std::coroutine_handle<> handle;
+		AwaitNode* next = nullptr;
+	};
+
+	// Allocation-free FIFO of coroutines that are ready to continue.
+	// Events only enqueue; resumption happens from run_ready(), at a point in
+	// poll() where no protocol code is on the call stack.
+	class CoroutineScheduler {
+	public:
+		void schedule(AwaitNode& node);
+
+		// Removes a node that is still queued (its coroutine is being destroyed).
+		void cancel(AwaitNode& node);
+
+		// Resumes queued coroutines until the queue is empty.
+		void run_ready();
+
+		bool has_ready() const { return m_head != nullptr; }
+
+	private:
+		AwaitNode* m_head = nullptr;
+		AwaitNode* m_tail = nullptr;
+	};
+
+	// Unlinks 'node' from the singly-linked list starting at 'head'.
+	// Returns false if it was not in the list.
+	bool unlink_await_node(AwaitNode*& head, AwaitNode& node);
+
+}
+
+#endif
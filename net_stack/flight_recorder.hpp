@@ -0,0 +1,152 @@
+#ifndef NET_STACK_FLIGHT_RECORDER_H
+#define NET_STACK_FLIGHT_RECORDER_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+namespace net {
+
+	enum class FrameDirection : uint8_t {
+		RX = 1,
+		TX = 2,
+	};
+
+	// Always-on record of the last Frames frames (their first SnapBytes
+	// bytes), with a timestamp and direction, for post-mortem debugging.
+	//
+	// One writer (the poll thread) publishes each record with a sequence
+	// number (a seqlock): 0 while being written, index + 1 when complete. No
+	// atomic read-modify-write on the hot path. Readers never block the
+	// writer; a record overwritten while it was being read is detected and
+	// skipped, so dumping is safe from another thread or from a signal
+	// handler that interrupted the writer. Frames == 0 compiles it out.
+	template <size_t Frames, size_t SnapBytes>
+	class FlightRecorder {
+		static_assert(Frames == 0 || std::has_single_bit(Frames), "FlightRecorder size must be a power of two");
+		static_assert(std::atomic<uint32_t>::is_always_lock_free);
+
+	public:
+		static constexpr bool enabled = Frames > 0;
+
+		// Writer thread only. 'timestamp_us' is on the hal_timer_get_us() clock.
+		void record(FrameDirection direction, std::span<const std::byte> frame, uint64_t timestamp_us) {
+			if constexpr (enabled) {
+				const uint32_t index = m_head.load(std::memory_order_relaxed);
+				Record& record = m_records[index & (Frames - 1)];
+				record.sequence.store(0, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_release);
+				const size_t captured = std::min(frame.size(), SnapBytes);
+				record.timestamp_us = timestamp_us;
+				record.original_length = static_cast<uint32_t>(frame.size());
+				record.captured_length = static_cast<uint16_t>(captured);
+				record.direction = direction;
+				std::memcpy(record.data.data(), frame.data(), captured);
+				record.sequence.store(index + 1, std::memory_order_release);
+				m_head.store(index + 1, std::memory_order_release);
+			}
+		}
+
+		// Frames recorded since start (including those already overwritten).
+		uint32_t recorded() const { return m_head.load(std::memory_order_relaxed); }
+		static constexpr size_t capacity() { return Frames; }
+		static constexpr size_t snapshot_bytes() { return SnapBytes; }
+
+		// Writes the retained frames, oldest first, as a pcapng file through
+		// write(const void*, size_t). Timestamps become epoch_offset_us +
+		// timestamp_us. Does not allocate or lock: signal-safe if write() is.
+		template <typename Write>
+		void write_pcapng(Write&& write, uint64_t epoch_offset_us) const {
+			write_section_header(write);
+			if constexpr (enabled) {
+				const uint32_t head = m_head.load(std::memory_order_acquire);
+				const uint32_t retained = std::min<uint32_t>(head, static_cast<uint32_t>(Frames));
+				for (uint32_t index = head - retained; index != head; ++index) {
+					const Record& record = m_records[index & (Frames - 1)];
+					if (record.sequence.load(std::memory_order_acquire) != index + 1) {
+						continue; // being written, or already reused
+					}
+					Record copy;
+					copy.timestamp_us = record.timestamp_us;
+					copy.original_length = record.original_length;
+					copy.captured_length = std::min<uint16_t>(record.captured_length, static_cast<uint16_t>(SnapBytes));
+					copy.direction = record.direction;
+					std::memcpy(copy.data.data(), record.data.data(), copy.captured_length);
+					std::atomic_thread_fence(std::memory_order_acquire);
+					if (record.sequence.load(std::memory_order_relaxed) != index + 1) {
+						continue; // overwritten while we copied it
+					}
+					write_packet_block(write, copy, epoch_offset_us);
+				}
+			}
+		}
+
+	private:
+		struct Record {
+			std::atomic<uint32_t> sequence{ 0 };
+			uint32_t original_length = 0;
+			uint64_t timestamp_us = 0;
+			uint16_t captured_length = 0;
+			FrameDirection direction = FrameDirection::RX;
+			// Aligned: unaligned small copies cost several times more.
+			alignas(16) std::array<std::byte, SnapBytes> data;
+		};
+
+		// pcapng (rather than classic pcap) so each packet carries its
+		// direction (epb_flags); Wireshark and tcpdump read both.
+		static constexpr uint32_t PCAPNG_SECTION_HEADER = 0x0A0D0D0A;
+		static constexpr uint32_t PCAPNG_INTERFACE_DESCRIPTION = 0x00000001;
+		static constexpr uint32_t PCAPNG_ENHANCED_PACKET = 0x00000006;
+		static constexpr uint32_t PCAPNG_BYTE_ORDER_MAGIC = 0x1A2B3C4D;
+		static constexpr uint16_t PCAPNG_LINKTYPE_ETHERNET = 1;
+		static constexpr uint16_t PCAPNG_OPTION_EPB_FLAGS = 2;
+
+		template <typename Write>
+		static void write_section_header(Write& write) {
+			// Section header: native byte order, version 1.0, unknown section length.
+			const uint32_t section_start[3] = { PCAPNG_SECTION_HEADER, 28, PCAPNG_BYTE_ORDER_MAGIC };
+			const uint16_t version[2] = { 1, 0 };
+			const uint32_t section_end[3] = { 0xFFFFFFFFu, 0xFFFFFFFFu, 28 };
+			write(section_start, sizeof(section_start));
+			write(version, sizeof(version));
+			write(section_end, sizeof(section_end));
+			// One Ethernet interface; the default timestamp resolution is 1 us.
+			const uint32_t interface_start[2] = { PCAPNG_INTERFACE_DESCRIPTION, 20 };
+			const uint16_t link_type[2] = { PCAPNG_LINKTYPE_ETHERNET, 0 };
+			const uint32_t interface_end[2] = { static_cast<uint32_t>(SnapBytes), 20 };
+			write(interface_start, sizeof(interface_start));
+			write(link_type, sizeof(link_type));
+			write(interface_end, sizeof(interface_end));
+		}
+
+		template <typename Write>
+		static void write_packet_block(Write& write, const Record& record, uint64_t epoch_offset_us) {
+			const uint32_t padded = (record.captured_length + 3u) & ~3u;
+			const uint32_t block_length = 44 + padded;
+			const uint64_t timestamp = epoch_offset_us + record.timestamp_us;
+			const uint32_t header[7] = { PCAPNG_ENHANCED_PACKET, block_length, 0,
+				static_cast<uint32_t>(timestamp >> 32), static_cast<uint32_t>(timestamp),
+				record.captured_length, record.original_length };
+			write(header, sizeof(header));
+			write(record.data.data(), record.captured_length);
+			const std::array<std::byte, 3> padding{};
+			write(padding.data(), padded - record.captured_length);
+			// epb_flags: bits 0-1 are the direction (1 inbound, 2 outbound).
+			const uint16_t option[2] = { PCAPNG_OPTION_EPB_FLAGS, 4 };
+			write(option, sizeof(option));
+			const uint32_t trailer[3] = { static_cast<uint32_t>(record.direction), 0, block_length };
+			write(trailer, sizeof(trailer));
+		}
+
+		std::atomic<uint32_t> m_head{ 0 };
+		std::array<Record, Frames> m_records;
+	};
+
+}
+
+#endif
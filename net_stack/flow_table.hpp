@@ -0,0 +1,261 @@
+#ifndef NET_STACK_FLOW_TABLE_H
+#define NET_STACK_FLOW_TABLE_H
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "byte_order.hpp"
+#include "ipv4_reassembly.hpp"
+#include "protocols/ethernet.hpp"
+#include "protocols/ipv4.hpp"
+
+namespace net {
+
+	// 5-tuple plus EtherType of a received packet. Laid out as two 64-bit
+	// words so hashing and comparing are two loads and a few ALU ops. Ports
+	// are 0 for protocols without them. Host byte order.
+	struct alignas(8) FlowKey {
+		std::array<uint8_t, IPV4_ADDRESS_LENGTH> source_ip{};
+		std::array<uint8_t, IPV4_ADDRESS_LENGTH> destination_ip{};
+		uint16_t source_port = 0;
+		uint16_t destination_port = 0;
+		uint16_t ethertype = 0;
+		uint8_t protocol = 0;
+		uint8_t reserved = 0;
+
+		constexpr std::array<uint64_t, 2> words() const { return std::bit_cast<std::array<uint64_t, 2>>(*this); }
+		constexpr bool operator==(const FlowKey& other) const { return words() == other.words(); }
+	};
+	static_assert(sizeof(FlowKey) == 16);
+
+	constexpr uint32_t flow_hash(const FlowKey& key) {
+		const std::array<uint64_t, 2> w = key.words();
+		const uint64_t h = (w[0] ^ (w[1] * 0x9E3779B97F4A7C15ull)) * 0xC2B2AE3D27D4EB4Full;
+		return static_cast<uint32_t>(h >> 32);
+	}
+
+	// Key of a datagram for us; the ports are the first four payload bytes
+	// of TCP and UDP (read as one word).
+	inline FlowKey make_flow_key(const Ipv4Datagram& datagram) {
+		FlowKey key;
+		key.source_ip = datagram.source;
+		key.destination_ip = datagram.destination;
+		key.ethertype = ETHERTYPE_IPV4;
+		key.protocol = datagram.protocol;
+		if ((datagram.protocol == IPV4_PROTOCOL_UDP || datagram.protocol == IPV4_PROTOCOL_TCP) &&
+			datagram.payload.size() >= 4) {
+			uint32_t ports;
+			std::memcpy(&ports, datagram.payload.data(), sizeof(ports));
+			const std::array<uint16_t, 2> be = std::bit_cast<std::array<uint16_t, 2>>(ports);
+			key.source_port = net_ntohs16(be[0]);
+			key.destination_port = net_ntohs16(be[1]);
+		}
+		return key;
+	}
+
+	// What a flow handler is bound to. Zero fields are wildcards; of the
+	// bindings that match a packet, the one with most fields set wins.
+	struct FlowMatch {
+		uint16_t ethertype = ETHERTYPE_IPV4;
+		uint8_t protocol = 0;
+		uint16_t local_port = 0;                         // destination port
+		std::array<uint8_t, IPV4_ADDRESS_LENGTH> remote_ip{}; // source address
+		uint16_t remote_port = 0;                        // source port
+
+		constexpr bool operator==(const FlowMatch&) const = default;
+
+		constexpr uint32_t specificity() const {
+			return (protocol != 0 ? 1u : 0u) + (local_port != 0 ? 1u : 0u) +
+				(remote_ip != std::array<uint8_t, IPV4_ADDRESS_LENGTH>{} ? 1u : 0u) + (remote_port != 0 ? 1u : 0u);
+		}
+
+		// The match as FlowKey-shaped mask and value: a key matches if
+		// (key & mask) == value, word by word.
+		constexpr FlowKey value() const {
+			FlowKey key;
+			key.source_ip = remote_ip;
+			key.source_port = remote_port;
+			key.destination_port = local_port;
+			key.ethertype = ethertype;
+			key.protocol = protocol;
+			return key;
+		}
+		constexpr FlowKey mask() const {
+			constexpr std::array<uint8_t, IPV4_ADDRESS_LENGTH> any{};
+			FlowKey key;
+			key.source_ip = remote_ip != any ? std::array<uint8_t, IPV4_ADDRESS_LENGTH>{ 0xFF, 0xFF, 0xFF, 0xFF } : any;
+			key.source_port = remote_port != 0 ? 0xFFFF : 0;
+			key.destination_port = local_port != 0 ? 0xFFFF : 0;
+			key.ethertype = 0xFFFF;
+			key.protocol = protocol != 0 ? 0xFF : 0;
+			return key;
+		}
+	};
+
+	struct FlowTableStats {
+		uint64_t hits = 0;         // flow found in the cache
+		uint64_t misses = 0;       // bindings searched
+		uint64_t evictions = 0;    // a cached flow made room for another
+		uint64_t unmatched = 0;    // searches that found no binding (cached too)
+
+		constexpr double hit_rate() const {
+			return hits + misses == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(hits + misses);
+		}
+	};
+
+	// Flow bindings (up to MaxBindings, searched in full on a miss; kept as
+	// mask/value words, most specific first, so the first hit wins) with a
+	// flow cache in front: two-way set associative, indexed by flow_hash(),
+	// replacing the less recently used way, like the NextHopCache. A cached
+	// flow remembers the binding it resolved to (or that none matched), so
+	// repeat packets skip the search. Binding changes bump a generation and
+	// invalidate every cached flow at once. CacheEntries == 0 disables it.
+	template <typename Target, size_t MaxBindings, size_t CacheEntries>
+	class FlowTable {
+		static_assert(MaxBindings > 0 && MaxBindings < 0xFFFF);
+		static_assert(CacheEntries == 0 || (std::has_single_bit(CacheEntries) && CacheEntries >= 2),
+			"FlowTable cache size must be 0 or a power of two >= 2");
+
+	public:
+		// Adds or replaces the binding for 'match'. False if the table is full.
+		bool bind(const FlowMatch& match, const Target& target) {
+			for (size_t i = 0; i < m_count; ++i) {
+				if (m_bindings[i].match == match) {
+					m_bindings[i].target = target;
+					invalidate();
+					return true;
+				}
+			}
+			if (m_count == MaxBindings) {
+				return false;
+			}
+			// Insert after the bindings at least as specific.
+			size_t index = m_count;
+			while (index > 0 && m_bindings[index - 1].match.specificity() < match.specificity()) {
+				m_bindings[index] = m_bindings[index - 1];
+				--index;
+			}
+			m_bindings[index] = { match, match.mask().words(), match.value().words(), target };
+			++m_count;
+			invalidate();
+			return true;
+		}
+
+		bool unbind(const FlowMatch& match) {
+			for (size_t i = 0; i < m_count; ++i) {
+				if (m_bindings[i].match == match) {
+					for (size_t j = i + 1; j < m_count; ++j) {
+						m_bindings[j - 1] = m_bindings[j];
+					}
+					--m_count;
+					invalidate();
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// The target bound to the packet's flow, or nullptr.
+		const Target* classify(const FlowKey& key) {
+			// Nothing bound (the default): nothing to search or cache.
+			if (m_count == 0) {
+				return nullptr;
+			}
+			if constexpr (CacheEntries == 0) {
+				++m_stats.misses;
+				return target_of(search(key));
+			}
+			else {
+				const size_t set = (flow_hash(key) & (SETS - 1));
+				for (size_t way = 0; way < WAYS; ++way) {
+					const CacheEntry& entry = m_cache[set * WAYS + way];
+					if (entry.generation == m_generation && entry.key == key) {
+						m_victim[set] = static_cast<uint8_t>(way ^ 1);
+						++m_stats.hits;
+						return target_of(entry.binding);
+					}
+				}
+				++m_stats.misses;
+				const uint16_t binding = search(key);
+
+				size_t way = m_victim[set];
+				if (m_cache[set * WAYS].generation != m_generation) {
+					way = 0;
+				}
+				else if (m_cache[set * WAYS + 1].generation != m_generation) {
+					way = 1;
+				}
+				else {
+					++m_stats.evictions;
+				}
+				m_victim[set] = static_cast<uint8_t>(way ^ 1);
+				m_cache[set * WAYS + way] = { key, m_generation, binding };
+				return target_of(binding);
+			}
+		}
+
+		// The full search, bypassing the cache (for comparison).
+		const Target* classify_uncached(const FlowKey& key) { return target_of(search(key)); }
+
+		size_t binding_count() const { return m_count; }
+		static constexpr size_t max_bindings() { return MaxBindings; }
+		static constexpr size_t cache_entries() { return CacheEntries; }
+		const FlowTableStats& get_stats() const { return m_stats; }
+		void reset_stats() { m_stats = {}; }
+
+	private:
+		static constexpr uint16_t NO_BINDING = 0xFFFF;
+		static constexpr size_t WAYS = 2;
+		static constexpr size_t SETS = CacheEntries / WAYS;
+
+		struct Binding {
+			FlowMatch match;
+			std::array<uint64_t, 2> mask{};
+			std::array<uint64_t, 2> value{};
+			Target target{};
+		};
+
+		struct CacheEntry {
+			FlowKey key;
+			uint32_t generation = 0;   // 0 = empty
+			uint16_t binding = NO_BINDING;
+		};
+
+		uint16_t search(const FlowKey& key) {
+			const std::array<uint64_t, 2> words = key.words();
+			for (size_t i = 0; i < m_count; ++i) {
+				const Binding& binding = m_bindings[i];
+				if (((words[0] & binding.mask[0]) ^ binding.value[0]) == 0 &&
+					((words[1] & binding.mask[1]) ^ binding.value[1]) == 0) {
+					return static_cast<uint16_t>(i);
+				}
+			}
+			++m_stats.unmatched;
+			return NO_BINDING;
+		}
+
+		const Target* target_of(uint16_t binding) const {
+			return binding == NO_BINDING ? nullptr : &m_bindings[binding].target;
+		}
+
+		void invalidate() {
+			if (++m_generation == 0) {
+				m_cache = {};
+				m_generation = 1;
+			}
+		}
+
+		std::array<Binding, MaxBindings> m_bindings{};
+		size_t m_count = 0;
+		std::array<CacheEntry, CacheEntries> m_cache{};
+		std::array<uint8_t, SETS> m_victim{};
+		uint32_t m_generation = 1;
+		FlowTableStats m_stats;
+	};
+
+}
+
+#endif
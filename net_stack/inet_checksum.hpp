@@ -0,0 +1,33 @@
+#ifndef NET_STACK_INET_CHECKSUM_H
+#define NET_STACK_INET_CHECKSUM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace net {
+
+	// RFC 1071 one's-complement sum of big-endian 16-bit words, folded to 16
+	// bits. A header with a correct checksum field sums to 0xFFFF.
+	inline uint16_t ones_complement_sum(std::span<const std::byte> data, uint32_t sum = 0) {
+		size_t i = 0;
+		for (; i + 1 < data.size(); i += 2) {
+			sum += (static_cast<uint32_t>(data[i]) << 8) | static_cast<uint32_t>(data[i + 1]);
+		}
+		if (i < data.size()) {
+			sum += static_cast<uint32_t>(data[i]) << 8;
+		}
+		while (sum >> 16) {
+			sum = (sum & 0xFFFF) + (sum >> 16);
+		}
+		return static_cast<uint16_t>(sum);
+	}
+
+	// Value for a checksum field (host order): the complement of the sum.
+	inline uint16_t internet_checksum(std::span<const std::byte> data) {
+		return static_cast<uint16_t>(~ones_complement_sum(data));
+	}
+
+}
+
+#endif
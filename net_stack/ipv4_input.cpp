@@ -0,0 +1,72 @@
+#include "ipv4_input.hpp"
+#include "hal/hal_logging.hpp"
+#include "byte_order.hpp"
+#include "inet_checksum.hpp"
+#include <cstring>
+
+namespace net
+{
+
+    std::optional<Ipv4Datagram> Ipv4Input::process_packet(std::span<const std::byte> packet,
+                                                          const std::array<uint8_t, IPV4_ADDRESS_LENGTH> &our_ip,
+                                                          uint32_t now_ms)
+    {
+        ++m_stats.packets;
+        if (packet.size() < IPV4_MIN_HEADER_LENGTH)
+        {
+            ++m_stats.header_errors;
+            return std::nullopt;
+        }
+
+        const Ipv4Header &header = *reinterpret_cast<const Ipv4Header *>(packet.data());
+        const size_t header_length = static_cast<size_t>(header.version_ihl & 0x0F) * 4;
+        const size_t total_length = net_ntohs16(header.total_length);
+        if ((header.version_ihl >> 4) != IPV4_VERSION || header_length < IPV4_MIN_HEADER_LENGTH ||
+            total_length < header_length || total_length > packet.size())
+        {
+            ++m_stats.header_errors;
+            NET_LOG_DEBUG(IP, "Bad IPv4 header (version/IHL 0x%02X, total length %zu, %zu bytes received)",
+                          header.version_ihl, total_length, packet.size());
+            return std::nullopt;
+        }
+        if (ones_complement_sum(packet.first(header_length)) != 0xFFFF)
+        {
+            ++m_stats.checksum_errors;
+            return std::nullopt;
+        }
+
+        static constexpr std::array<uint8_t, IPV4_ADDRESS_LENGTH> broadcast = {255, 255, 255, 255};
+        if (std::memcmp(header.destination_ip, our_ip.data(), IPV4_ADDRESS_LENGTH) != 0 &&
+            std::memcmp(header.destination_ip, broadcast.data(), IPV4_ADDRESS_LENGTH) != 0)
+        {
+            ++m_stats.not_for_us;
+            return std::nullopt;
+        }
+
+        // Ethernet pads short frames; total_length says where the datagram ends.
+        const std::span<const std::byte> payload = packet.subspan(header_length, total_length - header_length);
+        const uint16_t flags_offset = net_ntohs16(header.flags_fragment_offset);
+        std::optional<Ipv4Datagram> datagram;
+        if ((flags_offset & (IPV4_FLAG_MORE_FRAGMENTS | IPV4_FRAGMENT_OFFSET_MASK)) != 0)
+        {
+            datagram = m_reassembler.add_fragment(header, payload, now_ms);
+        }
+        else
+        {
+            datagram.emplace();
+            std::memcpy(datagram->source.data(), header.source_ip, IPV4_ADDRESS_LENGTH);
+            std::memcpy(datagram->destination.data(), header.destination_ip, IPV4_ADDRESS_LENGTH);
+            datagram->protocol = header.protocol;
+            datagram->ttl = header.ttl;
+            datagram->identification = net_ntohs16(header.identification);
+            datagram->payload = payload;
+        }
+
+        if (datagram.has_value())
+        {
+            ++m_stats.delivered;
+        }
+        return datagram;
+    }
+
+}
@@ -0,0 +1,47 @@
+#ifndef NET_STACK_IPV4_INPUT_H
+#define NET_STACK_IPV4_INPUT_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+#include "protocols/arp.hpp"
+#include "protocols/ipv4.hpp"
+#include "ipv4_reassembly.hpp"
+
+namespace net {
+
+	struct Ipv4Stats {
+		uint32_t packets = 0;
+		uint32_t delivered = 0;          // datagrams handed to the upper layer
+		uint32_t header_errors = 0;      // bad version, header or total length
+		uint32_t checksum_errors = 0;
+		uint32_t not_for_us = 0;         // neither our address nor broadcast
+	};
+
+	// IPv4 receive path: header validation, address filtering and fragment
+	// reassembly. Like the ArpCache it has no stack dependency; the handler
+	// passes each packet in and forwards the datagrams that come out.
+	class Ipv4Input {
+	public:
+		// 'packet' starts at the IP header (Ethernet padding may follow).
+		// Returns the datagram if 'packet' is, or completes, one for us.
+		std::optional<Ipv4Datagram> process_packet(std::span<const std::byte> packet,
+			const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& our_ip, uint32_t now_ms);
+
+		// Periodically called to drop stale reassemblies.
+		void expire(uint32_t now_ms) { m_reassembler.expire(now_ms); }
+
+		Ipv4Reassembler& get_reassembler() { return m_reassembler; }
+		const Ipv4Stats& get_stats() const { return m_stats; }
+
+	private:
+		Ipv4Reassembler m_reassembler;
+		Ipv4Stats m_stats;
+	};
+
+}
+
+#endif
@@ -0,0 +1,251 @@
+#include "ipv4_reassembly.hpp"
+#include "hal/hal_logging.hpp"
+#include "byte_order.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace net
+{
+
+    static_assert(k_memory_config.ipv4_reassembly_bytes + IPV4_MIN_HEADER_LENGTH <= IPV4_MAX_PACKET_LENGTH,
+                  "ipv4_reassembly_bytes exceeds the largest IPv4 datagram");
+
+    std::optional<Ipv4Datagram> Ipv4Reassembler::add_fragment(const Ipv4Header &header,
+                                                              std::span<const std::byte> payload,
+                                                              uint32_t now_ms)
+    {
+        ++m_stats.fragments;
+        const uint16_t flags_offset = net_ntohs16(header.flags_fragment_offset);
+        const bool more_fragments = (flags_offset & IPV4_FLAG_MORE_FRAGMENTS) != 0;
+        const size_t first = static_cast<size_t>(flags_offset & IPV4_FRAGMENT_OFFSET_MASK) * 8;
+        const size_t end = first + payload.size();
+
+        // Every fragment but the last carries a multiple of 8 bytes.
+        if (payload.empty() || (more_fragments && payload.size() % 8 != 0))
+        {
+            ++m_stats.malformed;
+            return std::nullopt;
+        }
+
+        Slot *slot = find_slot(header);
+        if (end > SLOT_BYTES)
+        {
+            ++m_stats.too_large;
+            NET_LOG_DEBUG(IP, "Fragment ends at %zu, beyond the %zu-byte reassembly limit", end, SLOT_BYTES);
+            if (slot != nullptr)
+            {
+                slot->in_use = false;
+            }
+            return std::nullopt;
+        }
+        if (slot == nullptr)
+        {
+            slot = allocate_slot(header, now_ms);
+            if (slot == nullptr)
+            {
+                return std::nullopt;
+            }
+        }
+
+        // The last fragment fixes the length; data past it, or a second
+        // "last" fragment disagreeing, means the datagram is inconsistent.
+        if ((slot->length_known && (end > slot->total_length || (!more_fragments && end != slot->total_length))) ||
+            (!more_fragments && end < slot->received_end))
+        {
+            ++m_stats.malformed;
+            slot->in_use = false;
+            return std::nullopt;
+        }
+
+        // Find the holes this fragment touches.
+        const size_t last = end - 1;
+        size_t touched = 0;
+        size_t hole_index = 0;
+        for (size_t i = 0; i < slot->hole_count; ++i)
+        {
+            if (slot->holes[i].first <= last && slot->holes[i].last >= first)
+            {
+                ++touched;
+                hole_index = i;
+            }
+        }
+        if (touched == 0)
+        {
+            ++m_stats.duplicates;
+            return std::nullopt;
+        }
+        const Hole hole = slot->holes[hole_index];
+        if (touched > 1 || first < hole.first || last > hole.last)
+        {
+            ++m_stats.overlaps;
+            NET_LOG_DEBUG(IP, "Overlapping fragment [%zu, %zu]; dropping datagram %u", first, last,
+                          static_cast<unsigned>(slot->identification));
+            slot->in_use = false;
+            return std::nullopt;
+        }
+
+        // Split the hole: what is left before and after the fragment.
+        const bool keep_before = first > hole.first;
+        const bool keep_after = last < hole.last && more_fragments;
+        const size_t needed = slot->hole_count - 1 + (keep_before ? 1 : 0) + (keep_after ? 1 : 0);
+        if (needed > MAX_HOLES)
+        {
+            ++m_stats.too_many_holes;
+            slot->in_use = false;
+            return std::nullopt;
+        }
+        remove_hole(*slot, hole_index);
+        if (keep_before)
+        {
+            slot->holes[slot->hole_count++] = Hole{hole.first, static_cast<uint16_t>(first - 1)};
+        }
+        if (keep_after)
+        {
+            slot->holes[slot->hole_count++] = Hole{static_cast<uint16_t>(last + 1), hole.last};
+        }
+
+        std::memcpy(slot->data.data() + first, payload.data(), payload.size());
+        slot->last_active = ++m_activity;
+        slot->received_end = static_cast<uint16_t>(std::max<size_t>(slot->received_end, end));
+
+        if (!more_fragments)
+        {
+            slot->length_known = true;
+            slot->total_length = static_cast<uint16_t>(end);
+            // The open-ended tail hole (and anything past the end) goes away.
+            for (size_t i = 0; i < slot->hole_count;)
+            {
+                if (slot->holes[i].first >= end)
+                {
+                    remove_hole(*slot, i);
+                }
+                else
+                {
+                    slot->holes[i].last = std::min<uint16_t>(slot->holes[i].last, static_cast<uint16_t>(end - 1));
+                    ++i;
+                }
+            }
+        }
+
+        if (!slot->length_known || slot->hole_count != 0)
+        {
+            return std::nullopt;
+        }
+
+        ++m_stats.reassembled;
+        slot->in_use = false; // the data stays put until the slot is reused
+        Ipv4Datagram datagram;
+        datagram.source = slot->source;
+        datagram.destination = slot->destination;
+        datagram.protocol = slot->protocol;
+        datagram.ttl = slot->ttl;
+        datagram.identification = slot->identification;
+        datagram.reassembled = true;
+        datagram.payload = std::span<const std::byte>(slot->data.data(), slot->total_length);
+        NET_LOG_DEBUG(IP, "Reassembled datagram %u, %u bytes", static_cast<unsigned>(datagram.identification),
+                      static_cast<unsigned>(slot->total_length));
+        return datagram;
+    }
+
+    void Ipv4Reassembler::expire(uint32_t now_ms)
+    {
+        for (auto &slot : m_slots)
+        {
+            if (slot.in_use && now_ms - slot.started_ms >= m_policy.timeout_ms)
+            {
+                NET_LOG_DEBUG(IP, "Reassembly of datagram %u timed out", static_cast<unsigned>(slot.identification));
+                slot.in_use = false;
+                ++m_stats.timeouts;
+            }
+        }
+    }
+
+    size_t Ipv4Reassembler::slots_in_use() const
+    {
+        return static_cast<size_t>(std::count_if(m_slots.begin(), m_slots.end(),
+                                                 [](const Slot &slot) { return slot.in_use; }));
+    }
+
+    // RFC 791: fragments belong together if source, destination, protocol and identification match.
+    Ipv4Reassembler::Slot *Ipv4Reassembler::find_slot(const Ipv4Header &header)
+    {
+        for (auto &slot : m_slots)
+        {
+            if (slot.in_use && slot.identification == net_ntohs16(header.identification) && slot.protocol == header.protocol &&
+                std::memcmp(slot.source.data(), header.source_ip, IPV4_ADDRESS_LENGTH) == 0 &&
+                std::memcmp(slot.destination.data(), header.destination_ip, IPV4_ADDRESS_LENGTH) == 0)
+            {
+                return &slot;
+            }
+        }
+        return nullptr;
+    }
+
+    Ipv4Reassembler::Slot *Ipv4Reassembler::allocate_slot(const Ipv4Header &header, uint32_t now_ms)
+    {
+        Slot *free_slot = nullptr;
+        Slot *idlest = nullptr;
+        Slot *oldest_of_source = nullptr;
+        uint32_t source_slots = 0;
+        for (auto &slot : m_slots)
+        {
+            if (!slot.in_use)
+            {
+                free_slot = free_slot == nullptr ? &slot : free_slot;
+                continue;
+            }
+            if (idlest == nullptr || m_activity - slot.last_active > m_activity - idlest->last_active)
+            {
+                idlest = &slot;
+            }
+            if (std::memcmp(slot.source.data(), header.source_ip, IPV4_ADDRESS_LENGTH) == 0)
+            {
+                ++source_slots;
+                if (oldest_of_source == nullptr || now_ms - slot.started_ms > now_ms - oldest_of_source->started_ms)
+                {
+                    oldest_of_source = &slot;
+                }
+            }
+        }
+
+        Slot *slot = free_slot;
+        if (oldest_of_source != nullptr && source_slots >= m_policy.max_slots_per_source)
+        {
+            // Over its cap: the source only ever competes with itself.
+            ++m_stats.source_limited;
+            slot = oldest_of_source;
+        }
+        else if (slot == nullptr)
+        {
+            // Full: a datagram whose fragments stopped arriving is the least
+            // likely to complete; one still receiving them is kept.
+            if (idlest == nullptr)
+            {
+                return nullptr; // no slots configured
+            }
+            ++m_stats.evicted;
+            slot = idlest;
+        }
+
+        slot->in_use = true;
+        slot->length_known = false;
+        slot->protocol = header.protocol;
+        slot->ttl = header.ttl;
+        slot->identification = net_ntohs16(header.identification);
+        slot->total_length = 0;
+        slot->received_end = 0;
+        slot->started_ms = now_ms;
+        std::memcpy(slot->source.data(), header.source_ip, IPV4_ADDRESS_LENGTH);
+        std::memcpy(slot->destination.data(), header.destination_ip, IPV4_ADDRESS_LENGTH);
+        slot->holes[0] = Hole{0, static_cast<uint16_t>(SLOT_BYTES - 1)};
+        slot->hole_count = 1;
+        return slot;
+    }
+
+    void Ipv4Reassembler::remove_hole(Slot &slot, size_t index)
+    {
+        slot.holes[index] = slot.holes[slot.hole_count - 1];
+        --slot.hole_count;
+    }
+
+}
@@ -0,0 +1,123 @@
+#ifndef NET_STACK_IPV4_REASSEMBLY_H
+#define NET_STACK_IPV4_REASSEMBLY_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+#include "protocols/arp.hpp"
+#include "protocols/ipv4.hpp"
+#include "memory_config.hpp"
+
+namespace net {
+
+	// A complete IPv4 datagram handed to the upper layer. 'payload' points into
+	// the received frame or, if reassembled, into a reassembly slot; either
+	// way it is only valid until the stack processes the next frame.
+	struct Ipv4Datagram {
+		std::array<uint8_t, IPV4_ADDRESS_LENGTH> source{};
+		std::array<uint8_t, IPV4_ADDRESS_LENGTH> destination{};
+		uint8_t protocol = 0;
+		uint8_t ttl = 0;
+		uint16_t identification = 0;
+		bool reassembled = false;
+		std::span<const std::byte> payload;
+	};
+
+	// Fragment flood protection knobs.
+	struct ReassemblyPolicy {
+		// A datagram not complete after this long is dropped (RFC 791
+		// suggests 15 s; shorter frees slots sooner under a flood).
+		uint32_t timeout_ms = 5000;
+
+		// Slots one source IP may hold at once. A source over its cap
+		// recycles its own oldest slot instead of taking somebody else's.
+		uint32_t max_slots_per_source = 1;
+	};
+
+	struct ReassemblyStats {
+		uint32_t fragments = 0;
+		uint32_t reassembled = 0;
+		uint32_t duplicates = 0;       // fragment fully inside data we already have
+		uint32_t overlaps = 0;         // partial overlap: datagram dropped (RFC 5722 style)
+		uint32_t malformed = 0;        // empty, misaligned, or inconsistent with the last fragment
+		uint32_t too_large = 0;        // would exceed MemoryConfig::ipv4_reassembly_bytes
+		uint32_t too_many_holes = 0;   // more gaps than a slot can track
+		uint32_t timeouts = 0;
+		uint32_t evicted = 0;          // all slots busy: the least recently active datagram made room
+		uint32_t source_limited = 0;   // a source at its cap recycled its own slot
+	};
+
+	// IPv4 fragment reassembly into a fixed set of preallocated slots (no heap).
+	//
+	// Each slot tracks the gaps still missing with RFC 815 hole descriptors: a
+	// fragment must fall entirely inside one hole, which it splits into at most
+	// two. A fragment entirely inside received data is a harmless duplicate;
+	// one straddling received data is treated as an overlap attack and the
+	// whole datagram is dropped.
+	class Ipv4Reassembler {
+	public:
+		Ipv4Reassembler() = default;
+		explicit Ipv4Reassembler(const ReassemblyPolicy& policy) : m_policy(policy) {}
+
+		void set_policy(const ReassemblyPolicy& policy) { m_policy = policy; }
+		const ReassemblyPolicy& get_policy() const { return m_policy; }
+		const ReassemblyStats& get_stats() const { return m_stats; }
+
+		// Takes one fragment (MF set or a non-zero offset). 'payload' is the
+		// data after the IP header, already trimmed to total_length. Returns
+		// the datagram when this fragment completes it; its payload stays
+		// valid until the next add_fragment() call.
+		std::optional<Ipv4Datagram> add_fragment(const Ipv4Header& header, std::span<const std::byte> payload,
+			uint32_t now_ms);
+
+		// Drops datagrams older than the policy timeout. Called periodically.
+		void expire(uint32_t now_ms);
+
+		size_t slots_in_use() const;
+		static constexpr size_t slot_count() { return SLOTS; }
+		static constexpr size_t max_datagram_bytes() { return SLOT_BYTES; }
+
+	private:
+		static constexpr size_t SLOTS = k_memory_config.ipv4_reassembly_slots;
+		static constexpr size_t SLOT_BYTES = k_memory_config.ipv4_reassembly_bytes;
+		static constexpr size_t MAX_HOLES = 8;
+
+		// Missing bytes [first, last], inclusive.
+		struct Hole {
+			uint16_t first = 0;
+			uint16_t last = 0;
+		};
+
+		struct Slot {
+			bool in_use = false;
+			bool length_known = false;     // the last fragment (MF clear) arrived
+			uint8_t protocol = 0;
+			uint8_t ttl = 0;
+			uint16_t identification = 0;
+			uint16_t total_length = 0;     // payload bytes, once length_known
+			uint16_t received_end = 0;     // highest byte received + 1
+			uint8_t hole_count = 0;
+			uint32_t started_ms = 0;
+			uint32_t last_active = 0;      // m_activity when a fragment last landed here
+			std::array<uint8_t, IPV4_ADDRESS_LENGTH> source{};
+			std::array<uint8_t, IPV4_ADDRESS_LENGTH> destination{};
+			std::array<Hole, MAX_HOLES> holes{};
+			std::array<std::byte, SLOT_BYTES> data;
+		};
+
+		Slot* find_slot(const Ipv4Header& header);
+		Slot* allocate_slot(const Ipv4Header& header, uint32_t now_ms);
+		void remove_hole(Slot& slot, size_t index);
+
+		std::array<Slot, SLOTS> m_slots;
+		uint32_t m_activity = 0;
+		ReassemblyPolicy m_policy;
+		ReassemblyStats m_stats;
+	};
+
+}
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef NET_STACK_LATENCY_STATS_H
+#define NET_STACK_LATENCY_STATS_H
+
+#include <cstdint>
+
+namespace net {
+
+	// Running min/max/average of a latency in nanoseconds. Fixed size, no
+	// history kept; reset by assigning a default-constructed value.
+	struct LatencyStats {
+		uint64_t samples = 0;
+		uint64_t last_ns = 0;
+		uint64_t min_ns = UINT64_MAX;
+		uint64_t max_ns = 0;
+		uint64_t total_ns = 0;
+
+		constexpr void add(uint64_t ns) {
+			++samples;
+			last_ns = ns;
+			total_ns += ns;
+			if (ns < min_ns) min_ns = ns;
+			if (ns > max_ns) max_ns = ns;
+		}
+
+		constexpr uint64_t average_ns() const { return samples == 0 ? 0 : total_ns / samples; }
+	};
+
+}
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef NET_STACK_MEMORY_CONFIG_H
+#define NET_STACK_MEMORY_CONFIG_H
+
+#include <bit>
+#include <cstddef>
+
+namespace net {
+
+	// Every statically sized buffer and table in the stack, in one place.
+	// Nothing here is allocated at run time; the sizes only fix array bounds.
+	struct MemoryConfig {
+		size_t mtu = 1500;                            // largest L3 packet on the link (9000 for jumbo)
+		size_t frame_buffer_bytes = mtu + 14;         // largest frame poll() can receive; raise to
+		                                              // ~64 KiB to accept GRO super-frames
+		size_t arp_cache_entries = 16;
+		size_t arp_source_limiter_slots = 32; // per-sender flood limiter, power of two
+		size_t coroutine_frame_bytes = 512;   // per Task frame
+		size_t coroutine_frames = 8;          // Tasks alive at once (all interfaces)
+		size_t log_line_bytes = 256;          // hal_log() formatting buffer (call stack)
+		size_t tx_queue_slots = 8;            // cross-thread TX submissions, power of two
+		size_t tx_queue_slot_bytes = mtu + 14; // largest frame a worker thread can submit
+		size_t routes = 8;                    // routing table entries (connected, default, static)
+		size_t route_trie_nodes = 16;         // compiled LPM trie nodes, 24 bytes each
+		size_t route_trie_leaves = 128;       // compiled LPM trie leaf runs, 2 bytes each
+		size_t route_next_hops = 8;           // distinct gateways in the routing table
+		size_t route_direct_bits = 8;         // LPM first level: 4 << route_direct_bits bytes
+		size_t next_hop_cache_entries = 16;   // per-destination route/ARP memo, power of two
+		size_t ipv4_reassembly_slots = 2;     // fragmented datagrams reassembled at once
+		size_t ipv4_reassembly_bytes = 4096;  // largest reassembled IPv4 payload (per slot)
+		size_t flight_recorder_frames = 32;   // last frames kept for pcap dumps, power of two (0 = off)
+		size_t flight_recorder_snap_bytes = 128; // bytes kept per frame (headers; up to frame_buffer_bytes)
+		size_t flow_bindings = 8;             // per-flow datagram receivers (bind_flow)
+		size_t flow_cache_entries = 0;        // flow -> binding cache, power of two (0 = off), 24 bytes each;
+		                                      // only pays off with many bindings and at least as many
+		                                      // entries as flows in flight (benchmarks/flow_cache_bench)
+		size_t owned_ranges = 4;              // extra address ranges we answer ARP for (proxy ARP)
+		size_t owned_address_slots = 16;      // extra single addresses: hash slots, power of two or 0,
+		                                      // 8 bytes each, up to 3/4 used
+		size_t owned_macs = 4;                // distinct MACs for those, besides the interface's
+		size_t arp_sweep_in_flight = 32;      // outstanding start_arp_sweep() requests, power of two
+		                                      // or 0 (off), 16 bytes each; bounds the sweep rate
+		                                      // over silent hosts (see start_arp_sweep())
+		size_t interfaces = 1;                // stacks the application instantiates
+
+		// Total static RAM the stack may use; checked by memory_footprint.hpp.
+		size_t ram_budget_bytes = 40 * 1024;
+	};
+
+	constexpr bool is_valid(const MemoryConfig& config) {
+		return config.frame_buffer_bytes >= 60 &&
+			config.frame_buffer_bytes >= config.mtu + 14 &&
+			config.arp_cache_entries > 0 &&
+			std::has_single_bit(config.arp_source_limiter_slots) &&
+			config.coroutine_frames > 0 &&
+			config.log_line_bytes >= 32 &&
+			std::has_single_bit(config.tx_queue_slots) &&
+			config.tx_queue_slot_bytes >= 60 &&
+			config.routes >= 2 &&
+			config.route_next_hops >= 2 &&
+			config.route_direct_bits <= 24 &&
+			std::has_single_bit(config.next_hop_cache_entries) &&
+			config.ipv4_reassembly_bytes >= 8 &&
+			config.ipv4_reassembly_bytes <= 65535 - 20 &&
+			(config.flight_recorder_frames == 0 || std::has_single_bit(config.flight_recorder_frames)) &&
+			config.flight_recorder_snap_bytes >= 14 &&
+			config.flight_recorder_snap_bytes <= 65535 &&
+			config.flow_bindings > 0 &&
+			(config.flow_cache_entries == 0 || (std::has_single_bit(config.flow_cache_entries) && config.flow_cache_entries >= 2)) &&
+			(config.owned_address_slots == 0 || std::has_single_bit(config.owned_address_slots)) &&
+			config.owned_macs < 0xFFFF &&
+			(config.arp_sweep_in_flight == 0 || std::has_single_bit(config.arp_sweep_in_flight)) &&
+			config.arp_sweep_in_flight < 0x8000 &&
+			config.interfaces > 0;
+	}
+
+}
+
+// A port selects its sizes at compile time by defining NET_MEMORY_CONFIG_HEADER
+// (a header declaring a constexpr MemoryConfig) and NET_MEMORY_CONFIG (its name).
+#if defined(NET_MEMORY_CONFIG_HEADER) && defined(NET_MEMORY_CONFIG)
+#include NET_MEMORY_CONFIG_HEADER
+namespace net {
+	inline constexpr MemoryConfig k_memory_config = NET_MEMORY_CONFIG;
+}
+#else
+namespace net {
+	inline constexpr MemoryConfig k_memory_config{};
+}
+#endif
+
+static_assert(net::is_valid(net::k_memory_config), "Invalid net::MemoryConfig");
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef NET_STACK_MEMORY_FOOTPRINT_H
+#define NET_STACK_MEMORY_FOOTPRINT_H
+
+#include <cstddef>
+#include "memory_config.hpp"
+#include "network_stack.hpp"
+#include "coroutine.hpp"
+
+namespace net {
+
+	// Static RAM used by the stack for a given HAL, computed at compile time.
+	// The object sizes follow k_memory_config, so everything is read from it;
+	// per-interface objects are counted k_memory_config.interfaces times.
+	struct MemoryFootprint {
+		size_t stack_bytes = 0;          // one BasicNetworkStack (frame buffer, ARP cache, ...)
+		size_t arp_cache_bytes = 0;      // of which the ARP cache
+		size_t tx_queue_bytes = 0;       // of which the cross-thread TX queue
+		size_t routing_bytes = 0;        // of which the routing table and next-hop cache
+		size_t reassembly_bytes = 0;     // of which the IPv4 reassembly slots
+		size_t flight_recorder_bytes = 0; // of which the flight recorder ring
+		size_t flow_table_bytes = 0;     // of which the flow bindings and flow cache
+		size_t owned_addresses_bytes = 0; // of which the owned (proxy-ARP) address table
+		size_t arp_sweep_bytes = 0;      // of which the ARP sweep window
+		size_t hal_bytes = 0;            // one HAL object
+		size_t coroutine_pool_bytes = 0; // shared Task frame pool
+		size_t log_line_bytes = 0;       // hal_log() buffer, on the caller's stack
+		size_t interfaces = 0;
+
+		constexpr size_t total() const {
+			return interfaces * (stack_bytes + hal_bytes) + coroutine_pool_bytes + log_line_bytes;
+		}
+	};
+
+	template <NetworkHal Hal>
+	constexpr MemoryFootprint memory_footprint() {
+		MemoryFootprint footprint;
+		footprint.stack_bytes = sizeof(BasicNetworkStack<Hal>);
+		footprint.arp_cache_bytes = sizeof(ArpCache);
+		footprint.tx_queue_bytes = sizeof(typename BasicNetworkStack<Hal>::TxQueue);
+		footprint.routing_bytes = sizeof(typename BasicNetworkStack<Hal>::RoutingTable) +
+			sizeof(NextHopCache<k_memory_config.next_hop_cache_entries>);
+		footprint.reassembly_bytes = sizeof(Ipv4Reassembler);
+		footprint.flight_recorder_bytes = sizeof(typename BasicNetworkStack<Hal>::Recorder);
+		footprint.flow_table_bytes = sizeof(typename BasicNetworkStack<Hal>::FlowTable);
+		footprint.owned_addresses_bytes = sizeof(typename BasicNetworkStack<Hal>::OwnedAddresses);
+		footprint.arp_sweep_bytes = sizeof(typename BasicNetworkStack<Hal>::ArpSweep);
+		footprint.hal_bytes = sizeof(Hal);
+		footprint.coroutine_pool_bytes = TaskFramePool::BLOCK_COUNT * (TaskFramePool::BLOCK_SIZE + sizeof(bool));
+		footprint.log_line_bytes = k_memory_config.log_line_bytes;
+		footprint.interfaces = k_memory_config.interfaces;
+		return footprint;
+	}
+
+	// Fails the build if the configured sizes do not fit the RAM budget.
+	template <NetworkHal Hal>
+	constexpr bool fits_memory_budget() {
+		return memory_footprint<Hal>().total() <= k_memory_config.ram_budget_bytes;
+	}
+
+}
+
+#endif
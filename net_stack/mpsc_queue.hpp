@@ -0,0 +1,107 @@
+#ifndef NET_STACK_MPSC_QUEUE_H
+#define NET_STACK_MPSC_QUEUE_H
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace net {
+
+	// Bounded multi-producer / single-consumer queue (Vyukov's sequence-number
+	// ring). Producers claim a slot with one CAS on the tail and publish it by
+	// bumping the slot's sequence; the consumer never writes shared counters
+	// other than the slot it releases. No locks, no allocation.
+	//
+	// Elements are filled and consumed in place through callbacks, so a
+	// 1.5 KB frame is copied once on the way in and once on the way out.
+	template <typename T, size_t Capacity>
+	class MpscQueue {
+		static_assert(std::has_single_bit(Capacity), "MpscQueue capacity must be a power of two");
+		static_assert(std::atomic<size_t>::is_always_lock_free);
+
+	public:
+		MpscQueue() {
+			for (size_t i = 0; i < Capacity; ++i) {
+				m_cells[i].sequence.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		MpscQueue(const MpscQueue&) = delete;
+		MpscQueue& operator=(const MpscQueue&) = delete;
+
+		// Any thread. Calls fill(T&) on a free slot and publishes it.
+		// Returns false (without calling fill) if the queue is full.
+		template <typename Fill>
+		bool try_push(Fill&& fill) {
+			size_t pos = m_tail.load(std::memory_order_relaxed);
+			Cell* cell;
+			while (true) {
+				cell = &m_cells[pos & MASK];
+				const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+				const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+				if (diff == 0) {
+					if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+						break;
+					}
+				}
+				else if (diff < 0) {
+					return false; // the consumer has not released this slot yet: full
+				}
+				else {
+					pos = m_tail.load(std::memory_order_relaxed);
+				}
+			}
+			fill(cell->value);
+			cell->sequence.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Consumer thread only. Calls consume(T&) on the oldest element.
+		// Returns false if the queue is empty (or the oldest slot is still being filled).
+		template <typename Consume>
+		bool try_pop(Consume&& consume) {
+			const size_t head = m_head.load(std::memory_order_relaxed);
+			Cell& cell = m_cells[head & MASK];
+			if (cell.sequence.load(std::memory_order_acquire) != head + 1) {
+				return false;
+			}
+			consume(cell.value);
+			cell.sequence.store(head + Capacity, std::memory_order_release);
+			m_head.store(head + 1, std::memory_order_relaxed);
+			return true;
+		}
+
+		// Consumer thread only: true if try_pop() would succeed.
+		bool ready() const {
+			const size_t head = m_head.load(std::memory_order_relaxed);
+			return m_cells[head & MASK].sequence.load(std::memory_order_acquire) == head + 1;
+		}
+
+		// Any thread; only a snapshot while producers are active.
+		size_t size_approx() const {
+			const size_t tail = m_tail.load(std::memory_order_relaxed);
+			const size_t head = m_head.load(std::memory_order_relaxed);
+			return tail >= head ? tail - head : 0;
+		}
+
+		static constexpr size_t capacity() { return Capacity; }
+
+	private:
+		static constexpr size_t MASK = Capacity - 1;
+		static constexpr size_t CACHE_LINE = 64;
+
+		struct Cell {
+			std::atomic<size_t> sequence;
+			T value;
+		};
+
+		std::array<Cell, Capacity> m_cells;
+		alignas(CACHE_LINE) std::atomic<size_t> m_tail{ 0 };
+		alignas(CACHE_LINE) std::atomic<size_t> m_head{ 0 }; // written by the consumer only
+	};
+
+}
+
+#endif
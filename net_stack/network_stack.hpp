@@ -4,46 +4,460 @@
 #include <array>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <optional>
 #include <span>
 #include "hal/hal_network.hpp"
+#include "hal/default_hal.hpp"
 #include "protocols/ethernet.hpp"
 #include "protocols/arp.hpp"
 #include "arp_cache.hpp"
+#include "arp_snapshot.hpp"
+#include "arp_sweep.hpp"
+#include "ipv4_input.hpp"
+#include "coroutine.hpp"
+#include "flight_recorder.hpp"
+#include "flow_table.hpp"
+#include "latency_stats.hpp"
+#include "memory_config.hpp"
+#include "mpsc_queue.hpp"
+#include "next_hop_cache.hpp"
+#include "owned_addresses.hpp"
+#include "routing_table.hpp"
+#include <atomic>
 
 
 
 namespace net {
 
-	class NetworkStack {
+	// Adaptive run mode for run_once(): keep polling the HAL while frames keep
+	// arriving, and park in HAL::wait() once nothing has arrived for
+	// 'idle_spin_us'. 0 parks as soon as a poll finds nothing (no spinning).
+	struct BusyPollPolicy {
+		uint32_t idle_spin_us = 0;
+	};
+
+	// Warm start from an ArpCache snapshot (see attach_arp_snapshot()).
+	struct ArpSnapshotOptions {
+		uint32_t save_interval_ms = 30'000;   // rewrite the snapshot this often (from poll())
+		bool probe_all = false;               // probe every restored entry right away (paced by
+		                                      // ArpPolicy::probe_rate_per_sec), not on first use
+		bool announce = true;                 // broadcast a gratuitous ARP for our address
+	};
+
+	// Counters for tuning idle_spin_us.
+	struct RunLoopStats {
+		uint64_t polls = 0;          // run_once() iterations
+		uint64_t busy_polls = 0;     // polls that found work
+		uint64_t idle_spins = 0;     // empty polls spent spinning
+		uint64_t parks = 0;          // times we blocked in HAL::wait()
+		uint64_t park_wakeups = 0;   // parks ended by an arriving frame (vs. a timer)
+		uint64_t frames = 0;
+		uint64_t spin_us = 0;        // time spent polling (busy + idle)
+		uint64_t parked_us = 0;      // time spent blocked
+	};
+
+	// A send handed to the poll thread by another thread (see submit_frame()).
+	struct TxRequest {
+		enum class Kind : uint8_t { FRAME, ARP_REQUEST };
+
+		Kind kind = Kind::FRAME;
+		uint16_t length = 0;
+		std::array<uint8_t, IPV4_ADDRESS_LENGTH> target_ip{};
+		std::array<std::byte, k_memory_config.tx_queue_slot_bytes> frame;
+	};
+
+	enum class TxSubmitResult {
+		QUEUED,
+		QUEUE_FULL,   // backpressure: retry later or drop
+		TOO_LARGE,    // frame exceeds MemoryConfig::tx_queue_slot_bytes
+	};
+
+	struct TxQueueStats {
+		uint64_t submitted = 0;
+		uint64_t rejected_full = 0;
+		uint64_t rejected_too_large = 0;
+		uint64_t sent = 0;
+		uint64_t send_errors = 0;
+		uint64_t drain_batches = 0;   // poll() calls that found queued work
+	};
+
+	// One stack instance per interface. The HAL is a template policy (see the
+	// NetworkHal concept) held by reference, so send/receive are statically
+	// dispatched and inlined when the HAL defines them inline. Definitions are
+	// in network_stack_impl.hpp; the default HAL is instantiated once in
+	// network_stack.cpp.
+	template <NetworkHal Hal>
+	class BasicNetworkStack {
 	public:
-		explicit NetworkStack(const NetworkConfig* config);
+		// Timeout value meaning "wait until the event happens".
+		static constexpr uint32_t WAIT_FOREVER = UINT32_MAX;
+
+		// Awaitable returned by resolve(). Completes with the MAC address, or
+		// std::nullopt if no reply arrived before the timeout. An ARP request is
+		// sent on suspension and retransmitted every ARP_RETRY_INTERVAL_MS.
+		class ResolveAwaiter : private AwaitNode {
+		public:
+			ResolveAwaiter(BasicNetworkStack& stack, const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& ip, uint32_t timeout_ms,
+				bool routable = true);
+			ResolveAwaiter(const ResolveAwaiter&) = delete;
+			ResolveAwaiter& operator=(const ResolveAwaiter&) = delete;
+			~ResolveAwaiter();
+
+			bool await_ready();
+			void await_suspend(std::coroutine_handle<> handle);
+			std::optional<std::array<uint8_t, MAC_ADDRESS_LENGTH>> await_resume();
+
+		private:
+			friend class BasicNetworkStack;
+			enum class State { IDLE, WAITING, READY };
+
+			BasicNetworkStack& m_stack;
+			std::array<uint8_t, IPV4_ADDRESS_LENGTH> m_ip;
+			uint32_t m_timeout_ms;
+			uint32_t m_deadline_ms = 0;
+			uint32_t m_last_request_ms = 0;
+			bool m_routable;
+			State m_state = State::IDLE;
+			std::optional<std::array<uint8_t, MAC_ADDRESS_LENGTH>> m_result;
+		};
+
+		// Awaitable returned by next_frame(). Completes with a view of the next
+		// received frame (valid until the coroutine suspends again), or an
+		// empty span on timeout.
+		class FrameAwaiter : private AwaitNode {
+		public:
+			FrameAwaiter(BasicNetworkStack& stack, uint32_t timeout_ms);
+			FrameAwaiter(const FrameAwaiter&) = delete;
+			FrameAwaiter& operator=(const FrameAwaiter&) = delete;
+			~FrameAwaiter();
+
+			bool await_ready() const { return false; }
+			void await_suspend(std::coroutine_handle<> handle);
+			std::span<const std::byte> await_resume();
+
+		private:
+			friend class BasicNetworkStack;
+			enum class State { IDLE, WAITING, READY };
+
+			BasicNetworkStack& m_stack;
+			uint32_t m_timeout_ms;
+			uint32_t m_deadline_ms = 0;
+			State m_state = State::IDLE;
+			std::span<const std::byte> m_frame;
+		};
+
+		using TxQueue = MpscQueue<TxRequest, k_memory_config.tx_queue_slots>;
+		using RoutingTable = BasicRoutingTable<RoutingTableLimits{
+			.routes = k_memory_config.routes,
+			.nodes = k_memory_config.route_trie_nodes,
+			.leaves = k_memory_config.route_trie_leaves,
+			.next_hops = k_memory_config.route_next_hops,
+			.direct_bits = static_cast<unsigned>(k_memory_config.route_direct_bits) }>;
+		using Recorder = FlightRecorder<k_memory_config.flight_recorder_frames,
+			k_memory_config.flight_recorder_snap_bytes>;
+		using OwnedAddresses = BasicOwnedAddressTable<OwnedAddressLimits{
+			.ranges = k_memory_config.owned_ranges,
+			.address_slots = k_memory_config.owned_address_slots,
+			.macs = k_memory_config.owned_macs }>;
+		using ArpSweep = net::ArpSweep<k_memory_config.arp_sweep_in_flight>;
+
+		BasicNetworkStack(Hal& hal, const NetworkConfig* config);
 
 		/*Main processing loop*/
-		void poll();
+		// Returns the number of frames received in this call.
+		size_t poll();
+
+		// One iteration of the adaptive run loop: poll(), then either return
+		// straight away (traffic seen within the spin window) or park in the
+		// HAL until a frame arrives or the next timer is due.
+		// Returns the number of frames received.
+		size_t run_once();
+
+		void set_busy_poll_policy(const BusyPollPolicy& policy) { m_busy_poll = policy; }
+		const BusyPollPolicy& get_busy_poll_policy() const { return m_busy_poll; }
+		const RunLoopStats& get_run_stats() const { return m_run_stats; }
+
+		/*Sends ARP request; returns the HAL's send() result*/
+		int send_arp_request_for_gateway();
+		int send_arp_request(const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& target_ip);
+
+		// Resolves 'count' consecutive addresses from 'first' (256 from x.y.z.0
+		// sweeps a /24): requests are pipelined at options.rate_per_sec with
+		// at most options.max_in_flight outstanding, and poll() reports every
+		// address once to 'receiver', as soon as it answers or when its last
+		// retry times out. One sweep at a time, independent of the ArpCache:
+		// answers are not learned (entries already cached are refreshed).
+		// Silent addresses hold a window slot for timeout_ms * (retries + 1),
+		// so a mostly empty range goes at about arp_sweep_in_flight / that
+		// many addresses per second: with the default 32-slot window, 200 ms
+		// and 1 retry, some 80/s, a /16 in about 14 minutes. Sweeping a /16
+		// in seconds takes a window of thousands (benchmarks/large_memory.hpp
+		// uses 4096). False if a sweep is running or the range is invalid.
+		bool start_arp_sweep(const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& first, uint32_t count,
+			const ArpSweepOptions& options, ArpSweepReceiver receiver, void* context);
+		void cancel_arp_sweep() { m_arp_sweep.cancel(); }
+		bool arp_sweep_active() const { return m_arp_sweep.active(); }
+		bool arp_sweep_outstanding(const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& ip) const {
+			return m_arp_sweep.outstanding(RoutingTable::to_u32(ip));
+		}
+		const ArpSweepStats& get_arp_sweep_stats() const { return m_arp_sweep.get_stats(); }
+
+		// Warm start: restores the ArpCache image in 'region' (e.g. a file
+		// mapped with hal_persist_map(), arp_snapshot_bytes(arp_cache_entries)
+		// long) as tentative entries, usable at once and confirmed with
+		// unicast probes, announces our address, and from then on saves the
+		// cache there every save_interval_ms. A blank region is a cold start.
+		// The region must stay mapped while attached.
+		ArpSnapshotLoad attach_arp_snapshot(std::span<std::byte> region, const ArpSnapshotOptions& options = {});
+
+		// Saves the cache into the attached region now (e.g. before a shutdown).
+		void save_arp_snapshot();
+
+		// Broadcasts a request for our own address, so neighbours holding it
+		// in their caches update them.
+		int send_gratuitous_arp() { return transmit_arp_request(m_config->ipv4_address); }
+
+		// co_await stack.resolve(ip, timeout_ms) -> std::optional<mac>
+		ResolveAwaiter resolve(const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& ip, uint32_t timeout_ms) {
+			return ResolveAwaiter(*this, ip, timeout_ms);
+		}
+
+		// co_await stack.resolve_route(destination, timeout_ms) -> std::optional<mac>
+		// Resolves the next hop the routing table picks for 'destination';
+		// completes at once with std::nullopt if no route matches.
+		ResolveAwaiter resolve_route(const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& destination, uint32_t timeout_ms) {
+			const auto hop = next_hop(destination);
+			return ResolveAwaiter(*this, hop.value_or(destination), timeout_ms, hop.has_value());
+		}
+
+		// co_await stack.next_frame() -> std::span<const std::byte>
+		FrameAwaiter next_frame(uint32_t timeout_ms = WAIT_FOREVER) {
+			return FrameAwaiter(*this, timeout_ms);
+		}
+
+		// Milliseconds until the next timer-driven event (retransmit, timeout,
+		// cache aging). The application can block in the HAL this long.
+		uint32_t ms_until_next_event() const;
 
-		/*Sends ARP request*/
-		void send_arp_request_for_gateway();
+		// Blocks in the HAL until a frame arrives or the next timer is due.
+		void wait_for_event() { m_hal.wait(ms_until_next_event()); }
 
-		// Sends an ARP reply. Called by the ArpCache.
+		// Called by the ARP handler for every sender it sees, so coroutines
+		// waiting in resolve() for that address can be resumed (and a sweep
+		// can report it).
+		void complete_resolution(const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& ip,
+			const std::array<uint8_t, MAC_ADDRESS_LENGTH>& mac);
+
+		// Sends a complete Ethernet frame. With a non-empty 'offload' the frame
+		// may exceed the MTU (GSO) or leave its L4 checksum to the kernel/NIC;
+		// that needs a HAL satisfying OffloadHal with offloads enabled.
+		// Returns 0 on success, like HAL::send().
+		int send_frame(std::span<const std::byte> frame, const PacketOffload& offload = {});
+
+		// --- Thread-safe submission ---
+		// Everything else on the stack belongs to the poll thread. These may be
+		// called from any thread: the request is copied into a lock-free queue
+		// and sent by the next poll(), in a batch with other queued sends. If
+		// the HAL is a WakeableHal, a parked poll thread is woken up.
+		[[nodiscard]] TxSubmitResult submit_frame(std::span<const std::byte> frame);
+		[[nodiscard]] TxSubmitResult submit_arp_request(const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& target_ip);
+
+		// Queued sends not yet taken by the poll thread (approximate).
+		size_t tx_queue_depth() const { return m_tx_queue.size_approx(); }
+		TxQueueStats get_tx_queue_stats() const; // poll thread
+
+		// Offload metadata of the frame being processed; gso != NONE marks a
+		// GRO super-frame carrying several segments. Empty for other HALs.
+		PacketOffload current_frame_offload() const;
+
+		// Sends an ARP reply from our address. Called by the ArpCache.
 		void send_arp_reply(const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& target_ip,
-			const std::array<uint8_t, MAC_ADDRESS_LENGTH>& target_mac);
+			const std::array<uint8_t, MAC_ADDRESS_LENGTH>& target_mac) {
+			send_arp_reply(target_ip, target_mac, m_config->ipv4_address, m_config->mac_address);
+		}
+
+		// Sends an ARP reply saying 'sender_ip' is at 'sender_mac' (an owned address).
+		void send_arp_reply(const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& target_ip,
+			const std::array<uint8_t, MAC_ADDRESS_LENGTH>& target_mac,
+			const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& sender_ip,
+			const std::array<uint8_t, MAC_ADDRESS_LENGTH>& sender_mac);
+
+		// Addresses we answer ARP for besides config->ipv4_address (virtual
+		// IPs, subnets, proxy-ARP ranges), each with the MAC to answer with.
+		OwnedAddresses& get_owned_addresses() { return m_owned_addresses; }
+
+		// MAC to answer an ARP request for 'ip' with, or nullptr if not ours.
+		// Called by the ARP handler for every packet.
+		const std::array<uint8_t, MAC_ADDRESS_LENGTH>* owner_mac(const uint8_t (&ip)[IPV4_ADDRESS_LENGTH]) const {
+			if (std::memcmp(ip, m_config->ipv4_address.data(), IPV4_ADDRESS_LENGTH) == 0) {
+				return &m_config->mac_address;
+			}
+			if (m_owned_addresses.empty()) {
+				return nullptr;
+			}
+			return m_owned_addresses.find((uint32_t{ ip[0] } << 24) | (uint32_t{ ip[1] } << 16) |
+				(uint32_t{ ip[2] } << 8) | ip[3]);
+		}
 
 		// Getter for our configuration.
 		const NetworkConfig* get_config() const { return m_config; }
 
+		Hal& get_hal() { return m_hal; }
+
 		bool is_gateway_mac_known() ;
 
+		// Routes start as the connected subnet (ipv4_address/subnet_mask) plus
+		// a default route via gateway_address; add static routes here.
+		RoutingTable& get_routing_table() { return m_routing_table; }
+
+		// Where to send a frame for 'destination': the destination itself if
+		// on-link, else its gateway. Memoised per destination.
+		std::optional<std::array<uint8_t, IPV4_ADDRESS_LENGTH>> next_hop(const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& destination);
+
+		// MAC address to put in a frame for 'destination', if the next hop is
+		// already in the ARP cache. Never sends anything (see resolve_route()).
+		std::optional<std::array<uint8_t, MAC_ADDRESS_LENGTH>> next_hop_mac(const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& destination);
+
+		const NextHopCacheStats& get_next_hop_cache_stats() const { return m_next_hop_cache.get_stats(); }
+
+		// Receives complete IPv4 datagrams for us (reassembled if they came in
+		// fragments). The payload is only valid during the call.
+		using DatagramReceiver = void (*)(void* context, const Ipv4Datagram& datagram);
+		void set_datagram_receiver(DatagramReceiver receiver, void* context) {
+			m_datagram_receiver = receiver;
+			m_datagram_context = context;
+		}
+
+		// Per-flow receivers (e.g. one per UDP port). A datagram goes to the
+		// most specific matching binding, else to the receiver above. Repeat
+		// flows are answered from the flow cache without searching the bindings.
+		struct DatagramTarget {
+			DatagramReceiver receiver = nullptr;
+			void* context = nullptr;
+		};
+		using FlowTable = net::FlowTable<DatagramTarget, k_memory_config.flow_bindings,
+			k_memory_config.flow_cache_entries>;
+
+		// False if all k_memory_config.flow_bindings are taken or 'receiver' is null.
+		bool bind_flow(const FlowMatch& match, DatagramReceiver receiver, void* context) {
+			if (receiver == nullptr) {
+				return false;
+			}
+			return m_flow_table.bind(match, DatagramTarget{ receiver, context });
+		}
+		bool unbind_flow(const FlowMatch& match) { return m_flow_table.unbind(match); }
+		const FlowTableStats& get_flow_stats() const { return m_flow_table.get_stats(); }
+
+		// Called by the IPv4 handler.
+		void deliver_datagram(const Ipv4Datagram& datagram) {
+			if (const DatagramTarget* target = m_flow_table.classify(make_flow_key(datagram))) {
+				target->receiver(target->context, datagram);
+			}
+			else if (m_datagram_receiver != nullptr) {
+				m_datagram_receiver(m_datagram_context, datagram);
+			}
+		}
+
+		Ipv4Input& get_ipv4_input() { return m_ipv4_input; }
+
 		ArpCache& get_arp_cache() ;
 
+		// Frames dropped because no protocol handler is registered for their EtherType.
+		uint32_t get_unknown_ethertype_drops() const { return m_unknown_ethertype_drops; }
+
+		// Kernel/NIC arrival stamp of the frame currently being processed.
+		// All zeros if the HAL does not timestamp or timestamping is off.
+		const FrameTimestamp& current_frame_timestamp() const { return m_rx_timestamp; }
+
+		// Arrival stamp -> start of protocol processing, per received frame.
+		const LatencyStats& get_rx_latency() const { return m_rx_latency; }
+
+		// send() call -> kernel/NIC transmit stamp, per completed frame.
+		const LatencyStats& get_tx_latency() const { return m_tx_latency; }
+
+		// The last frames received and sent. Its write_pcapng() may be called
+		// from any thread or a signal handler (see hal/hal_dump.hpp).
+		const Recorder& get_flight_recorder() const { return m_flight_recorder; }
+
 	private:
 		void process_incoming_frame(std::span<const std::byte> frame);
-	
-		std::array<std::byte, 1514> m_packet_buffer;
+		void deliver_frame_to_waiters(std::span<const std::byte> frame);
+		void service_waiters(uint32_t current_time_ms);
+		void service_arp_sweep(uint32_t current_time_ms);
+		void service_arp_probes(uint32_t current_time_ms);
+		// Broadcast, or unicast to 'unicast_mac' (a probe of a cached entry).
+		int transmit_arp_request(const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& target_ip,
+			const std::array<uint8_t, MAC_ADDRESS_LENGTH>* unicast_mac = nullptr);
+		void drain_tx_completions();
+		void drain_tx_queue();
+		void record_frame(FrameDirection direction, std::span<const std::byte> frame);
+		typename NextHopCache<k_memory_config.next_hop_cache_entries>::Entry* route_entry(
+			const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& destination);
+		template <typename Fill>
+		TxSubmitResult submit(Fill&& fill);
+
+		static constexpr uint32_t PERIODIC_INTERVAL_MS = 2000;
+		static constexpr uint32_t ARP_RETRY_INTERVAL_MS = 1000;
+		static constexpr uint32_t ARP_PROBE_PACING_MS = 10;
+		static constexpr uint32_t RECORD_CLOCK_FRAMES = 16;   // see record_frame()
+
+		std::array<std::byte, k_memory_config.frame_buffer_bytes> m_packet_buffer;
+		Hal& m_hal;
 		const NetworkConfig* m_config;
 		uint32_t m_last_periodic_ms = 0;
+		uint32_t m_unknown_ethertype_drops = 0;
 		ArpCache m_arp_cache;
+		std::span<std::byte> m_arp_snapshot;
+		ArpSnapshotOptions m_arp_snapshot_options;
+		uint32_t m_last_snapshot_ms = 0;
+		OwnedAddresses m_owned_addresses;
+		RoutingTable m_routing_table;
+		NextHopCache<k_memory_config.next_hop_cache_entries> m_next_hop_cache;
+		Ipv4Input m_ipv4_input;
+		DatagramReceiver m_datagram_receiver = nullptr;
+		void* m_datagram_context = nullptr;
+		FlowTable m_flow_table;
+		ArpSweep m_arp_sweep;
+		ArpSweepReceiver m_sweep_receiver = nullptr;
+		void* m_sweep_context = nullptr;
+
+		// Timestamping (only fed when Hal satisfies TimestampingHal).
+		FrameTimestamp m_rx_timestamp;
+		LatencyStats m_rx_latency;
+		LatencyStats m_tx_latency;
+
+		Recorder m_flight_recorder;
+		uint64_t m_batch_record_us = 0;   // recorder timestamp of the current poll() batch
+		uint32_t m_batch_record_frames = 0;   // frames recorded with it
+		uint64_t m_record_stamp_offset_us = 0;   // HAL stamp clock minus hal_timer_get_us()
+
+		BusyPollPolicy m_busy_poll;
+		RunLoopStats m_run_stats;
+		uint64_t m_last_activity_us = 0;
+
+		// Cross-thread TX. Producer-side counters are atomic; the rest is
+		// updated by the poll thread only.
+		TxQueue m_tx_queue;
+		std::atomic<bool> m_tx_wake_pending{ false };
+		std::atomic<uint64_t> m_tx_submitted{ 0 };
+		std::atomic<uint64_t> m_tx_rejected_full{ 0 };
+		std::atomic<uint64_t> m_tx_rejected_too_large{ 0 };
+		uint64_t m_tx_sent = 0;
+		uint64_t m_tx_send_errors = 0;
+		uint64_t m_tx_drain_batches = 0;
+
+		// Coroutines suspended on stack events (intrusive lists, no allocation).
+		CoroutineScheduler m_scheduler;
+		AwaitNode* m_resolve_waiters = nullptr;
+		AwaitNode* m_frame_waiters = nullptr;
 	};
 
+	// The stack on this platform's default HAL (hal/default_hal.hpp).
+	using NetworkStack = BasicNetworkStack<DefaultNetworkHal>;
+
+	extern template class BasicNetworkStack<DefaultNetworkHal>;
+
 }
 
 #endif
\ No newline at end of file
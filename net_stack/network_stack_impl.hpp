@@ -0,0 +1,790 @@
+#ifndef NET_STACK_NETWORK_STACK_IMPL_H
+#define NET_STACK_NETWORK_STACK_IMPL_H
+
+// Member definitions of BasicNetworkStack<Hal>. Include this (instead of just
+// network_stack.hpp) to instantiate the stack on a HAL other than the default.
+
+#include "network_stack.hpp"
+#include "hal/hal_timer.hpp"
+#include "hal/hal_logging.hpp"
+#include "protocols/arp.hpp"
+#include "protocols/ethernet.hpp"
+#include "byte_order.hpp"
+#include "protocol_dispatch.hpp"
+#include "protocol_handlers.hpp"
+#include "cstring"
+#include <algorithm>
+#include <bit>
+#include <span>
+namespace net {
+
+    // Every protocol the stack understands is registered here, once.
+    // The dispatch table is generated at compile time from this list.
+    template <NetworkHal Hal>
+    using StackProtocols = ProtocolDispatcher<BasicNetworkStack<Hal>,
+        ArpHandler, Ipv4Handler>;
+
+    template <NetworkHal Hal>
+    BasicNetworkStack<Hal>::BasicNetworkStack(Hal& hal, const NetworkConfig* config)
+        : m_hal(hal), m_config(config) {
+        m_owned_addresses.set_interface_mac(config->mac_address);
+        // Connected subnet, plus the default route if there is a gateway.
+        const uint32_t mask = RoutingTable::to_u32(config->subnet_mask);
+        const uint32_t subnet = RoutingTable::to_u32(config->ipv4_address) & mask;
+        (void)m_routing_table.add(Route{ RoutingTable::to_bytes(subnet),
+            static_cast<uint8_t>(std::countl_one(mask)), {} });
+        if (RoutingTable::to_u32(config->gateway_address) != 0) {
+            (void)m_routing_table.add(Route{ {}, 0, config->gateway_address });
+        }
+    }
+
+
+
+    template <NetworkHal Hal>
+    size_t BasicNetworkStack<Hal>::poll() {
+        size_t frames = 0;
+
+        // 0. --- QUEUED SENDS FROM OTHER THREADS ---
+        drain_tx_queue();
+
+        // 1. --- RECEIVE ---
+       // Create a view into our buffer.
+        std::span<std::byte> buffer_view(m_packet_buffer);
+
+        // --- THIS IS THE KEY CHANGE ---
+        // We now loop until the driver has no more packets to give us.
+        // This drains the receive queue completely on every poll cycle.
+        while (true) {
+            size_t bytes_received = 0;
+            if constexpr (TimestampingHal<Hal>) {
+                bytes_received = m_hal.receive(buffer_view.data(), buffer_view.size(), m_rx_timestamp);
+            }
+            else {
+                bytes_received = m_hal.receive(buffer_view.data(), buffer_view.size());
+            }
+
+            if (bytes_received > 0) {
+                // If we got a packet, process it immediately.
+                ++frames;
+                NET_LOG_DEBUG(NET, "poll() received a frame of size: %zu ", bytes_received);
+                if constexpr (TimestampingHal<Hal>) {
+                    // A stamp later than now (a HAL stamping on a slightly
+                    // different clock) would wrap; skip the sample.
+                    const uint64_t now_ns = m_hal.timestamp_now_ns();
+                    if (m_rx_timestamp.software_ns != 0 && m_rx_timestamp.software_ns <= now_ns) {
+                        uint64_t delay_ns = now_ns - m_rx_timestamp.software_ns;
+                        m_rx_latency.add(delay_ns);
+                        NET_LOG_DEBUG(NET, "RX stamp %llu ns, %llu ns to processing",
+                                      static_cast<unsigned long long>(m_rx_timestamp.software_ns),
+                                      static_cast<unsigned long long>(delay_ns));
+                    }
+                }
+                std::span<const std::byte> frame{ buffer_view.data(), bytes_received };
+                record_frame(FrameDirection::RX, frame);
+                process_incoming_frame(frame);
+
+                // Resume coroutines woken by this frame before the buffer is reused.
+                deliver_frame_to_waiters(frame);
+                m_scheduler.run_ready();
+            }
+            else {
+                // If bytes_received is 0, the driver's buffer is empty.
+                // We can stop trying to receive and break the loop.
+                m_batch_record_us = 0;
+                break;
+            }
+        }
+
+        // 2. --- PERIODIC TASKS ---
+        // Later, this is where we would check timers for DHCP, TCP, etc.
+        uint32_t current_time_ms = hal_timer_get_ms();
+        if (current_time_ms - m_last_periodic_ms > PERIODIC_INTERVAL_MS) {
+            m_arp_cache.age_entries(current_time_ms);
+            m_ipv4_input.expire(current_time_ms);
+            m_last_periodic_ms = current_time_ms;
+            if (!m_arp_snapshot.empty() &&
+                current_time_ms - m_last_snapshot_ms >= m_arp_snapshot_options.save_interval_ms) {
+                save_arp_snapshot();
+            }
+        }
+        service_arp_probes(current_time_ms);
+
+        // 3. --- COROUTINE TIMERS ---
+        service_waiters(current_time_ms);
+        m_scheduler.run_ready();
+
+        // 4. --- ARP SWEEP ---
+        service_arp_sweep(current_time_ms);
+
+        // 5. --- TX TIMESTAMPS ---
+        drain_tx_completions();
+
+        // 6. --- BATCHED SENDS ---
+        // Everything sent during this poll leaves in one submission.
+        if constexpr (BatchingHal<Hal>) {
+            m_hal.flush();
+        }
+
+        return frames;
+    }
+
+
+    template <NetworkHal Hal>
+    size_t BasicNetworkStack<Hal>::run_once() {
+        const uint64_t start_us = hal_timer_get_us();
+        const size_t frames = poll();
+        const uint64_t now_us = hal_timer_get_us();
+
+        ++m_run_stats.polls;
+        m_run_stats.frames += frames;
+        m_run_stats.spin_us += now_us - start_us;
+
+        if (frames > 0) {
+            ++m_run_stats.busy_polls;
+            m_last_activity_us = now_us;
+            return frames;
+        }
+
+        // Nothing arrived: keep spinning until the idle window runs out.
+        if (now_us - m_last_activity_us < m_busy_poll.idle_spin_us) {
+            ++m_run_stats.idle_spins;
+            return 0;
+        }
+
+        ++m_run_stats.parks;
+        const bool woken_by_frame = m_hal.wait(ms_until_next_event());
+        const uint64_t after_us = hal_timer_get_us();
+        m_run_stats.parked_us += after_us - now_us;
+        if (woken_by_frame) {
+            // Traffic is back: give it a full spin window.
+            ++m_run_stats.park_wakeups;
+            m_last_activity_us = after_us;
+        }
+        return 0;
+    }
+
+
+    template <NetworkHal Hal>
+    int BasicNetworkStack<Hal>::send_frame(std::span<const std::byte> frame, const PacketOffload& offload)
+    {
+        record_frame(FrameDirection::TX, frame);
+        if constexpr (OffloadHal<Hal>) {
+            return m_hal.send(frame.data(), frame.size(), offload);
+        }
+        else {
+            if (offload.gso != PacketOffload::Gso::NONE || offload.needs_checksum) {
+                NET_LOG_ERROR(NET, "HAL has no offload support; frame of %zu bytes not sent", frame.size());
+                return -1;
+            }
+            return m_hal.send(frame.data(), frame.size());
+        }
+    }
+
+
+    template <NetworkHal Hal>
+    PacketOffload BasicNetworkStack<Hal>::current_frame_offload() const
+    {
+        if constexpr (OffloadHal<Hal>) {
+            return m_hal.last_rx_offload();
+        }
+        else {
+            return {};
+        }
+    }
+
+
+    template <NetworkHal Hal>
+    template <typename Fill>
+    TxSubmitResult BasicNetworkStack<Hal>::submit(Fill&& fill)
+    {
+        if (!m_tx_queue.try_push(fill)) {
+            m_tx_rejected_full.fetch_add(1, std::memory_order_relaxed);
+            return TxSubmitResult::QUEUE_FULL;
+        }
+        m_tx_submitted.fetch_add(1, std::memory_order_relaxed);
+
+        // One wake-up per batch: only the producer that sets the flag pays
+        // for the syscall; the poll thread clears it before draining.
+        if constexpr (WakeableHal<Hal>) {
+            if (!m_tx_wake_pending.exchange(true, std::memory_order_acq_rel)) {
+                m_hal.wake();
+            }
+        }
+        return TxSubmitResult::QUEUED;
+    }
+
+
+    template <NetworkHal Hal>
+    TxSubmitResult BasicNetworkStack<Hal>::submit_frame(std::span<const std::byte> frame)
+    {
+        if (frame.size() > k_memory_config.tx_queue_slot_bytes) {
+            m_tx_rejected_too_large.fetch_add(1, std::memory_order_relaxed);
+            return TxSubmitResult::TOO_LARGE;
+        }
+        return submit([frame](TxRequest& request) {
+            request.kind = TxRequest::Kind::FRAME;
+            request.length = static_cast<uint16_t>(frame.size());
+            std::copy(frame.begin(), frame.end(), request.frame.begin());
+        });
+    }
+
+
+    template <NetworkHal Hal>
+    TxSubmitResult BasicNetworkStack<Hal>::submit_arp_request(const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& target_ip)
+    {
+        return submit([&target_ip](TxRequest& request) {
+            request.kind = TxRequest::Kind::ARP_REQUEST;
+            request.length = 0;
+            request.target_ip = target_ip;
+        });
+    }
+
+
+    template <NetworkHal Hal>
+    void BasicNetworkStack<Hal>::drain_tx_queue()
+    {
+        m_tx_wake_pending.store(false, std::memory_order_release);
+        if (!m_tx_queue.ready()) {
+            return;
+        }
+        ++m_tx_drain_batches;
+
+        // Bounded, so a busy producer cannot starve receive processing.
+        for (size_t i = 0; i < TxQueue::capacity(); ++i) {
+            const bool popped = m_tx_queue.try_pop([this](TxRequest& request) {
+                int result = 0;
+                if (request.kind == TxRequest::Kind::ARP_REQUEST) {
+                    result = send_arp_request(request.target_ip);
+                }
+                else {
+                    record_frame(FrameDirection::TX, std::span<const std::byte>(request.frame.data(), request.length));
+                    result = m_hal.send(request.frame.data(), request.length);
+                }
+                if (result == 0) {
+                    ++m_tx_sent;
+                }
+                else {
+                    ++m_tx_send_errors;
+                }
+            });
+            if (!popped) {
+                break;
+            }
+        }
+    }
+
+
+    template <NetworkHal Hal>
+    void BasicNetworkStack<Hal>::record_frame(FrameDirection direction, std::span<const std::byte> frame)
+    {
+        if constexpr (Recorder::enabled) {
+            // Reading the clock costs more than recording, so the frames of a
+            // poll() batch and the replies sent while processing them share a
+            // timestamp, re-read every RECORD_CLOCK_FRAMES received frames so
+            // a batch that never drains does not go stale.
+            uint64_t now_us = 0;
+            if (direction == FrameDirection::RX) {
+                if (m_batch_record_us == 0 || m_batch_record_frames == RECORD_CLOCK_FRAMES) {
+                    m_batch_record_us = hal_timer_get_us();
+                    m_batch_record_frames = 0;
+                    if constexpr (TimestampingHal<Hal>) {
+                        m_record_stamp_offset_us = m_hal.timestamp_now_ns() / 1000 - m_batch_record_us;
+                    }
+                }
+                ++m_batch_record_frames;
+                now_us = m_batch_record_us;
+                if constexpr (TimestampingHal<Hal>) {
+                    // The frame's own arrival stamp, moved onto our clock.
+                    const uint64_t stamp_us = m_rx_timestamp.software_ns / 1000;
+                    if (m_rx_timestamp.software_ns != 0 && stamp_us > m_record_stamp_offset_us) {
+                        now_us = stamp_us - m_record_stamp_offset_us;
+                    }
+                }
+            }
+            else {
+                now_us = m_batch_record_us != 0 ? m_batch_record_us : hal_timer_get_us();
+            }
+            m_flight_recorder.record(direction, frame, now_us);
+        }
+    }
+
+
+    template <NetworkHal Hal>
+    TxQueueStats BasicNetworkStack<Hal>::get_tx_queue_stats() const
+    {
+        TxQueueStats stats;
+        stats.submitted = m_tx_submitted.load(std::memory_order_relaxed);
+        stats.rejected_full = m_tx_rejected_full.load(std::memory_order_relaxed);
+        stats.rejected_too_large = m_tx_rejected_too_large.load(std::memory_order_relaxed);
+        stats.sent = m_tx_sent;
+        stats.send_errors = m_tx_send_errors;
+        stats.drain_batches = m_tx_drain_batches;
+        return stats;
+    }
+
+
+    template <NetworkHal Hal>
+    void BasicNetworkStack<Hal>::drain_tx_completions()
+    {
+        if constexpr (TimestampingHal<Hal>) {
+            TxCompletion completion;
+            while (m_hal.poll_tx_completion(completion)) {
+                if (completion.wire.software_ns == 0 || completion.submitted_ns == 0 ||
+                    completion.wire.software_ns < completion.submitted_ns) {
+                    continue;
+                }
+                uint64_t delay_ns = completion.wire.software_ns - completion.submitted_ns;
+                m_tx_latency.add(delay_ns);
+                NET_LOG_DEBUG(NET, "TX #%u on the wire %llu ns after send()", completion.id,
+                              static_cast<unsigned long long>(delay_ns));
+            }
+        }
+    }
+
+
+    template <NetworkHal Hal>
+    void BasicNetworkStack<Hal>::process_incoming_frame(std::span<const std::byte> frame)
+    {
+        if (frame.size() < sizeof(EthernetHeader))
+        {
+            return; //mallperformed
+        }
+
+        const EthernetHeader* eth_header = reinterpret_cast<const EthernetHeader*>(frame.data());
+        uint16_t ethertype = net_ntohs16(eth_header->ethertype);
+        NET_LOG_DEBUG(NET, "Frame has EtherType 0x%04X", ethertype);
+
+        if (!StackProtocols<Hal>::dispatch(*this, ethertype, frame.subspan(sizeof(EthernetHeader))))
+        {
+            // The single place where frames for unregistered protocols are dropped.
+            ++m_unknown_ethertype_drops;
+        }
+    }
+
+
+
+    // Implementation for the new public function to send an ARP request.
+    template <NetworkHal Hal>
+    int BasicNetworkStack<Hal>::send_arp_request_for_gateway() {
+        return send_arp_request(m_config->gateway_address);
+    }
+
+
+    template <NetworkHal Hal>
+    int BasicNetworkStack<Hal>::send_arp_request(const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& target_ip) {
+        // Remember we asked, so the reply is accepted under UPDATE_ONLY learning.
+        m_arp_cache.mark_pending(target_ip);
+        return transmit_arp_request(target_ip);
+    }
+
+
+    template <NetworkHal Hal>
+    int BasicNetworkStack<Hal>::transmit_arp_request(const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& target_ip,
+        const std::array<uint8_t, MAC_ADDRESS_LENGTH>* unicast_mac) {
+        constexpr size_t packet_size = sizeof(EthernetHeader) + sizeof(ArpPacket);
+        std::array<std::byte, packet_size> buffer;
+
+        EthernetHeader* eth_header = reinterpret_cast<EthernetHeader*>(buffer.data());
+        ArpPacket* arp_packet = reinterpret_cast<ArpPacket*>(buffer.data() + sizeof(EthernetHeader));
+
+        // --- Fill in the Ethernet Header ---
+        if (unicast_mac != nullptr) {
+            memcpy(eth_header->destination_mac, unicast_mac->data(), 6);
+        }
+        else {
+            memset(eth_header->destination_mac, 0xFF, 6);
+        }
+        memcpy(eth_header->source_mac, m_config->mac_address.data(), 6);
+        eth_header->ethertype = net_htons16(ETHERTYPE_ARP);
+
+        // --- Fill in the ARP Packet ---
+        arp_packet->hardware_type = net_htons16(ARP_HW_TYPE_ETHERNET);
+        arp_packet->protocol_type = net_htons16(ETHERTYPE_IPV4);
+        arp_packet->hardware_addr_len = 6;
+        arp_packet->protocol_addr_len = 4;
+        arp_packet->opcode = net_htons16(ARP_OPCODE_REQUEST);
+        memcpy(arp_packet->sender_mac, m_config->mac_address.data(), 6);
+        memcpy(arp_packet->sender_ip, m_config->ipv4_address.data(), 4);
+        if (unicast_mac != nullptr) {
+            memcpy(arp_packet->target_mac, unicast_mac->data(), 6);
+        }
+        else {
+            memset(arp_packet->target_mac, 0x00, 6);
+        }
+        memcpy(arp_packet->target_ip, target_ip.data(), 4);
+
+ 
+
+        NET_LOG_DEBUG(NET, "Sending ARP Request for %d.%d.%d.%d...",
+                      target_ip[0], target_ip[1], target_ip[2], target_ip[3]);
+        record_frame(FrameDirection::TX, buffer);
+        return m_hal.send(buffer.data(), buffer.size());
+    }
+
+
+    template <NetworkHal Hal>
+    void BasicNetworkStack<Hal>::send_arp_reply(const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& target_ip,
+        const std::array<uint8_t, MAC_ADDRESS_LENGTH>& target_mac, const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& sender_ip,
+        const std::array<uint8_t, MAC_ADDRESS_LENGTH>& sender_mac) {
+        constexpr size_t packet_size = sizeof(EthernetHeader) + sizeof(ArpPacket);
+        std::array<std::byte, packet_size> packet_buffer;
+
+        EthernetHeader* eth_header = reinterpret_cast<EthernetHeader*>(packet_buffer.data());
+        ArpPacket* arp_packet = reinterpret_cast<ArpPacket*>(packet_buffer.data() + sizeof(EthernetHeader));
+
+        // Fill Ethernet Header
+        std::memcpy(eth_header->destination_mac, target_mac.data(), MAC_ADDRESS_LENGTH); // Send directly to the requester
+        std::memcpy(eth_header->source_mac, sender_mac.data(), MAC_ADDRESS_LENGTH);
+        eth_header->ethertype = net_htons16(ETHERTYPE_ARP);
+
+        // Fill ARP Packet
+        arp_packet->hardware_type = net_htons16(ARP_HW_TYPE_ETHERNET);
+        arp_packet->protocol_type = net_htons16(ETHERTYPE_IPV4);
+        arp_packet->hardware_addr_len = MAC_ADDRESS_LENGTH;
+        arp_packet->protocol_addr_len = IPV4_ADDRESS_LENGTH;
+        arp_packet->opcode = net_htons16(ARP_OPCODE_REPLY);
+        std::memcpy(arp_packet->sender_mac, sender_mac.data(), MAC_ADDRESS_LENGTH);
+        std::memcpy(arp_packet->sender_ip, sender_ip.data(), IPV4_ADDRESS_LENGTH);
+        std::memcpy(arp_packet->target_mac, target_mac.data(), MAC_ADDRESS_LENGTH);
+        std::memcpy(arp_packet->target_ip, target_ip.data(), IPV4_ADDRESS_LENGTH);
+
+        NET_LOG_DEBUG(NET, "Sending ARP reply...");
+        record_frame(FrameDirection::TX, packet_buffer);
+        m_hal.send(packet_buffer.data(), packet_buffer.size());
+    }
+
+
+    template <NetworkHal Hal>
+    bool BasicNetworkStack<Hal>::start_arp_sweep(const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& first, uint32_t count,
+        const ArpSweepOptions& options, ArpSweepReceiver receiver, void* context) {
+        if (receiver == nullptr || !m_arp_sweep.start(RoutingTable::to_u32(first), count, options)) {
+            return false;
+        }
+        m_sweep_receiver = receiver;
+        m_sweep_context = context;
+        NET_LOG_INFO(NET, "ARP sweep of %u addresses from %d.%d.%d.%d", count, first[0], first[1], first[2], first[3]);
+        return true;
+    }
+
+
+    template <NetworkHal Hal>
+    void BasicNetworkStack<Hal>::service_arp_sweep(uint32_t current_time_ms) {
+        // Bounded: each step takes a window slot, a token or the oldest request.
+        while (true) {
+            const typename ArpSweep::Step step = m_arp_sweep.step(current_time_ms);
+            if (step.kind == ArpSweep::Step::Kind::NONE) {
+                return;
+            }
+            const std::array<uint8_t, IPV4_ADDRESS_LENGTH> ip = RoutingTable::to_bytes(step.address);
+            if (step.kind == ArpSweep::Step::Kind::GIVE_UP) {
+                m_sweep_receiver(m_sweep_context, ArpSweepResult{ ip, std::nullopt, 0 });
+            }
+            else if (ip == m_config->ipv4_address) {
+                // Nobody answers for us: report ourselves straight away.
+                (void)m_arp_sweep.complete(step.address, current_time_ms);
+                m_sweep_receiver(m_sweep_context, ArpSweepResult{ ip, m_config->mac_address, 0 });
+            }
+            else {
+                transmit_arp_request(ip);
+            }
+        }
+    }
+
+
+    template <NetworkHal Hal>
+    ArpSnapshotLoad BasicNetworkStack<Hal>::attach_arp_snapshot(std::span<std::byte> region,
+        const ArpSnapshotOptions& options) {
+        m_arp_snapshot = region;
+        m_arp_snapshot_options = options;
+        m_last_snapshot_ms = hal_timer_get_ms();
+        const ArpSnapshotLoad load = load_arp_snapshot(m_arp_cache, region, hal_timer_get_wall_ms(), options.probe_all);
+        if (options.announce) {
+            send_gratuitous_arp();
+        }
+        return load;
+    }
+
+
+    template <NetworkHal Hal>
+    void BasicNetworkStack<Hal>::save_arp_snapshot() {
+        if (m_arp_snapshot.empty()) {
+            return;
+        }
+        m_last_snapshot_ms = hal_timer_get_ms();
+        const size_t saved = net::save_arp_snapshot(m_arp_cache, m_arp_snapshot, hal_timer_get_wall_ms(), m_last_snapshot_ms);
+        NET_LOG_DEBUG(NET, "ARP snapshot saved: %zu entries", saved);
+        (void)saved;
+    }
+
+
+    template <NetworkHal Hal>
+    void BasicNetworkStack<Hal>::service_arp_probes(uint32_t current_time_ms) {
+        while (const std::optional<ArpEntry> probe = m_arp_cache.next_probe(current_time_ms)) {
+            NET_LOG_DEBUG(NET, "Probing tentative ARP entry %d.%d.%d.%d", probe->ipv4_address[0],
+                          probe->ipv4_address[1], probe->ipv4_address[2], probe->ipv4_address[3]);
+            transmit_arp_request(probe->ipv4_address, &probe->mac_address);
+        }
+    }
+
+
+    template <NetworkHal Hal>
+    bool BasicNetworkStack<Hal>::is_gateway_mac_known()  {
+        // We ask our ARP cache if it has an entry for the gateway's IP.
+        // The lookup function returns a std::optional. If it has a value,
+        // the lookup was successful.
+        auto mac_address_ = m_arp_cache.lookup(m_config->gateway_address);
+
+        if (mac_address_.has_value())
+        {
+            std::array<uint8_t, MAC_ADDRESS_LENGTH> logging = mac_address_.value();
+            NET_LOG_DEBUG(NET, "MAC Address: %x:%x:%x:%x:%x:%x", logging[0], logging[1], logging[2], logging[3], logging[4], logging[5]);
+        }
+
+
+        return mac_address_.has_value();
+    }
+
+    template <NetworkHal Hal>
+    ArpCache& BasicNetworkStack<Hal>::get_arp_cache()  {
+        return m_arp_cache;
+    }
+
+    template <NetworkHal Hal>
+    typename NextHopCache<k_memory_config.next_hop_cache_entries>::Entry* BasicNetworkStack<Hal>::route_entry(
+        const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& destination) {
+        const uint32_t key = RoutingTable::to_u32(destination);
+        auto* entry = m_next_hop_cache.find(key, m_routing_table.generation());
+        if (entry != nullptr) {
+            return entry;
+        }
+        const auto hop = m_routing_table.next_hop(destination);
+        if (!hop.has_value()) {
+            NET_LOG_DEBUG(NET, "No route to %d.%d.%d.%d", destination[0], destination[1], destination[2], destination[3]);
+            return nullptr;
+        }
+        return &m_next_hop_cache.insert(key, m_routing_table.generation(), *hop);
+    }
+
+    template <NetworkHal Hal>
+    std::optional<std::array<uint8_t, IPV4_ADDRESS_LENGTH>> BasicNetworkStack<Hal>::next_hop(
+        const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& destination) {
+        const auto* entry = route_entry(destination);
+        if (entry == nullptr) {
+            return std::nullopt;
+        }
+        return entry->next_hop;
+    }
+
+    template <NetworkHal Hal>
+    std::optional<std::array<uint8_t, MAC_ADDRESS_LENGTH>> BasicNetworkStack<Hal>::next_hop_mac(
+        const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& destination) {
+        auto* entry = route_entry(destination);
+        if (entry == nullptr) {
+            return std::nullopt;
+        }
+        const uint32_t arp_generation = m_arp_cache.generation();
+        if (const auto* mac = m_next_hop_cache.mac(*entry, arp_generation)) {
+            return *mac;
+        }
+        const auto mac = m_arp_cache.lookup(entry->next_hop);
+        if (mac.has_value()) {
+            m_next_hop_cache.set_mac(*entry, arp_generation, *mac);
+        }
+        return mac;
+    }
+
+
+
+    // --- Coroutine support ---
+
+    namespace detail {
+        // Signed difference so the comparisons survive the 32-bit tick wrapping.
+        inline bool time_reached(uint32_t now_ms, uint32_t deadline_ms) {
+            return static_cast<int32_t>(now_ms - deadline_ms) >= 0;
+        }
+    }
+
+    template <NetworkHal Hal>
+    void BasicNetworkStack<Hal>::complete_resolution(const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& ip,
+        const std::array<uint8_t, MAC_ADDRESS_LENGTH>& mac) {
+        AwaitNode** link = &m_resolve_waiters;
+        while (*link != nullptr) {
+            ResolveAwaiter* waiter = static_cast<ResolveAwaiter*>(*link);
+            if (waiter->m_ip == ip) {
+                *link = waiter->next;
+                waiter->m_result = mac;
+                waiter->m_state = ResolveAwaiter::State::READY;
+                m_scheduler.schedule(*waiter);
+            }
+            else {
+                link = &(*link)->next;
+            }
+        }
+
+        if (m_arp_sweep.active()) {
+            if (const auto rtt_ms = m_arp_sweep.complete(RoutingTable::to_u32(ip), hal_timer_get_ms())) {
+                m_sweep_receiver(m_sweep_context, ArpSweepResult{ ip, mac, *rtt_ms });
+            }
+        }
+    }
+
+    template <NetworkHal Hal>
+    void BasicNetworkStack<Hal>::deliver_frame_to_waiters(std::span<const std::byte> frame) {
+        // Detach the whole list first: coroutines that wait again after this
+        // frame must get the next one, not this one a second time.
+        AwaitNode* node = m_frame_waiters;
+        m_frame_waiters = nullptr;
+        while (node != nullptr) {
+            AwaitNode* next = node->next;
+            FrameAwaiter* waiter = static_cast<FrameAwaiter*>(node);
+            waiter->m_frame = frame;
+            waiter->m_state = FrameAwaiter::State::READY;
+            m_scheduler.schedule(*waiter);
+            node = next;
+        }
+    }
+
+    template <NetworkHal Hal>
+    void BasicNetworkStack<Hal>::service_waiters(uint32_t current_time_ms) {
+        AwaitNode** link = &m_resolve_waiters;
+        while (*link != nullptr) {
+            ResolveAwaiter* waiter = static_cast<ResolveAwaiter*>(*link);
+            if (waiter->m_timeout_ms != WAIT_FOREVER && detail::time_reached(current_time_ms, waiter->m_deadline_ms)) {
+                NET_LOG_DEBUG(NET, "resolve() timed out for %d.%d.%d.%d",
+                              waiter->m_ip[0], waiter->m_ip[1], waiter->m_ip[2], waiter->m_ip[3]);
+                *link = waiter->next;
+                waiter->m_state = ResolveAwaiter::State::READY;
+                m_scheduler.schedule(*waiter);
+                continue;
+            }
+            if (detail::time_reached(current_time_ms, waiter->m_last_request_ms + ARP_RETRY_INTERVAL_MS)) {
+                send_arp_request(waiter->m_ip);
+                waiter->m_last_request_ms = current_time_ms;
+            }
+            link = &(*link)->next;
+        }
+
+        link = &m_frame_waiters;
+        while (*link != nullptr) {
+            FrameAwaiter* waiter = static_cast<FrameAwaiter*>(*link);
+            if (waiter->m_timeout_ms != WAIT_FOREVER && detail::time_reached(current_time_ms, waiter->m_deadline_ms)) {
+                *link = waiter->next;
+                waiter->m_state = FrameAwaiter::State::READY;
+                m_scheduler.schedule(*waiter);
+                continue;
+            }
+            link = &(*link)->next;
+        }
+    }
+
+    template <NetworkHal Hal>
+    uint32_t BasicNetworkStack<Hal>::ms_until_next_event() const {
+        const uint32_t now = hal_timer_get_ms();
+        if (m_scheduler.has_ready() || m_tx_queue.ready()) {
+            return 0;
+        }
+
+        auto remaining = [now](uint32_t deadline_ms) -> uint32_t {
+            return detail::time_reached(now, deadline_ms) ? 0u : deadline_ms - now;
+        };
+
+        uint32_t next = remaining(m_last_periodic_ms + PERIODIC_INTERVAL_MS + 1);
+        next = std::min(next, m_arp_sweep.ms_until_next(now));
+        if (m_arp_cache.probes_wanted()) {
+            next = std::min(next, ARP_PROBE_PACING_MS);
+        }
+        for (const AwaitNode* node = m_resolve_waiters; node != nullptr; node = node->next) {
+            const ResolveAwaiter* waiter = static_cast<const ResolveAwaiter*>(node);
+            next = std::min(next, remaining(waiter->m_last_request_ms + ARP_RETRY_INTERVAL_MS));
+            if (waiter->m_timeout_ms != WAIT_FOREVER) {
+                next = std::min(next, remaining(waiter->m_deadline_ms));
+            }
+        }
+        for (const AwaitNode* node = m_frame_waiters; node != nullptr; node = node->next) {
+            const FrameAwaiter* waiter = static_cast<const FrameAwaiter*>(node);
+            if (waiter->m_timeout_ms != WAIT_FOREVER) {
+                next = std::min(next, remaining(waiter->m_deadline_ms));
+            }
+        }
+        return next;
+    }
+
+    template <NetworkHal Hal>
+    BasicNetworkStack<Hal>::ResolveAwaiter::ResolveAwaiter(BasicNetworkStack& stack,
+        const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& ip, uint32_t timeout_ms, bool routable)
+        : m_stack(stack), m_ip(ip), m_timeout_ms(timeout_ms), m_routable(routable) {
+    }
+
+    template <NetworkHal Hal>
+    BasicNetworkStack<Hal>::ResolveAwaiter::~ResolveAwaiter() {
+        // The owning Task was destroyed while we were suspended: unhook.
+        if (m_state == State::WAITING) {
+            unlink_await_node(m_stack.m_resolve_waiters, *this);
+        }
+        else if (m_state == State::READY) {
+            m_stack.m_scheduler.cancel(*this);
+        }
+    }
+
+    template <NetworkHal Hal>
+    bool BasicNetworkStack<Hal>::ResolveAwaiter::await_ready() {
+        // Fast path: already in the cache (or no route), no need to suspend at all.
+        if (!m_routable) {
+            m_result.reset();
+            return true;
+        }
+        m_result = m_stack.m_arp_cache.lookup(m_ip);
+        return m_result.has_value();
+    }
+
+    template <NetworkHal Hal>
+    void BasicNetworkStack<Hal>::ResolveAwaiter::await_suspend(std::coroutine_handle<> handle) {
+        const uint32_t now = hal_timer_get_ms();
+        this->handle = handle;
+        m_deadline_ms = now + m_timeout_ms;
+        m_last_request_ms = now;
+        m_state = State::WAITING;
+        this->next = m_stack.m_resolve_waiters;
+        m_stack.m_resolve_waiters = this;
+        m_stack.send_arp_request(m_ip);
+    }
+
+    template <NetworkHal Hal>
+    std::optional<std::array<uint8_t, MAC_ADDRESS_LENGTH>> BasicNetworkStack<Hal>::ResolveAwaiter::await_resume() {
+        m_state = State::IDLE;
+        return m_result;
+    }
+
+    template <NetworkHal Hal>
+    BasicNetworkStack<Hal>::FrameAwaiter::FrameAwaiter(BasicNetworkStack& stack, uint32_t timeout_ms)
+        : m_stack(stack), m_timeout_ms(timeout_ms) {
+    }
+
+    template <NetworkHal Hal>
+    BasicNetworkStack<Hal>::FrameAwaiter::~FrameAwaiter() {
+        if (m_state == State::WAITING) {
+            unlink_await_node(m_stack.m_frame_waiters, *this);
+        }
+        else if (m_state == State::READY) {
+            m_stack.m_scheduler.cancel(*this);
+        }
+    }
+
+    template <NetworkHal Hal>
+    void BasicNetworkStack<Hal>::FrameAwaiter::await_suspend(std::coroutine_handle<> handle) {
+        this->handle = handle;
+        m_deadline_ms = hal_timer_get_ms() + m_timeout_ms;
+        m_state = State::WAITING;
+        this->next = m_stack.m_frame_waiters;
+        m_stack.m_frame_waiters = this;
+    }
+
+    template <NetworkHal Hal>
+    std::span<const std::byte> BasicNetworkStack<Hal>::FrameAwaiter::await_resume() {
+        m_state = State::IDLE;
+        return m_frame;
+    }
+
+}
+
+#endif
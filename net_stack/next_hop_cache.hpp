@@ -0,0 +1,116 @@
+#ifndef NET_STACK_NEXT_HOP_CACHE_H
+#define NET_STACK_NEXT_HOP_CACHE_H
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#include "protocols/arp.hpp"
+
+namespace net {
+
+	struct NextHopCacheStats {
+		uint64_t hits = 0;         // destination found with a current route
+		uint64_t misses = 0;       // routing table consulted
+		uint64_t mac_hits = 0;     // next hop MAC served without touching the ArpCache
+		uint64_t mac_misses = 0;   // ArpCache consulted (absent, or the cache changed)
+	};
+
+	// Per-destination memo of routing and ARP results: two-way set associative,
+	// indexed by a hash of the destination IP, replacing the less recently used
+	// way. An entry remembers the routing table and ArpCache
+	// generations it was filled under, so a route change or an ARP entry
+	// expiring or changing MAC invalidates it without any bookkeeping.
+	template <size_t Entries>
+	class NextHopCache {
+		static_assert(std::has_single_bit(Entries) && Entries >= 2, "NextHopCache size must be a power of two >= 2");
+
+	public:
+		struct Entry {
+			uint32_t destination = 0;
+			uint32_t route_generation = 0;
+			uint32_t arp_generation = 0;
+			bool valid = false;
+			bool has_mac = false;
+			std::array<uint8_t, IPV4_ADDRESS_LENGTH> next_hop{};
+			std::array<uint8_t, MAC_ADDRESS_LENGTH> mac{};
+		};
+
+		// The entry for 'destination' if it was routed under 'route_generation'.
+		Entry* find(uint32_t destination, uint32_t route_generation) {
+			const size_t set = set_index(destination);
+			for (size_t way = 0; way < WAYS; ++way) {
+				Entry& entry = m_entries[set * WAYS + way];
+				if (entry.valid && entry.destination == destination && entry.route_generation == route_generation) {
+					m_victim[set] = static_cast<uint8_t>(way ^ 1);
+					++m_stats.hits;
+					return &entry;
+				}
+			}
+			++m_stats.misses;
+			return nullptr;
+		}
+
+		Entry& insert(uint32_t destination, uint32_t route_generation,
+			const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& next_hop) {
+			const size_t set = set_index(destination);
+			size_t way = m_victim[set];
+			for (size_t candidate = 0; candidate < WAYS; ++candidate) {
+				const Entry& entry = m_entries[set * WAYS + candidate];
+				if (!entry.valid || entry.destination == destination) {
+					way = candidate;
+					break;
+				}
+			}
+			m_victim[set] = static_cast<uint8_t>(way ^ 1);
+			Entry& entry = m_entries[set * WAYS + way];
+			entry.destination = destination;
+			entry.route_generation = route_generation;
+			entry.valid = true;
+			entry.has_mac = false;
+			entry.next_hop = next_hop;
+			return entry;
+		}
+
+		// The next hop's MAC if it was stored while the ArpCache was at 'arp_generation'.
+		const std::array<uint8_t, MAC_ADDRESS_LENGTH>* mac(const Entry& entry, uint32_t arp_generation) {
+			if (entry.has_mac && entry.arp_generation == arp_generation) {
+				++m_stats.mac_hits;
+				return &entry.mac;
+			}
+			++m_stats.mac_misses;
+			return nullptr;
+		}
+
+		void set_mac(Entry& entry, uint32_t arp_generation, const std::array<uint8_t, MAC_ADDRESS_LENGTH>& mac) {
+			entry.mac = mac;
+			entry.arp_generation = arp_generation;
+			entry.has_mac = true;
+		}
+
+		void clear() {
+			for (Entry& entry : m_entries) {
+				entry.valid = false;
+			}
+		}
+
+		const NextHopCacheStats& get_stats() const { return m_stats; }
+
+	private:
+		static constexpr size_t WAYS = 2;
+		static constexpr size_t SETS = Entries / WAYS;
+
+		static size_t set_index(uint32_t destination) {
+			constexpr int set_bits = std::countr_zero(SETS);
+			return set_bits == 0 ? 0 : (destination * 0x9E3779B1u) >> (32 - set_bits);
+		}
+
+		std::array<Entry, Entries> m_entries{};
+		std::array<uint8_t, SETS> m_victim{};   // way to replace next in each set
+		NextHopCacheStats m_stats;
+	};
+
+}
+
+#endif
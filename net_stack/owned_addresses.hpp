@@ -0,0 +1,228 @@
+#ifndef NET_STACK_OWNED_ADDRESSES_H
+#define NET_STACK_OWNED_ADDRESSES_H
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "protocols/arp.hpp"
+
+namespace net {
+
+	// Capacities of a BasicOwnedAddressTable.
+	struct OwnedAddressLimits {
+		size_t ranges = 4;          // contiguous blocks (subnets, proxy-ARP ranges)
+		size_t address_slots = 16;  // hash slots for single addresses, power of two or 0;
+		                            // at most 3/4 of them are used
+		size_t macs = 4;            // distinct MACs besides the interface's
+	};
+
+	// Addresses the stack answers ARP for besides its own: virtual IPs, whole
+	// subnets, proxy-ARP ranges, each with the MAC to answer with. Single
+	// addresses live in an open-addressing hash (linear probing, kept at most
+	// 3/4 full), so a lookup is one multiply and usually one slot read however
+	// many there are; ranges are a short list checked with one subtract and
+	// compare each. A single address overrides a range covering it. MACs are
+	// stored once and shared by index. 0.0.0.0 cannot be owned.
+	template <OwnedAddressLimits Limits>
+	class BasicOwnedAddressTable {
+		static_assert(Limits.address_slots == 0 || std::has_single_bit(Limits.address_slots),
+			"OwnedAddressTable address_slots must be 0 or a power of two");
+		static_assert(Limits.macs < 0xFFFF, "MAC ids are 16-bit");
+
+	public:
+		using Mac = std::array<uint8_t, MAC_ADDRESS_LENGTH>;
+		using Address = std::array<uint8_t, IPV4_ADDRESS_LENGTH>;
+
+		static constexpr OwnedAddressLimits limits() { return Limits; }
+		static constexpr size_t max_addresses() { return Limits.address_slots / 4 * 3; }
+
+		// MAC for entries added without one (the stack sets its interface MAC).
+		void set_interface_mac(const Mac& mac) { m_macs[0] = mac; }
+
+		// Owns 'address', answered with 'mac' or the interface MAC. Adding an
+		// owned address again changes its MAC. False if the address or MAC
+		// table is full.
+		bool add(const Address& address, const std::optional<Mac>& mac = std::nullopt) {
+			if constexpr (Limits.address_slots == 0) {
+				return false;
+			}
+			else {
+				const uint32_t key = to_u32(address);
+				if (key == 0) {
+					return false;
+				}
+				size_t slot = home_slot(key);
+				while (m_slots[slot].address != 0 && m_slots[slot].address != key) {
+					slot = (slot + 1) & (Limits.address_slots - 1);
+				}
+				const bool existing = m_slots[slot].address == key;
+				if (!existing && m_address_count == max_addresses()) {
+					return false;
+				}
+				const std::optional<uint16_t> id = acquire_mac(mac);
+				if (!id.has_value()) {
+					return false;
+				}
+				if (existing) {
+					release_mac(m_slots[slot].mac);
+				}
+				else {
+					++m_address_count;
+				}
+				m_slots[slot] = { key, *id };
+				return true;
+			}
+		}
+
+		// Returns false if 'address' was not added with add().
+		bool remove(const Address& address) {
+			if constexpr (Limits.address_slots == 0) {
+				return false;
+			}
+			else {
+				const uint32_t key = to_u32(address);
+				constexpr size_t mask = Limits.address_slots - 1;
+				size_t hole = home_slot(key);
+				while (m_slots[hole].address != key) {
+					if (m_slots[hole].address == 0) {
+						return false;
+					}
+					hole = (hole + 1) & mask;
+				}
+				release_mac(m_slots[hole].mac);
+				--m_address_count;
+				// Backward-shift deletion: pull later entries of the probe run
+				// into the hole unless that would move them before their home.
+				for (size_t next = (hole + 1) & mask; m_slots[next].address != 0; next = (next + 1) & mask) {
+					const size_t home = home_slot(m_slots[next].address);
+					if (((next - home) & mask) >= ((next - hole) & mask)) {
+						m_slots[hole] = m_slots[next];
+						hole = next;
+					}
+				}
+				m_slots[hole] = {};
+				return true;
+			}
+		}
+
+		// Owns 'count' consecutive addresses from 'first' (count 256 from
+		// x.y.z.0 is a /24). False if the range table or MAC table is full,
+		// the range is empty or wraps past 255.255.255.255.
+		bool add_range(const Address& first, uint32_t count, const std::optional<Mac>& mac = std::nullopt) {
+			const uint32_t start = to_u32(first);
+			if (count == 0 || start == 0 || count - 1 > UINT32_MAX - start || m_range_count == Limits.ranges) {
+				return false;
+			}
+			const std::optional<uint16_t> id = acquire_mac(mac);
+			if (!id.has_value()) {
+				return false;
+			}
+			m_ranges[m_range_count++] = { start, count, *id };
+			return true;
+		}
+
+		// Removes the range starting at 'first'; false if there is none.
+		bool remove_range(const Address& first) {
+			const uint32_t start = to_u32(first);
+			for (size_t i = 0; i < m_range_count; ++i) {
+				if (m_ranges[i].first == start) {
+					release_mac(m_ranges[i].mac);
+					m_ranges[i] = m_ranges[--m_range_count];
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// The MAC to answer with if 'address' is owned, else nullptr.
+		const Mac* find(uint32_t address) const {
+			if constexpr (Limits.address_slots != 0) {
+				if (m_address_count != 0) {
+					for (size_t slot = home_slot(address);; slot = (slot + 1) & (Limits.address_slots - 1)) {
+						if (m_slots[slot].address == address) {
+							return &m_macs[m_slots[slot].mac];
+						}
+						if (m_slots[slot].address == 0) {
+							break;
+						}
+					}
+				}
+			}
+			for (size_t i = 0; i < m_range_count; ++i) {
+				if (address - m_ranges[i].first < m_ranges[i].count) {
+					return &m_macs[m_ranges[i].mac];
+				}
+			}
+			return nullptr;
+		}
+		const Mac* find(const Address& address) const { return find(to_u32(address)); }
+
+		bool empty() const { return m_address_count == 0 && m_range_count == 0; }
+		size_t address_count() const { return m_address_count; }
+		size_t range_count() const { return m_range_count; }
+
+		static constexpr uint32_t to_u32(const Address& address) {
+			return (uint32_t{ address[0] } << 24) | (uint32_t{ address[1] } << 16) |
+				(uint32_t{ address[2] } << 8) | address[3];
+		}
+
+	private:
+		struct Slot {
+			uint32_t address = 0;   // 0 = free
+			uint16_t mac = 0;
+		};
+
+		struct Range {
+			uint32_t first = 0;
+			uint32_t count = 0;
+			uint16_t mac = 0;
+		};
+
+		static constexpr size_t home_slot(uint32_t address) {
+			constexpr int bits = std::countr_zero(Limits.address_slots);
+			return bits == 0 ? 0 : (address * 0x9E3779B1u) >> (32 - bits);
+		}
+
+		// Id of 'mac' in the MAC table (0 = the interface MAC), adding it if new.
+		std::optional<uint16_t> acquire_mac(const std::optional<Mac>& mac) {
+			if (!mac.has_value()) {
+				return 0;
+			}
+			size_t free_id = 0;
+			for (size_t id = 1; id < m_macs.size(); ++id) {
+				if (m_mac_users[id] != 0 && m_macs[id] == *mac) {
+					++m_mac_users[id];
+					return static_cast<uint16_t>(id);
+				}
+				if (m_mac_users[id] == 0 && free_id == 0) {
+					free_id = id;
+				}
+			}
+			if (free_id == 0) {
+				return std::nullopt;
+			}
+			m_macs[free_id] = *mac;
+			m_mac_users[free_id] = 1;
+			return static_cast<uint16_t>(free_id);
+		}
+
+		void release_mac(uint16_t id) {
+			if (id != 0) {
+				--m_mac_users[id];
+			}
+		}
+
+		std::array<Slot, Limits.address_slots> m_slots{};
+		std::array<Range, Limits.ranges> m_ranges{};
+		std::array<Mac, Limits.macs + 1> m_macs{};          // [0] = interface MAC
+		std::array<uint32_t, Limits.macs + 1> m_mac_users{}; // entries using each MAC
+		size_t m_address_count = 0;
+		size_t m_range_count = 0;
+	};
+
+}
+
+#endif
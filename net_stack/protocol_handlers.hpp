@@ -0,0 +1,68 @@
+#ifndef NET_STACK_PROTOCOL_HANDLERS_H
+#define NET_STACK_PROTOCOL_HANDLERS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+#include "protocols/arp.hpp"
+#include "protocols/ethernet.hpp"
+#include "hal/hal_timer.hpp"
+
+namespace net {
+
+	// Protocol handlers registered with the ProtocolDispatcher in NetworkStack.
+	// Each one owns the parsing for its EtherType and talks to the stack only
+	// through its public interface.
+
+	struct ArpHandler {
+		static constexpr uint16_t ethertype = ETHERTYPE_ARP;
+
+		template <typename Stack>
+		static void handle(Stack& stack, std::span<const std::byte> payload) {
+			if (payload.size() < sizeof(ArpPacket)) {
+				return; // truncated
+			}
+			const ArpPacket* arp_packet = reinterpret_cast<const ArpPacket*>(payload.data());
+
+			std::array<uint8_t, IPV4_ADDRESS_LENGTH> sender_ip;
+			std::array<uint8_t, MAC_ADDRESS_LENGTH> sender_mac;
+			std::memcpy(sender_ip.data(), arp_packet->sender_ip, IPV4_ADDRESS_LENGTH);
+			std::memcpy(sender_mac.data(), arp_packet->sender_mac, MAC_ADDRESS_LENGTH);
+
+			// Ours if it asks for our address or one we own (proxy ARP). The
+			// cache decides what to learn; it tells us whether a reply is due.
+			// Answers to a sweep go to the sweep's receiver, not into the cache.
+			const std::array<uint8_t, MAC_ADDRESS_LENGTH>* owner_mac = stack.owner_mac(arp_packet->target_ip);
+			const bool sweep_reply = stack.arp_sweep_outstanding(sender_ip);
+			if (stack.get_arp_cache().process_arp_packet(*arp_packet, owner_mac != nullptr, !sweep_reply)) {
+				std::array<uint8_t, IPV4_ADDRESS_LENGTH> target_ip;
+				std::memcpy(target_ip.data(), arp_packet->target_ip, IPV4_ADDRESS_LENGTH);
+				stack.send_arp_reply(sender_ip, sender_mac, target_ip, *owner_mac);
+			}
+
+			// Wake any coroutine waiting in resolve() for this sender.
+			stack.complete_resolution(sender_ip, sender_mac);
+		}
+	};
+
+	struct Ipv4Handler {
+		static constexpr uint16_t ethertype = ETHERTYPE_IPV4;
+
+		template <typename Stack>
+		static void handle(Stack& stack, std::span<const std::byte> payload) {
+			// Validation and reassembly live in Ipv4Input; a datagram comes
+			// out once it is complete and addressed to us.
+			auto datagram = stack.get_ipv4_input().process_packet(payload, stack.get_config()->ipv4_address,
+				hal_timer_get_ms());
+			if (datagram.has_value()) {
+				stack.deliver_datagram(*datagram);
+			}
+		}
+	};
+
+}
+
+#endif
@@ -0,0 +1,337 @@
+#ifndef NET_STACK_ROUTING_TABLE_H
+#define NET_STACK_ROUTING_TABLE_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+#include "protocols/arp.hpp"
+
+namespace net {
+
+	// One IPv4 route. A gateway of 0.0.0.0 marks a directly connected
+	// (on-link) prefix: the destination itself is the next hop.
+	struct Route {
+		std::array<uint8_t, IPV4_ADDRESS_LENGTH> prefix{};
+		uint8_t prefix_length = 0;
+		std::array<uint8_t, IPV4_ADDRESS_LENGTH> gateway{};
+	};
+
+	// Capacities of a BasicRoutingTable. The compiled trie needs one node per
+	// 6-bit stride that has longer routes below it and one leaf per run of
+	// identical next hops inside a node; usage is reported after each change.
+	struct RoutingTableLimits {
+		size_t routes = 8;
+		size_t nodes = 16;       // 24 bytes each
+		size_t leaves = 128;     // 2 bytes each
+		size_t next_hops = 8;    // distinct gateways (+ on-link)
+		unsigned direct_bits = 8; // first level: 2^direct_bits entries of 4 bytes
+	};
+
+	// Longest-prefix-match routing table. Routes are kept as a plain list and
+	// compiled into a poptrie (Asai & Ohara, SIGCOMM 2015): a direct-indexed
+	// first level on the top 'direct_bits' of the address, then 64-way nodes
+	// whose children and leaves are packed and found by popcount over a
+	// bitmap. A lookup is one direct read, a node read per 6 further bits that
+	// matter (two for a /24 with the default 8 direct bits) and one leaf read.
+	// Changes recompile the trie; lookups are branch-light and never allocate.
+	template <RoutingTableLimits Limits>
+	class BasicRoutingTable {
+		static_assert(Limits.direct_bits <= 24, "direct_bits must be at most 24");
+		static_assert(Limits.next_hops < 0xFFFF, "next hop ids are 16-bit");
+
+	public:
+		BasicRoutingTable() { m_direct.fill(LEAF | NO_ROUTE); }
+
+		static constexpr RoutingTableLimits limits() { return Limits; }
+
+		// Adds (or replaces the gateway of) a route. Returns false if the
+		// table or the compiled trie would exceed its capacity; the table is
+		// left unchanged then.
+		bool add(const Route& route) {
+			const Entry entry = to_entry(route);
+			for (size_t i = 0; i < m_route_count; ++i) {
+				if (m_routes[i].prefix == entry.prefix && m_routes[i].length == entry.length) {
+					const uint32_t previous = m_routes[i].gateway;
+					m_routes[i].gateway = entry.gateway;
+					if (compile()) return true;
+					m_routes[i].gateway = previous;
+					(void)compile();
+					return false;
+				}
+			}
+			if (m_route_count == Limits.routes) return false;
+			m_routes[m_route_count++] = entry;
+			if (compile()) return true;
+			remove_entry(entry);
+			(void)compile();
+			return false;
+		}
+
+		// Returns false if no such route exists.
+		bool remove(const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& prefix, uint8_t prefix_length) {
+			const Entry entry = to_entry(Route{ prefix, prefix_length, {} });
+			if (!remove_entry(entry)) return false;
+			(void)compile();
+			return true;
+		}
+
+		// Replaces all routes with one compile; for loading large tables.
+		// Of duplicate prefixes the last one wins, as with add().
+		bool assign(std::span<const Route> routes) {
+			if (routes.size() > Limits.routes) return false;
+			m_route_count = 0;
+			for (const Route& route : routes) {
+				Entry entry = to_entry(route);
+				entry.sequence = static_cast<uint32_t>(m_route_count);
+				m_routes[m_route_count++] = entry;
+			}
+			std::sort(m_routes.begin(), m_routes.begin() + m_route_count, [](const Entry& a, const Entry& b) {
+				if (a.prefix != b.prefix) return a.prefix < b.prefix;
+				return a.length != b.length ? a.length < b.length : a.sequence < b.sequence;
+			});
+			size_t kept = 0;
+			for (size_t i = 0; i < m_route_count; ++i) {
+				if (i + 1 < m_route_count && m_routes[i + 1].prefix == m_routes[i].prefix &&
+					m_routes[i + 1].length == m_routes[i].length) {
+					continue;
+				}
+				m_routes[kept++] = m_routes[i];
+			}
+			m_route_count = kept;
+			if (compile()) return true;
+			clear();
+			return false;
+		}
+
+		void clear() {
+			m_route_count = 0;
+			(void)compile();
+		}
+
+		// IP address to ARP for to reach 'destination' (the destination itself
+		// when on-link, else the gateway), or std::nullopt if no route matches.
+		std::optional<std::array<uint8_t, IPV4_ADDRESS_LENGTH>> next_hop(
+			const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& destination) const {
+			const uint32_t address = to_u32(destination);
+			const uint16_t hop = lookup(address);
+			if (hop == NO_ROUTE) return std::nullopt;
+			const uint32_t gateway = m_next_hops[hop - 1];
+			return to_bytes(gateway == 0 ? address : gateway);
+		}
+
+		// Next-hop id for a host-order address: 0 = no route, else 1 + index
+		// into next_hop_address().
+		uint16_t lookup(uint32_t address) const {
+			uint32_t entry = m_direct[direct_index(address)];
+			unsigned offset = Limits.direct_bits;
+			while ((entry & LEAF) == 0) {
+				const Node& node = m_nodes[entry];
+				const uint64_t bit = uint64_t{ 1 } << stride_index(address, offset);
+				if (node.children & bit) {
+					entry = node.child_base + static_cast<uint32_t>(std::popcount(node.children & (bit - 1)));
+					offset += STRIDE;
+					continue;
+				}
+				return m_leaves[node.leaf_base + static_cast<uint32_t>(std::popcount(node.leaf_runs & ((bit << 1) - 1))) - 1];
+			}
+			return static_cast<uint16_t>(entry);
+		}
+
+		uint32_t next_hop_address(uint16_t hop) const { return m_next_hops[hop - 1]; }
+
+		// Bumped on every change; caches keyed on routes compare it.
+		uint32_t generation() const { return m_generation; }
+		size_t route_count() const { return m_route_count; }
+		size_t node_count() const { return m_node_count; }
+		size_t leaf_count() const { return m_leaf_count; }
+		size_t next_hop_count() const { return m_next_hop_count; }
+
+		// Bytes of the compiled trie actually in use (direct level, nodes, leaves).
+		size_t compiled_bytes() const {
+			return sizeof(m_direct) + m_node_count * sizeof(Node) + m_leaf_count * sizeof(uint16_t);
+		}
+
+		static uint32_t to_u32(const std::array<uint8_t, IPV4_ADDRESS_LENGTH>& ip) {
+			return (uint32_t{ ip[0] } << 24) | (uint32_t{ ip[1] } << 16) | (uint32_t{ ip[2] } << 8) | ip[3];
+		}
+
+		static std::array<uint8_t, IPV4_ADDRESS_LENGTH> to_bytes(uint32_t address) {
+			return { static_cast<uint8_t>(address >> 24), static_cast<uint8_t>(address >> 16),
+				static_cast<uint8_t>(address >> 8), static_cast<uint8_t>(address) };
+		}
+
+	private:
+		static constexpr unsigned STRIDE = 6;
+		static constexpr uint32_t LEAF = 0x80000000u;   // direct entry holds a next-hop id
+		static constexpr uint16_t NO_ROUTE = 0;
+		static constexpr size_t DIRECT_SIZE = size_t{ 1 } << Limits.direct_bits;
+
+		struct Entry {
+			uint32_t prefix = 0;
+			uint32_t gateway = 0;
+			uint8_t length = 0;
+			uint16_t hop = NO_ROUTE;   // assigned by compile()
+			uint32_t sequence = 0;     // input order, to resolve duplicates in assign()
+		};
+
+		struct Node {
+			uint64_t children = 0;    // slots that continue in a child node
+			uint64_t leaf_runs = 0;   // leaf slots that start a new run of next hops
+			uint32_t child_base = 0;  // children are contiguous in m_nodes
+			uint32_t leaf_base = 0;   // leaf runs are contiguous in m_leaves
+		};
+
+		static uint32_t mask(uint8_t length) { return length == 0 ? 0 : ~uint32_t{ 0 } << (32 - length); }
+
+		static Entry to_entry(const Route& route) {
+			const uint8_t length = std::min<uint8_t>(route.prefix_length, 32);
+			return Entry{ to_u32(route.prefix) & mask(length), to_u32(route.gateway), length, NO_ROUTE, 0 };
+		}
+
+		static size_t direct_index(uint32_t address) {
+			if constexpr (Limits.direct_bits == 0) return 0;
+			else return address >> (32 - Limits.direct_bits);
+		}
+
+		// The 6 address bits starting 'offset' bits from the top (zero past bit 31).
+		static unsigned stride_index(uint32_t address, unsigned offset) {
+			return static_cast<unsigned>(((uint64_t{ address } << 32) >> (64 - STRIDE - offset)) & 63u);
+		}
+
+		bool remove_entry(const Entry& entry) {
+			for (size_t i = 0; i < m_route_count; ++i) {
+				if (m_routes[i].prefix == entry.prefix && m_routes[i].length == entry.length) {
+					m_routes[i] = m_routes[--m_route_count];
+					return true;
+				}
+			}
+			return false;
+		}
+
+		uint16_t intern_next_hop(uint32_t gateway) {
+			for (size_t i = 0; i < m_next_hop_count; ++i) {
+				if (m_next_hops[i] == gateway) return static_cast<uint16_t>(i + 1);
+			}
+			if (m_next_hop_count == Limits.next_hops) return NO_ROUTE;
+			m_next_hops[m_next_hop_count++] = gateway;
+			return static_cast<uint16_t>(m_next_hop_count);
+		}
+
+		// Rebuilds the trie from m_routes. Sorted by (prefix, length), every
+		// route comes after all shorter routes containing it, so expanding
+		// them in order leaves the longest match in each slot.
+		bool compile() {
+			++m_generation;
+			m_node_count = 0;
+			m_leaf_count = 0;
+			m_next_hop_count = 0;
+			m_direct.fill(LEAF | NO_ROUTE);
+
+			std::sort(m_routes.begin(), m_routes.begin() + m_route_count, [](const Entry& a, const Entry& b) {
+				return a.prefix != b.prefix ? a.prefix < b.prefix : a.length < b.length;
+			});
+
+			for (size_t i = 0; i < m_route_count; ++i) {
+				m_routes[i].hop = intern_next_hop(m_routes[i].gateway);
+				if (m_routes[i].hop == NO_ROUTE) return false;
+				if (m_routes[i].length <= Limits.direct_bits) {
+					const size_t first = direct_index(m_routes[i].prefix);
+					const size_t count = size_t{ 1 } << (Limits.direct_bits - m_routes[i].length);
+					std::fill_n(m_direct.begin() + first, count, LEAF | m_routes[i].hop);
+				}
+			}
+
+			// Longer routes falling into the same direct slot are contiguous.
+			size_t i = 0;
+			while (i < m_route_count) {
+				if (m_routes[i].length <= Limits.direct_bits) { ++i; continue; }
+				const size_t slot = direct_index(m_routes[i].prefix);
+				size_t end = i + 1;
+				while (end < m_route_count && direct_index(m_routes[end].prefix) == slot) ++end;
+
+				if (m_node_count == Limits.nodes) return false;
+				const uint32_t node = static_cast<uint32_t>(m_node_count++);
+				const uint16_t inherited = static_cast<uint16_t>(m_direct[slot] & ~LEAF);
+				if (!build_node(node, Limits.direct_bits, inherited, i, end)) return false;
+				m_direct[slot] = node;
+				i = end;
+			}
+			return true;
+		}
+
+		// Fills node 'index' covering 'offset'..offset+5 from routes [first, end),
+		// all sharing the node's prefix. Routes not longer than 'offset' are
+		// already folded into 'inherited'.
+		bool build_node(uint32_t index, unsigned offset, uint16_t inherited, size_t first, size_t end) {
+			std::array<uint16_t, 64> slots;
+			slots.fill(inherited);
+			uint64_t children = 0;
+			for (size_t i = first; i < end; ++i) {
+				const Entry& route = m_routes[i];
+				if (route.length <= offset) continue;
+				const unsigned slot = stride_index(route.prefix, offset);
+				if (route.length <= offset + STRIDE) {
+					std::fill_n(slots.begin() + slot, size_t{ 1 } << (offset + STRIDE - route.length), route.hop);
+				}
+				else {
+					children |= uint64_t{ 1 } << slot;
+				}
+			}
+
+			Node node;
+			node.children = children;
+			node.child_base = static_cast<uint32_t>(m_node_count);
+			node.leaf_base = static_cast<uint32_t>(m_leaf_count);
+			if (m_node_count + static_cast<size_t>(std::popcount(children)) > Limits.nodes) return false;
+			m_node_count += static_cast<size_t>(std::popcount(children));
+
+			bool have_previous = false;
+			uint16_t previous = NO_ROUTE;
+			for (unsigned slot = 0; slot < 64; ++slot) {
+				if (children & (uint64_t{ 1 } << slot)) continue;
+				if (!have_previous || slots[slot] != previous) {
+					if (m_leaf_count == Limits.leaves) return false;
+					m_leaves[m_leaf_count++] = slots[slot];
+					node.leaf_runs |= uint64_t{ 1 } << slot;
+					previous = slots[slot];
+					have_previous = true;
+				}
+			}
+			m_nodes[index] = node;
+
+			// Children, in slot order, over their contiguous sub-ranges.
+			uint32_t child = node.child_base;
+			size_t i = first;
+			while (i < end) {
+				const unsigned slot = stride_index(m_routes[i].prefix, offset);
+				size_t sub_end = i + 1;
+				while (sub_end < end && stride_index(m_routes[sub_end].prefix, offset) == slot) ++sub_end;
+				if (children & (uint64_t{ 1 } << slot)) {
+					if (!build_node(child++, offset + STRIDE, slots[slot], i, sub_end)) return false;
+				}
+				i = sub_end;
+			}
+			return true;
+		}
+
+		std::array<Entry, Limits.routes> m_routes{};
+		size_t m_route_count = 0;
+		std::array<uint32_t, Limits.next_hops> m_next_hops{};
+		size_t m_next_hop_count = 0;
+
+		std::array<uint32_t, DIRECT_SIZE> m_direct{};
+		std::array<Node, Limits.nodes> m_nodes{};
+		std::array<uint16_t, Limits.leaves> m_leaves{};
+		size_t m_node_count = 0;
+		size_t m_leaf_count = 0;
+		uint32_t m_generation = 0;
+	};
+
+}
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef NET_STACK_TOKEN_BUCKET_H
+#define NET_STACK_TOKEN_BUCKET_H
+
+#include <cstdint>
+
+namespace net {
+
+	// Classic token bucket on the millisecond tick: 'rate_per_sec' tokens are
+	// added per second up to 'burst'. Tokens are kept in thousandths so
+	// sub-token refills between closely spaced calls are not lost.
+	// A rate of 0 disables the limit (try_consume() always succeeds).
+	class TokenBucket {
+	public:
+		constexpr TokenBucket() = default;
+		constexpr TokenBucket(uint32_t rate_per_sec, uint32_t burst) { configure(rate_per_sec, burst); }
+
+		// Sets the limits and refills the bucket.
+		constexpr void configure(uint32_t rate_per_sec, uint32_t burst) {
+			m_rate_per_sec = rate_per_sec;
+			m_capacity_milli = static_cast<uint64_t>(burst) * 1000u;
+			m_tokens_milli = m_capacity_milli;
+			m_primed = false;
+		}
+
+		// Takes one token if available.
+		bool try_consume(uint32_t now_ms) {
+			if (m_rate_per_sec == 0) {
+				return true;
+			}
+			refill(now_ms);
+			if (m_tokens_milli >= 1000u) {
+				m_tokens_milli -= 1000u;
+				return true;
+			}
+			return false;
+		}
+
+		bool unlimited() const { return m_rate_per_sec == 0; }
+
+	private:
+		void refill(uint32_t now_ms) {
+			if (!m_primed) {
+				m_last_ms = now_ms;
+				m_primed = true;
+				return;
+			}
+			const uint32_t elapsed_ms = now_ms - m_last_ms; // wraps correctly
+			m_last_ms = now_ms;
+			// rate (tokens/s) * ms = milli-tokens
+			const uint64_t added = static_cast<uint64_t>(elapsed_ms) * m_rate_per_sec;
+			m_tokens_milli = (m_capacity_milli - m_tokens_milli <= added) ? m_capacity_milli : m_tokens_milli + added;
+		}
+
+		uint32_t m_rate_per_sec = 0;
+		uint32_t m_last_ms = 0;
+		uint64_t m_capacity_milli = 0;
+		uint64_t m_tokens_milli = 0;
+		bool m_primed = false;
+	};
+
+}
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef PROTOCOLS_IPV4_H
+#define PROTOCOLS_IPV4_H
+
+#include <cstddef>
+#include <cstdint>
+
+#pragma pack(push, 1)
+struct Ipv4Header {
+    uint8_t version_ihl;            // version (4) in the high nibble, header length in 32-bit words in the low
+    uint8_t type_of_service;
+    uint16_t total_length;          // header + payload, network order
+    uint16_t identification;
+    uint16_t flags_fragment_offset; // flags in the top 3 bits, offset in 8-byte units
+    uint8_t ttl;
+    uint8_t protocol;
+    uint16_t header_checksum;
+    uint8_t source_ip[4];
+    uint8_t destination_ip[4];
+};
+#pragma pack(pop)
+
+// Options (IHL > 5) follow the fixed part.
+static_assert(sizeof(Ipv4Header) == 20, "Ipv4Header size must be 20 bytes");
+
+// IPv4 constants (host order; hton when writing to the wire)
+constexpr uint8_t IPV4_VERSION = 4;
+constexpr size_t IPV4_MIN_HEADER_LENGTH = 20;
+constexpr size_t IPV4_MAX_PACKET_LENGTH = 65535;
+constexpr uint16_t IPV4_FLAG_DONT_FRAGMENT = 0x4000;
+constexpr uint16_t IPV4_FLAG_MORE_FRAGMENTS = 0x2000;
+constexpr uint16_t IPV4_FRAGMENT_OFFSET_MASK = 0x1FFF;  // in 8-byte units
+
+constexpr uint8_t IPV4_PROTOCOL_ICMP = 1;
+constexpr uint8_t IPV4_PROTOCOL_TCP = 6;
+constexpr uint8_t IPV4_PROTOCOL_UDP = 17;
+
+#endif // PROTOCOLS_IPV4_H